@@ -41,13 +41,21 @@ namespace {
 
 GURL GetDefaultWidgetEntryPage(
     scoped_refptr<xwalk::application::ApplicationData> data) {
+  const std::vector<std::string>& defaultWidgetEntryPages =
+      application::WGTPackage::GetDefaultWidgetEntryPages();
+  if (data->archive()) {
+    for (const std::string& page : defaultWidgetEntryPages) {
+      if (data->archive()->FindEntry(page))
+        return data->GetResourceURL(page);
+    }
+    return GURL();
+  }
+
   base::ThreadRestrictions::SetIOAllowed(true);
   base::FileEnumerator iter(
       data->path(), true,
       base::FileEnumerator::FILES,
       FILE_PATH_LITERAL("index.*"));
-  const std::vector<std::string>& defaultWidgetEntryPages =
-      application::WGTPackage::GetDefaultWidgetEntryPages();
   size_t priority = defaultWidgetEntryPages.size();
   std::string source;
 
@@ -9,23 +9,33 @@
 #include <map>
 #include <list>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "base/files/file_path.h"
+#include "base/macros.h"
 #include "base/memory/weak_ptr.h"
 #include "base/numerics/safe_math.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/string_util.h"
+#include "base/synchronization/lock.h"
+#include "base/task_runner_util.h"
 #include "base/threading/thread_restrictions.h"
+#include "base/threading/thread_task_runner_handle.h"
 #include "base/threading/worker_pool.h"
 #include "base/threading/sequenced_worker_pool.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/resource_request_info.h"
 #include "url/url_util.h"
+#include "net/base/io_buffer.h"
+#include "net/base/mime_util.h"
 #include "net/base/net_errors.h"
+#include "net/http/http_byte_range.h"
+#include "net/http/http_request_headers.h"
 #include "net/http/http_response_headers.h"
 #include "net/http/http_response_info.h"
+#include "net/http/http_util.h"
 #include "net/url_request/url_request_error_job.h"
 #include "net/url_request/url_request_file_job.h"
 #include "net/url_request/url_request_simple_job.h"
@@ -34,8 +44,10 @@
 #include "xwalk/application/common/application_file_util.h"
 #include "xwalk/application/common/application_manifest_constants.h"
 #include "xwalk/application/common/application_resource.h"
+#include "xwalk/application/common/application_resource_index.h"
 #include "xwalk/application/common/constants.h"
 #include "xwalk/application/common/manifest_handlers/csp_handler.h"
+#include "xwalk/application/common/package/package_archive.h"
 #include "xwalk/runtime/common/xwalk_system_locale.h"
 
 using content::BrowserThread;
@@ -49,40 +61,102 @@ namespace application {
 
 namespace {
 
-net::HttpResponseHeaders* BuildHttpHeaders(
-    const std::string& content_security_policy,
-    const std::string& mime_type, const std::string& method,
+const char kSpace[] = " ";
+const char kSemicolon[] = ";";
+
+enum ResponseStatus {
+  RESPONSE_OK,
+  RESPONSE_BAD_REQUEST,
+  RESPONSE_NOT_FOUND,
+  RESPONSE_NOT_IMPLEMENTED,
+  RESPONSE_STATUS_COUNT,
+};
+
+const char* const kStatusLines[] = {
+  "HTTP/1.1 200 OK",
+  "HTTP/1.1 400 Bad Request",
+  "HTTP/1.1 404 Not Found",
+  "HTTP/1.1 501 Not Implemented",
+};
+static_assert(arraysize(kStatusLines) == RESPONSE_STATUS_COUNT,
+              "kStatusLines doesn't match ResponseStatus");
+
+ResponseStatus GetResponseStatus(
+    const std::string& method,
     const base::FilePath& file_path, const base::FilePath& relative_path) {
-  std::string raw_headers;
-  if (method == "GET") {
-    if (relative_path.empty())
-      raw_headers.append("HTTP/1.1 400 Bad Request");
-    else if (file_path.empty())
-      raw_headers.append("HTTP/1.1 404 Not Found");
-    else
-      raw_headers.append("HTTP/1.1 200 OK");
-  } else {
-    raw_headers.append("HTTP/1.1 501 Not Implemented");
+  if (method != "GET")
+    return RESPONSE_NOT_IMPLEMENTED;
+  if (relative_path.empty())
+    return RESPONSE_BAD_REQUEST;
+  if (file_path.empty())
+    return RESPONSE_NOT_FOUND;
+  return RESPONSE_OK;
+}
+
+// The response headers of one application. The CSP and CORS headers are
+// serialized once at launch, and the parsed headers are built on first use
+// then shared by every response with the same status and MIME type, so
+// they must never be modified.
+class ApplicationResponseHeaders
+    : public base::RefCountedThreadSafe<ApplicationResponseHeaders> {
+ public:
+  explicit ApplicationResponseHeaders(const ApplicationData& application) {
+    std::string content_security_policy;
+    const CSPInfo* csp_info = static_cast<CSPInfo*>(
+        application.GetManifestData(GetCSPKey(application.manifest_type())));
+    if (csp_info) {
+      for (auto& directive : csp_info->GetDirectives()) {
+        content_security_policy.append(directive.first)
+            .append(kSpace)
+            .append(base::JoinString(directive.second, kSpace))
+            .append(kSemicolon);
+      }
+    }
+
+    if (!content_security_policy.empty()) {
+      common_headers_.append(1, '\0');
+      common_headers_.append("Content-Security-Policy: ");
+      common_headers_.append(content_security_policy);
+    }
+
+    common_headers_.append(1, '\0');
+    common_headers_.append("Access-Control-Allow-Origin: *");
   }
 
-  if (!content_security_policy.empty()) {
-    raw_headers.append(1, '\0');
-    raw_headers.append("Content-Security-Policy: ");
-    raw_headers.append(content_security_policy);
+  scoped_refptr<net::HttpResponseHeaders> Get(ResponseStatus status,
+                                              const std::string& mime_type) {
+    base::AutoLock lock(lock_);
+    scoped_refptr<net::HttpResponseHeaders>& headers =
+        headers_[status][mime_type];
+    if (headers.get())
+      return headers;
+
+    std::string raw_headers(kStatusLines[status]);
+    raw_headers.append(common_headers_);
+    if (!mime_type.empty()) {
+      raw_headers.append(1, '\0');
+      raw_headers.append("Content-Type: ");
+      raw_headers.append(mime_type);
+    }
+    raw_headers.append(2, '\0');
+    headers = new net::HttpResponseHeaders(raw_headers);
+    return headers;
   }
 
-  raw_headers.append(1, '\0');
-  raw_headers.append("Access-Control-Allow-Origin: *");
+ private:
+  friend class base::RefCountedThreadSafe<ApplicationResponseHeaders>;
+  ~ApplicationResponseHeaders() {}
 
-  if (!mime_type.empty()) {
-    raw_headers.append(1, '\0');
-    raw_headers.append("Content-Type: ");
-    raw_headers.append(mime_type);
-  }
+  // Everything but the status line and the Content-Type, '\0' separated.
+  std::string common_headers_;
 
-  raw_headers.append(2, '\0');
-  return new net::HttpResponseHeaders(raw_headers);
-}
+  base::Lock lock_;
+  // Keyed by MIME type.
+  std::unordered_map<std::string, scoped_refptr<net::HttpResponseHeaders>>
+      headers_[RESPONSE_STATUS_COUNT];
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationResponseHeaders);
+};
 
 void ReadResourceFilePath(
     const ApplicationResource& resource,
@@ -99,28 +173,46 @@ class URLRequestApplicationJob : public net::URLRequestFileJob {
       const std::string& application_id,
       const base::FilePath& directory_path,
       const base::FilePath& relative_path,
-      const std::string& content_security_policy,
-      const std::list<std::string>& locales)
+      scoped_refptr<ApplicationResponseHeaders> response_headers,
+      const std::list<std::string>& locales,
+      scoped_refptr<ApplicationResourceIndex> resource_index)
       : net::URLRequestFileJob(
           request, network_delegate, base::FilePath(), file_task_runner),
-        content_security_policy_(content_security_policy),
+        response_headers_(response_headers),
         locales_(locales),
         resource_(application_id, directory_path, relative_path),
         relative_path_(relative_path),
+        resource_index_(resource_index),
         weak_factory_(this) {
   }
 
   void GetResponseInfo(net::HttpResponseInfo* info) override {
     std::string mime_type;
     GetMimeType(&mime_type);
-    std::string method = request()->method();
-    response_info_.headers = BuildHttpHeaders(
-        content_security_policy_, mime_type, method, file_path_,
-        relative_path_);
+    response_info_.headers = response_headers_->Get(
+        GetResponseStatus(request()->method(), file_path_, relative_path_),
+        mime_type);
     *info = response_info_;
   }
 
   void Start() override {
+    // Once the application is indexed, resources are resolved right away on
+    // the IO thread.
+    if (resource_index_.get()) {
+      file_path_ = resource_index_->GetFilePath(relative_path_, locales_);
+      if (!file_path_.empty()) {
+        URLRequestFileJob::Start();
+        return;
+      }
+      // Headers can't be notified from Start().
+      base::ThreadTaskRunnerHandle::Get()->PostTask(
+          FROM_HERE,
+          base::Bind(&URLRequestApplicationJob::OnFilePathRead,
+                     weak_factory_.GetWeakPtr(),
+                     base::Owned(new base::FilePath)));
+      return;
+    }
+
     base::FilePath* read_file_path = new base::FilePath;
 
     resource_.SetLocales(locales_);
@@ -138,10 +230,11 @@ class URLRequestApplicationJob : public net::URLRequestFileJob {
  protected:
   ~URLRequestApplicationJob() override {}
 
-  std::string content_security_policy_;
+  scoped_refptr<ApplicationResponseHeaders> response_headers_;
   std::list<std::string> locales_;
   ApplicationResource resource_;
   base::FilePath relative_path_;
+  scoped_refptr<ApplicationResourceIndex> resource_index_;
 
  private:
   void OnFilePathRead(base::FilePath* read_file_path) {
@@ -156,6 +249,203 @@ class URLRequestApplicationJob : public net::URLRequestFileJob {
   base::WeakPtrFactory<URLRequestApplicationJob> weak_factory_;
 };
 
+const base::FilePath::CharType kWGTLocaleDirectory[] =
+    FILE_PATH_LITERAL("locales");
+
+// The entry of a PACKAGE_ARCHIVE application resource, resolved the same
+// way as ApplicationResource::GetFilePath() does for files.
+struct ArchiveResource {
+  ArchiveResource() : entry(NULL) {}
+
+  const PackageArchive::Entry* entry;
+  std::string mime_type;
+};
+
+void FindArchiveResource(
+    const PackageArchive* archive,
+    const base::FilePath& relative_path,
+    const std::list<std::string>& locales,
+    ArchiveResource* resource) {
+  if (relative_path.empty())
+    return;
+
+  for (const std::string& locale : locales) {
+    resource->entry = archive->FindEntry(
+        base::FilePath(kWGTLocaleDirectory).AppendASCII(locale)
+        .Append(relative_path));
+    if (resource->entry)
+      break;
+  }
+  if (!resource->entry)
+    resource->entry = archive->FindEntry(relative_path);
+  if (resource->entry)
+    net::GetMimeTypeFromFile(relative_path, &resource->mime_type);
+}
+
+// Entries can only be read sequentially, so the first |skip| bytes of a
+// range are read into |buffer| and dropped. This keeps the CRC check.
+int ReadArchiveEntry(scoped_refptr<PackageArchive::Reader> reader,
+                     scoped_refptr<net::IOBuffer> buffer, int size,
+                     int64_t skip) {
+  while (skip > 0) {
+    int result = reader->Read(buffer->data(),
+                              static_cast<int>(std::min<int64_t>(skip, size)));
+    if (result <= 0)
+      return -1;
+    skip -= result;
+  }
+  return reader->Read(buffer->data(), size);
+}
+
+// Serves the resources of PACKAGE_ARCHIVE applications, the package is never
+// extracted: entries are read, and inflated if needed, from the mapped
+// archive on |file_task_runner| as the request consumes them. A single byte
+// range is honoured the way URLRequestFileJob does for unpacked
+// applications: only the bytes in the range are sent, with the same headers.
+class URLRequestApplicationArchiveJob : public net::URLRequestJob {
+ public:
+  URLRequestApplicationArchiveJob(
+      net::URLRequest* request,
+      net::NetworkDelegate* network_delegate,
+      const scoped_refptr<base::TaskRunner>& file_task_runner,
+      scoped_refptr<PackageArchive> archive,
+      const base::FilePath& relative_path,
+      scoped_refptr<ApplicationResponseHeaders> response_headers,
+      const std::list<std::string>& locales)
+      : net::URLRequestJob(request, network_delegate),
+        file_task_runner_(file_task_runner),
+        archive_(archive),
+        relative_path_(relative_path),
+        response_headers_(response_headers),
+        locales_(locales),
+        range_parse_result_(net::OK),
+        skip_bytes_(0),
+        remaining_bytes_(0),
+        weak_factory_(this) {
+  }
+
+  void GetResponseInfo(net::HttpResponseInfo* info) override {
+    response_info_.headers = response_headers_->Get(
+        GetResponseStatus(request()->method(),
+                          reader_.get() ? relative_path_ : base::FilePath(),
+                          relative_path_),
+        mime_type_);
+    *info = response_info_;
+  }
+
+  bool GetMimeType(std::string* mime_type) const override {
+    *mime_type = mime_type_;
+    return !mime_type_.empty();
+  }
+
+  void SetExtraRequestHeaders(
+      const net::HttpRequestHeaders& headers) override {
+    std::string range_header;
+    if (!headers.GetHeader(net::HttpRequestHeaders::kRange, &range_header))
+      return;
+    std::vector<net::HttpByteRange> ranges;
+    if (!net::HttpUtil::ParseRangeHeader(range_header, &ranges))
+      return;
+    if (ranges.size() == 1) {
+      byte_range_ = ranges[0];
+    } else {
+      // Multiple ranges would need a multipart response.
+      range_parse_result_ = net::ERR_REQUEST_RANGE_NOT_SATISFIABLE;
+    }
+  }
+
+  void Start() override {
+    // The entries are indexed in memory, so they are looked up right away;
+    // only their data is read on |file_task_runner_|.
+    ArchiveResource resource;
+    FindArchiveResource(archive_.get(), relative_path_, locales_, &resource);
+    mime_type_ = resource.mime_type;
+
+    int result = net::OK;
+    if (resource.entry) {
+      reader_ = new PackageArchive::Reader(archive_, resource.entry);
+      remaining_bytes_ = resource.entry->size;
+      result = range_parse_result_;
+      if (result == net::OK && byte_range_.IsValid()) {
+        if (byte_range_.ComputeBounds(resource.entry->size)) {
+          skip_bytes_ = byte_range_.first_byte_position();
+          remaining_bytes_ = byte_range_.last_byte_position() -
+                             byte_range_.first_byte_position() + 1;
+        } else {
+          result = net::ERR_REQUEST_RANGE_NOT_SATISFIABLE;
+        }
+      }
+      set_expected_content_size(remaining_bytes_);
+    }
+
+    // Headers can't be notified from Start().
+    base::ThreadTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE,
+        base::Bind(&URLRequestApplicationArchiveJob::DidStart,
+                   weak_factory_.GetWeakPtr(), result));
+  }
+
+  void Kill() override {
+    weak_factory_.InvalidateWeakPtrs();
+    net::URLRequestJob::Kill();
+  }
+
+  int ReadRawData(net::IOBuffer* buf, int buf_size) override {
+    if (!reader_.get() || !remaining_bytes_)
+      return 0;
+    if (remaining_bytes_ < buf_size)
+      buf_size = static_cast<int>(remaining_bytes_);
+
+    // The reader keeps the archive mapped until the read is done, even if
+    // the job goes away in the meantime.
+    base::PostTaskAndReplyWithResult(
+        file_task_runner_.get(), FROM_HERE,
+        base::Bind(&ReadArchiveEntry, reader_, make_scoped_refptr(buf),
+                   buf_size, skip_bytes_),
+        base::Bind(&URLRequestApplicationArchiveJob::OnReadComplete,
+                   weak_factory_.GetWeakPtr()));
+    skip_bytes_ = 0;
+    return net::ERR_IO_PENDING;
+  }
+
+ private:
+  ~URLRequestApplicationArchiveJob() override {}
+
+  void DidStart(int result) {
+    if (result != net::OK) {
+      NotifyStartError(
+          net::URLRequestStatus(net::URLRequestStatus::FAILED, result));
+      return;
+    }
+    NotifyHeadersComplete();
+  }
+
+  void OnReadComplete(int result) {
+    if (result < 0) {
+      ReadRawDataComplete(net::ERR_FAILED);
+      return;
+    }
+    remaining_bytes_ -= result;
+    ReadRawDataComplete(result);
+  }
+
+  scoped_refptr<base::TaskRunner> file_task_runner_;
+  scoped_refptr<PackageArchive> archive_;
+  base::FilePath relative_path_;
+  scoped_refptr<ApplicationResponseHeaders> response_headers_;
+  std::list<std::string> locales_;
+
+  scoped_refptr<PackageArchive::Reader> reader_;
+  std::string mime_type_;
+  net::HttpByteRange byte_range_;
+  int range_parse_result_;
+  // Bytes to drop before the first read, and bytes left to send.
+  int64_t skip_bytes_;
+  int64_t remaining_bytes_;
+  net::HttpResponseInfo response_info_;
+  base::WeakPtrFactory<URLRequestApplicationArchiveJob> weak_factory_;
+};
+
 // This class is a thread-safe cache of active application's data.
 // This class is used by ApplicationProtocolHandler which lives on
 // IO thread and hence cannot access ApplicationService directly.
@@ -172,6 +462,25 @@ class ApplicationDataCache : public ApplicationService::Observer {
     return NULL;
   }
 
+  scoped_refptr<ApplicationResponseHeaders> GetResponseHeaders(
+      const std::string& application_id) const {
+    base::AutoLock lock(lock_);
+    auto it = response_headers_.find(application_id);
+    if (it != response_headers_.end())
+      return it->second;
+    return NULL;
+  }
+
+  // Returns NULL until the application is indexed.
+  scoped_refptr<ApplicationResourceIndex> GetResourceIndex(
+      const std::string& application_id) const {
+    base::AutoLock lock(lock_);
+    auto it = resource_indexes_.find(application_id);
+    if (it != resource_indexes_.end())
+      return it->second;
+    return NULL;
+  }
+
   static void CreateIfNeeded(ApplicationService* service) {
     DCHECK(service);
     DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
@@ -188,14 +497,45 @@ class ApplicationDataCache : public ApplicationService::Observer {
 
  private:
   void DidLaunchApplication(Application* app) override {
-    base::AutoLock lock(lock_);
-    cache_.insert(std::pair<std::string, scoped_refptr<ApplicationData> >(
-        app->id(), app->data()));
+    scoped_refptr<ApplicationResponseHeaders> response_headers(
+        new ApplicationResponseHeaders(*app->data()));
+    {
+      base::AutoLock lock(lock_);
+      cache_.insert(std::pair<std::string, scoped_refptr<ApplicationData> >(
+          app->id(), app->data()));
+      response_headers_[app->id()] = response_headers;
+    }
+
+    // Unpacked applications are indexed once, off the UI thread, instead of
+    // probing the disk for every request.
+    if (app->data()->archive() || app->data()->path().empty())
+      return;
+    base::PostTaskAndReplyWithResult(
+        BrowserThread::GetBlockingPool()->GetTaskRunnerWithShutdownBehavior(
+            base::SequencedWorkerPool::SKIP_ON_SHUTDOWN).get(),
+        FROM_HERE,
+        base::Bind(&ApplicationResourceIndex::Create, app->data()->path()),
+        base::Bind(&ApplicationDataCache::OnResourceIndexCreated,
+                   base::Unretained(this), app->data()));
   }
 
   void WillDestroyApplication(Application* app) override {
     base::AutoLock lock(lock_);
     cache_.erase(app->id());
+    response_headers_.erase(app->id());
+    resource_indexes_.erase(app->id());
+  }
+
+  void OnResourceIndexCreated(scoped_refptr<ApplicationData> application,
+                              scoped_refptr<ApplicationResourceIndex> index) {
+    if (!index.get())
+      return;
+    base::AutoLock lock(lock_);
+    // The application may have terminated in the meantime.
+    ApplicationData::ApplicationDataMap::const_iterator it =
+        cache_.find(application->ID());
+    if (it != cache_.end() && it->second.get() == application.get())
+      resource_indexes_[application->ID()] = index;
   }
 
   ApplicationDataCache() = default;
@@ -204,6 +544,10 @@ class ApplicationDataCache : public ApplicationService::Observer {
   ~ApplicationDataCache() override = default;
 
   ApplicationData::ApplicationDataMap cache_;
+  std::map<std::string, scoped_refptr<ApplicationResponseHeaders>>
+      response_headers_;
+  std::map<std::string, scoped_refptr<ApplicationResourceIndex>>
+      resource_indexes_;
   mutable base::Lock lock_;
 
   static ApplicationDataCache* s_instance_;
@@ -244,37 +588,23 @@ void GetUserAgentLocales(const std::string& sys_locale,
   } while (position != std::string::npos);
 }
 
-namespace {
-const char kSpace[] = " ";
-const char kSemicolon[] = ";";
-}  // namespace
-
 net::URLRequestJob*
 ApplicationProtocolHandler::MaybeCreateJob(
     net::URLRequest* request, net::NetworkDelegate* network_delegate) const {
   const std::string& application_id = request->url().host();
   scoped_refptr<ApplicationData> application =
       ApplicationDataCache::Get()->GetApplicationData(application_id);
+  scoped_refptr<ApplicationResponseHeaders> response_headers =
+      ApplicationDataCache::Get()->GetResponseHeaders(application_id);
 
-  if (!application.get())
+  // The application may terminate between both lookups.
+  if (!application.get() || !response_headers.get())
     return new net::URLRequestErrorJob(
         request, network_delegate, net::ERR_FILE_NOT_FOUND);
 
   base::FilePath relative_path =
       ApplicationURLToRelativeFilePath(request->url());
   base::FilePath directory_path = application->path();
-  std::string content_security_policy;
-  const char* csp_key = GetCSPKey(application->manifest_type());
-  const CSPInfo* csp_info =
-      static_cast<CSPInfo*>(application->GetManifestData(csp_key));
-  if (csp_info) {
-    for (auto& directive : csp_info->GetDirectives()) {
-      content_security_policy.append(directive.first)
-          .append(kSpace)
-          .append(base::JoinString(directive.second, kSpace))
-          .append(kSemicolon);
-    }
-  }
 
   std::list<std::string> locales;
   if (application->manifest_type() == Manifest::TYPE_WIDGET) {
@@ -282,6 +612,19 @@ ApplicationProtocolHandler::MaybeCreateJob(
     GetUserAgentLocales(application->GetManifest()->default_locale(), locales);
   }
 
+  if (application->archive()) {
+    return new URLRequestApplicationArchiveJob(
+        request,
+        network_delegate,
+        content::BrowserThread::GetBlockingPool()->
+        GetTaskRunnerWithShutdownBehavior(
+            base::SequencedWorkerPool::SKIP_ON_SHUTDOWN),
+        application->archive(),
+        relative_path,
+        response_headers,
+        locales);
+  }
+
   return new URLRequestApplicationJob(
       request,
       network_delegate,
@@ -291,8 +634,9 @@ ApplicationProtocolHandler::MaybeCreateJob(
       application_id,
       directory_path,
       relative_path,
-      content_security_policy,
-      locales);
+      response_headers,
+      locales,
+      ApplicationDataCache::Get()->GetResourceIndex(application_id));
 }
 
 }  // namespace
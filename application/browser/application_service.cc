@@ -107,27 +107,18 @@ Application* ApplicationService::LaunchFromManifestPath(
 Application* ApplicationService::LaunchFromPackagePath(
     const base::FilePath& path) {
   std::unique_ptr<Package> package = Package::Create(path);
-  if (!package || !package->IsValid()) {
+  if (!package || !package->IsValid() || !package->VerifySignature()) {
     LOG(ERROR) << "Failed to obtain valid package from "
                << path.AsUTF8Unsafe();
     return NULL;
   }
 
-  base::FilePath tmp_dir, target_dir;
-  if (!GetTempDir(&tmp_dir)) {
-    LOG(ERROR) << "Failed to obtain system temp directory.";
-    return NULL;
-  }
-
-#if defined (OS_WIN)
-  base::CreateTemporaryDirInDir(tmp_dir,
-      base::UTF8ToWide(package->name()), &target_dir);
-#else
-  base::CreateTemporaryDirInDir(tmp_dir, package->name(), &target_dir);
-#endif
-  if (!package->ExtractTo(target_dir)) {
-    LOG(ERROR) << "Failed to unpack to a temporary directory: "
-               << target_dir.MaybeAsASCII();
+  // The resources are served straight from the package, see
+  // URLRequestApplicationArchiveJob.
+  scoped_refptr<PackageArchive> archive = package->GetArchive();
+  if (!archive.get()) {
+    LOG(ERROR) << "Failed to read the package archive "
+               << path.AsUTF8Unsafe();
     return NULL;
   }
 
@@ -136,8 +127,7 @@ Application* ApplicationService::LaunchFromPackagePath(
     app_id = package->Id();
   std::string error;
   scoped_refptr<ApplicationData> application_data = LoadApplication(
-      target_dir, app_id, ApplicationData::TEMP_DIRECTORY,
-      package->manifest_type(), &error);
+      archive, app_id, package->manifest_type(), &error);
   if (!application_data.get()) {
     LOG(ERROR) << "Error occurred while trying to load application: "
                << error;
@@ -245,6 +235,10 @@ void ApplicationService::OnApplicationTerminated(
       content::BrowserThread::PostTask(content::BrowserThread::FILE,
           FROM_HERE, base::Bind(base::IgnoreResult(&base::DeleteFile),
                                 app_data->path(), true /*recursive*/));
+  }
+
+  if (app_data->source_type() == ApplicationData::TEMP_DIRECTORY ||
+      app_data->source_type() == ApplicationData::PACKAGE_ARCHIVE) {
       // FIXME: So far we simply clean up all the app persistent data,
       // further we need to add an appropriate logic to handle it.
       content::BrowserContext::GarbageCollectStoragePartitions(
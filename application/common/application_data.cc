@@ -67,6 +67,18 @@ scoped_refptr<ApplicationData> ApplicationData::Create(
   return app_data;
 }
 
+// static
+scoped_refptr<ApplicationData> ApplicationData::Create(
+    scoped_refptr<PackageArchive> archive, const std::string& id,
+    std::unique_ptr<Manifest> manifest, std::string* error_message) {
+  scoped_refptr<ApplicationData> app_data = Create(
+      archive->path(), id, PACKAGE_ARCHIVE, std::move(manifest),
+      error_message);
+  if (app_data.get())
+    app_data->archive_ = archive;
+  return app_data;
+}
+
 // static
 GURL ApplicationData::GetBaseURLFromApplicationId(
     const std::string& application_id) {
@@ -139,11 +151,18 @@ GURL ApplicationData::GetResourceURL(const GURL& application_url,
 }
 
 GURL ApplicationData::GetResourceURL(const std::string& relative_path) const {
+  bool exists;
+  if (archive_.get()) {
+    exists = archive_->FindEntry(
+        base::FilePath::FromUTF8Unsafe(relative_path)) != NULL;
+  } else {
 #if defined (OS_WIN)
-  if (!base::PathExists(path_.Append(base::UTF8ToWide(relative_path)))) {
+    exists = base::PathExists(path_.Append(base::UTF8ToWide(relative_path)));
 #else
-  if (!base::PathExists(path_.Append(relative_path))) {
+    exists = base::PathExists(path_.Append(relative_path));
 #endif
+  }
+  if (!exists) {
     LOG(ERROR) << "The path does not exist in the application directory: "
                << relative_path;
     return GURL();
@@ -25,6 +25,7 @@
 #include "xwalk/application/common/manifest.h"
 #include "xwalk/application/common/permission_types.h"
 #include "xwalk/application/common/package/package.h"
+#include "xwalk/application/common/package/package_archive.h"
 
 #if defined(OS_WIN)
 #define strcasecmp _stricmp
@@ -46,7 +47,8 @@ class ApplicationData : public base::RefCountedThreadSafe<ApplicationData> {
     INTERNAL,         // From internal application registry.
     LOCAL_DIRECTORY,  // From a persistently stored unpacked application
     TEMP_DIRECTORY,   // From a temporary folder
-    EXTERNAL_URL      // From an arbitrary URL
+    EXTERNAL_URL,     // From an arbitrary URL
+    PACKAGE_ARCHIVE   // From a package, served without being extracted
   };
 
   struct ManifestData;
@@ -74,6 +76,11 @@ class ApplicationData : public base::RefCountedThreadSafe<ApplicationData> {
   static scoped_refptr<ApplicationData> Create(const base::FilePath& app_path,
       const std::string& id, SourceType source_type,
           std::unique_ptr<Manifest> manifest, std::string* error_message);
+  // Creates a PACKAGE_ARCHIVE application, whose resources are read from
+  // |archive| rather than from a directory.
+  static scoped_refptr<ApplicationData> Create(
+      scoped_refptr<PackageArchive> archive, const std::string& id,
+      std::unique_ptr<Manifest> manifest, std::string* error_message);
 
   // Returns an absolute url to a resource inside of an application. The
   // |application_url| argument should be the url() from an Application object.
@@ -98,6 +105,8 @@ class ApplicationData : public base::RefCountedThreadSafe<ApplicationData> {
 
   // Accessors:
   const base::FilePath& path() const { return path_; }
+  // The archive of PACKAGE_ARCHIVE applications, NULL for the others.
+  PackageArchive* archive() const { return archive_.get(); }
   const GURL& URL() const { return application_url_; }
   SourceType source_type() const { return source_type_; }
   Manifest::Type manifest_type() const { return manifest_->type(); }
@@ -170,9 +179,12 @@ class ApplicationData : public base::RefCountedThreadSafe<ApplicationData> {
   // the case when we know the manifest version actually is 1.
   int manifest_version_;
 
-  // The absolute path to the directory the application is stored in.
+  // The absolute path to the directory the application is stored in, or to
+  // the package for PACKAGE_ARCHIVE applications.
   base::FilePath path_;
 
+  scoped_refptr<PackageArchive> archive_;
+
   // A persistent, globally unique ID. An application's ID is used in things
   // like directory structures and URLs, and is expected to not change across
   // versions.
@@ -14,6 +14,7 @@
 #include "base/files/scoped_temp_dir.h"
 #include "base/i18n/rtl.h"
 #include "base/json/json_file_value_serializer.h"
+#include "base/json/json_string_value_serializer.h"
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
 #include "base/metrics/histogram.h"
@@ -350,17 +351,8 @@ base::DictionaryValue* LoadXMLNode(
   return value.release();
 }
 
-}  // namespace
-
-template <Manifest::Type>
-std::unique_ptr<Manifest> LoadManifest(
-    const base::FilePath& manifest_path, std::string* error);
-
-template <>
-std::unique_ptr<Manifest> LoadManifest<Manifest::TYPE_MANIFEST>(
-    const base::FilePath& manifest_path, std::string* error) {
-  JSONFileValueDeserializer deserializer(manifest_path);
-  std::unique_ptr<base::Value> root(deserializer.Deserialize(NULL, error));
+std::unique_ptr<Manifest> CreateManifestFromJSON(
+    std::unique_ptr<base::Value> root, std::string* error) {
   if (!root) {
     if (error->empty()) {
       // If |error| is empty, than the file could not be read.
@@ -385,27 +377,45 @@ std::unique_ptr<Manifest> LoadManifest<Manifest::TYPE_MANIFEST>(
   return base::WrapUnique(new Manifest(std::move(dv), Manifest::TYPE_MANIFEST));
 }
 
-template <>
-std::unique_ptr<Manifest> LoadManifest<Manifest::TYPE_WIDGET>(
-    const base::FilePath& manifest_path,
-    std::string* error) {
-  xmlDoc * doc = NULL;
-  xmlNode* root_node = NULL;
-  doc = xmlReadFile(manifest_path.MaybeAsASCII().c_str(), NULL, 0);
+// Takes ownership of |doc|.
+std::unique_ptr<Manifest> CreateManifestFromXML(
+    xmlDoc* doc, std::string* error) {
   if (doc == NULL) {
     *error = base::StringPrintf("%s", errors::kManifestUnreadable);
     return std::unique_ptr<Manifest>();
   }
-  root_node = xmlDocGetRootElement(doc);
+  xmlNode* root_node = xmlDocGetRootElement(doc);
   base::DictionaryValue* dv = LoadXMLNode(root_node);
   std::unique_ptr<base::DictionaryValue> result(new base::DictionaryValue);
   if (dv)
     result->Set(ToConstCharPointer(root_node->name), dv);
+  xmlFreeDoc(doc);
 
   return base::WrapUnique(new Manifest(std::move(result),
                                       Manifest::TYPE_WIDGET));
 }
 
+}  // namespace
+
+template <Manifest::Type>
+std::unique_ptr<Manifest> LoadManifest(
+    const base::FilePath& manifest_path, std::string* error);
+
+template <>
+std::unique_ptr<Manifest> LoadManifest<Manifest::TYPE_MANIFEST>(
+    const base::FilePath& manifest_path, std::string* error) {
+  JSONFileValueDeserializer deserializer(manifest_path);
+  return CreateManifestFromJSON(deserializer.Deserialize(NULL, error), error);
+}
+
+template <>
+std::unique_ptr<Manifest> LoadManifest<Manifest::TYPE_WIDGET>(
+    const base::FilePath& manifest_path,
+    std::string* error) {
+  return CreateManifestFromXML(
+      xmlReadFile(manifest_path.MaybeAsASCII().c_str(), NULL, 0), error);
+}
+
 std::unique_ptr<Manifest> LoadManifest(const base::FilePath& manifest_path,
     Manifest::Type type, std::string* error) {
   if (type == Manifest::TYPE_MANIFEST)
@@ -450,6 +460,34 @@ scoped_refptr<ApplicationData> LoadApplication(
       app_root, app_id, source_type, std::move(manifest), error);
 }
 
+scoped_refptr<ApplicationData> LoadApplication(
+    scoped_refptr<PackageArchive> archive, const std::string& app_id,
+    Manifest::Type manifest_type, std::string* error) {
+  std::string manifest_name =
+      GetManifestPath(base::FilePath(), manifest_type).AsUTF8Unsafe();
+  std::string manifest_data;
+  if (!archive->ReadEntry(manifest_name, &manifest_data)) {
+    *error = base::StringPrintf("%s", errors::kManifestUnreadable);
+    return NULL;
+  }
+
+  std::unique_ptr<Manifest> manifest;
+  if (manifest_type == Manifest::TYPE_MANIFEST) {
+    JSONStringValueDeserializer deserializer(manifest_data);
+    manifest = CreateManifestFromJSON(
+        deserializer.Deserialize(NULL, error), error);
+  } else {
+    manifest = CreateManifestFromXML(
+        xmlReadMemory(manifest_data.data(),
+                      static_cast<int>(manifest_data.size()),
+                      manifest_name.c_str(), NULL, 0), error);
+  }
+  if (!manifest)
+    return NULL;
+
+  return ApplicationData::Create(archive, app_id, std::move(manifest), error);
+}
+
 base::FilePath ApplicationURLToRelativeFilePath(const GURL& url) {
   std::string url_path = url.path();
   if (url_path.empty() || url_path[0] != '/')
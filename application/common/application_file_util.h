@@ -50,6 +50,13 @@ scoped_refptr<ApplicationData> LoadApplication(
     ApplicationData::SourceType source_type, Manifest::Type manifest_type,
     std::string* error);
 
+// Loads and validates an application from the zip archive of a package. The
+// manifest is read from the archive, and so are the resources once the
+// application runs: nothing gets extracted.
+scoped_refptr<ApplicationData> LoadApplication(
+    scoped_refptr<PackageArchive> archive, const std::string& app_id,
+    Manifest::Type manifest_type, std::string* error);
+
 // Get a relative file path from an app:// URL.
 base::FilePath ApplicationURLToRelativeFilePath(const GURL& url);
 
@@ -0,0 +1,149 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_resource_index.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/strings/string_util.h"
+#include "build/build_config.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const char kLocaleDirectory[] = "locales/";
+
+// The file systems of these platforms ignore the case by default, and so did
+// the lookups before the index, so the keys are all lower case there.
+std::string NormalizeCase(const std::string& name) {
+#if defined(OS_WIN) || defined(OS_MACOSX)
+  return base::ToLowerASCII(name);
+#else
+  return name;
+#endif
+}
+
+// Joins the components of |relative_path| with '/', "." and ".." are
+// resolved but can't go above the root. The case is normalized.
+bool GetFileName(const base::FilePath& relative_path, std::string* name) {
+  if (relative_path.IsAbsolute())
+    return false;
+
+  std::vector<base::FilePath::StringType> components;
+  relative_path.GetComponents(&components);
+  std::vector<std::string> names;
+  for (const base::FilePath::StringType& component : components) {
+    if (component == base::FilePath::kCurrentDirectory)
+      continue;
+    if (component == base::FilePath::kParentDirectory) {
+      if (names.empty())
+        return false;
+      names.pop_back();
+      continue;
+    }
+    names.push_back(base::FilePath(component).AsUTF8Unsafe());
+  }
+
+  name->clear();
+  for (const std::string& component : names) {
+    if (!name->empty())
+      name->push_back('/');
+    name->append(component);
+  }
+  *name = NormalizeCase(*name);
+  return !name->empty();
+}
+
+}  // namespace
+
+ApplicationResourceIndex::ApplicationResourceIndex(
+    const base::FilePath& root)
+    : root_(root),
+      resolved_(false) {
+}
+
+ApplicationResourceIndex::~ApplicationResourceIndex() {
+}
+
+// static
+scoped_refptr<ApplicationResourceIndex> ApplicationResourceIndex::Create(
+    const base::FilePath& application_root) {
+  base::FilePath root = base::MakeAbsoluteFilePath(application_root);
+  if (root.empty())
+    return NULL;
+
+  scoped_refptr<ApplicationResourceIndex> index(
+      new ApplicationResourceIndex(root));
+  std::list<base::FilePath> resolved_parents(1, root);
+  index->IndexDirectory(root, &resolved_parents);
+  return index;
+}
+
+void ApplicationResourceIndex::IndexDirectory(
+    const base::FilePath& directory,
+    std::list<base::FilePath>* resolved_parents) {
+  base::FileEnumerator enumerator(
+      directory, false,
+      base::FileEnumerator::FILES | base::FileEnumerator::DIRECTORIES);
+  for (base::FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    base::FilePath resolved_path = base::MakeAbsoluteFilePath(path);
+    if (resolved_path.empty() || !root_.IsParent(resolved_path))
+      continue;
+
+    if (enumerator.GetInfo().IsDirectory()) {
+      if (std::find(resolved_parents->begin(), resolved_parents->end(),
+                    resolved_path) != resolved_parents->end())
+        continue;
+      resolved_parents->push_back(resolved_path);
+      IndexDirectory(path, resolved_parents);
+      resolved_parents->pop_back();
+      continue;
+    }
+
+    base::FilePath relative_path;
+    std::string name;
+    if (root_.AppendRelativePath(path, &relative_path) &&
+        GetFileName(relative_path, &name))
+      files_[name] = resolved_path;
+  }
+}
+
+base::FilePath ApplicationResourceIndex::GetFilePath(
+    const base::FilePath& relative_path,
+    const std::list<std::string>& locales) {
+  std::string name;
+  if (!GetFileName(relative_path, &name))
+    return base::FilePath();
+
+  base::AutoLock lock(lock_);
+  if (!resolved_ || locales != locales_)
+    ResolveLocales(locales);
+  FileMap::const_iterator it = resources_.find(name);
+  return it != resources_.end() ? it->second : base::FilePath();
+}
+
+void ApplicationResourceIndex::ResolveLocales(
+    const std::list<std::string>& locales) {
+  lock_.AssertAcquired();
+  resources_ = files_;
+  // The most preferred locale comes first, so it is applied last.
+  for (auto locale = locales.rbegin(); locale != locales.rend(); ++locale) {
+    std::string prefix = NormalizeCase(kLocaleDirectory + *locale + "/");
+    for (const auto& file : files_) {
+      if (base::StartsWith(file.first, prefix, base::CompareCase::SENSITIVE))
+        resources_[file.first.substr(prefix.size())] = file.second;
+    }
+  }
+  locales_ = locales;
+  resolved_ = true;
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,80 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_INDEX_H_
+#define XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_INDEX_H_
+
+#include <stddef.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+
+namespace xwalk {
+namespace application {
+
+// In-memory index of the files of an unpacked application, so resources can
+// be resolved without touching the disk. Create() walks the application root
+// once and resolves every file the way ApplicationResource::GetFilePath()
+// does with SYMLINKS_MUST_RESOLVE_WITHIN_ROOT: files that don't end up
+// within the root are left out.
+//
+// The index is a snapshot, files added to the application afterwards are
+// not found. It can be used from any thread.
+class ApplicationResourceIndex
+    : public base::RefCountedThreadSafe<ApplicationResourceIndex> {
+ public:
+  // Indexes the files under |application_root|. This blocks on the disk.
+  // Returns NULL if the root doesn't exist.
+  static scoped_refptr<ApplicationResourceIndex> Create(
+      const base::FilePath& application_root);
+
+  // Absolute path of the application root.
+  const base::FilePath& application_root() const { return root_; }
+  size_t size() const { return files_.size(); }
+
+  // Returns the file to serve for |relative_path|, trying the
+  // locales/<locale>/ variants in the order of |locales| before the file
+  // itself, or an empty path if there is none. The variants are resolved
+  // once per list of locales and recomputed when it changes.
+  base::FilePath GetFilePath(const base::FilePath& relative_path,
+                             const std::list<std::string>& locales);
+
+ private:
+  friend class base::RefCountedThreadSafe<ApplicationResourceIndex>;
+
+  // Keyed by the '/' separated path relative to the root, in lower case on
+  // Windows and Mac, where the lookups ignore the case.
+  typedef std::unordered_map<std::string, base::FilePath> FileMap;
+
+  explicit ApplicationResourceIndex(const base::FilePath& root);
+  ~ApplicationResourceIndex();
+
+  // |resolved_parents| are the resolved paths of |directory| and of the
+  // directories above it, to avoid walking symlink loops.
+  void IndexDirectory(const base::FilePath& directory,
+                      std::list<base::FilePath>* resolved_parents);
+  void ResolveLocales(const std::list<std::string>& locales);
+
+  const base::FilePath root_;
+  FileMap files_;
+
+  base::Lock lock_;
+  // The locales |resources_| was computed for, and every file name mapped
+  // to its best variant for them.
+  std::list<std::string> locales_;
+  FileMap resources_;
+  bool resolved_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationResourceIndex);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_INDEX_H_
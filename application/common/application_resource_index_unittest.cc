@@ -0,0 +1,155 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_resource_index.h"
+
+#include <list>
+#include <string>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/application/common/application_resource.h"
+
+namespace xwalk {
+namespace application {
+
+class ApplicationResourceIndexTest : public testing::Test {
+ public:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    root_ = temp_dir_.GetPath().AppendASCII("app");
+    CreateFile("index.html");
+    CreateFile("js/main.js");
+    CreateFile("locales/en/index.html");
+    CreateFile("locales/en-us/index.html");
+    CreateFile("locales/fr/js/main.js");
+  }
+
+  void CreateFile(const std::string& name) {
+    base::FilePath path = root_.AppendASCII(name);
+    ASSERT_TRUE(base::CreateDirectory(path.DirName()));
+    ASSERT_EQ(static_cast<int>(name.size()),
+              base::WriteFile(path, name.data(), name.size()));
+  }
+
+  // The index must agree with ApplicationResource, which probes the disk.
+  void ExpectSameAsResource(ApplicationResourceIndex* index,
+                            const std::string& relative_path,
+                            const std::list<std::string>& locales) {
+    base::FilePath path = base::FilePath::FromUTF8Unsafe(relative_path);
+    ApplicationResource resource("id", root_, path);
+    resource.SetLocales(locales);
+    EXPECT_EQ(resource.GetFilePath(), index->GetFilePath(path, locales))
+        << relative_path;
+  }
+
+ protected:
+  base::ScopedTempDir temp_dir_;
+  base::FilePath root_;
+};
+
+TEST_F(ApplicationResourceIndexTest, Files) {
+  scoped_refptr<ApplicationResourceIndex> index =
+      ApplicationResourceIndex::Create(root_);
+  ASSERT_TRUE(index.get());
+  EXPECT_EQ(5u, index->size());
+
+  std::list<std::string> locales;
+  EXPECT_EQ(base::MakeAbsoluteFilePath(root_.AppendASCII("index.html")),
+            index->GetFilePath(
+                base::FilePath(FILE_PATH_LITERAL("index.html")), locales));
+  EXPECT_FALSE(index->GetFilePath(
+      base::FilePath(FILE_PATH_LITERAL("js/../index.html")), locales)
+      .empty());
+  EXPECT_TRUE(index->GetFilePath(
+      base::FilePath(FILE_PATH_LITERAL("../app/index.html")), locales)
+      .empty());
+  EXPECT_TRUE(index->GetFilePath(
+      base::FilePath(FILE_PATH_LITERAL("missing.html")), locales).empty());
+  EXPECT_TRUE(index->GetFilePath(
+      base::FilePath(FILE_PATH_LITERAL("js")), locales).empty());
+  EXPECT_TRUE(index->GetFilePath(base::FilePath(), locales).empty());
+
+  EXPECT_FALSE(ApplicationResourceIndex::Create(
+      root_.AppendASCII("missing")).get());
+}
+
+TEST_F(ApplicationResourceIndexTest, Locales) {
+  scoped_refptr<ApplicationResourceIndex> index =
+      ApplicationResourceIndex::Create(root_);
+  ASSERT_TRUE(index.get());
+
+  const char* const kPaths[] = {
+    "index.html", "js/main.js", "locales/en/index.html", "missing.html",
+  };
+  std::list<std::string> locales;
+  locales.push_back("en-us");
+  locales.push_back("en");
+  for (const char* path : kPaths)
+    ExpectSameAsResource(index.get(), path, locales);
+  EXPECT_EQ(base::MakeAbsoluteFilePath(
+                root_.AppendASCII("locales/en-us/index.html")),
+            index->GetFilePath(
+                base::FilePath(FILE_PATH_LITERAL("index.html")), locales));
+
+  // Changing the locales invalidates the resolved variants.
+  locales.clear();
+  locales.push_back("fr");
+  for (const char* path : kPaths)
+    ExpectSameAsResource(index.get(), path, locales);
+  EXPECT_EQ(base::MakeAbsoluteFilePath(
+                root_.AppendASCII("locales/fr/js/main.js")),
+            index->GetFilePath(
+                base::FilePath(FILE_PATH_LITERAL("js/main.js")), locales));
+}
+
+#if defined(OS_WIN) || defined(OS_MACOSX)
+TEST_F(ApplicationResourceIndexTest, CaseInsensitive) {
+  scoped_refptr<ApplicationResourceIndex> index =
+      ApplicationResourceIndex::Create(root_);
+  ASSERT_TRUE(index.get());
+
+  std::list<std::string> locales;
+  EXPECT_FALSE(index->GetFilePath(
+      base::FilePath(FILE_PATH_LITERAL("Index.HTML")), locales).empty());
+  EXPECT_FALSE(index->GetFilePath(
+      base::FilePath(FILE_PATH_LITERAL("JS/Main.js")), locales).empty());
+
+  locales.push_back("EN-US");
+  EXPECT_EQ(base::MakeAbsoluteFilePath(
+                root_.AppendASCII("locales/en-us/index.html")),
+            index->GetFilePath(
+                base::FilePath(FILE_PATH_LITERAL("Index.html")), locales));
+}
+#endif
+
+#if defined(OS_POSIX)
+TEST_F(ApplicationResourceIndexTest, Symlinks) {
+  base::FilePath outside = temp_dir_.GetPath().AppendASCII("outside.html");
+  ASSERT_EQ(1, base::WriteFile(outside, "x", 1));
+  ASSERT_TRUE(base::CreateSymbolicLink(
+      outside, root_.AppendASCII("outside.html")));
+  ASSERT_TRUE(base::CreateSymbolicLink(
+      root_.AppendASCII("index.html"), root_.AppendASCII("inside.html")));
+  // A loop must not be walked forever.
+  ASSERT_TRUE(base::CreateSymbolicLink(root_.AppendASCII("js"),
+                                       root_.AppendASCII("js/loop")));
+
+  scoped_refptr<ApplicationResourceIndex> index =
+      ApplicationResourceIndex::Create(root_);
+  ASSERT_TRUE(index.get());
+  std::list<std::string> locales;
+  ExpectSameAsResource(index.get(), "outside.html", locales);
+  ExpectSameAsResource(index.get(), "inside.html", locales);
+  EXPECT_TRUE(index->GetFilePath(
+      base::FilePath(FILE_PATH_LITERAL("outside.html")), locales).empty());
+  EXPECT_EQ(base::MakeAbsoluteFilePath(root_.AppendASCII("index.html")),
+            index->GetFilePath(
+                base::FilePath(FILE_PATH_LITERAL("inside.html")), locales));
+}
+#endif
+
+}  // namespace application
+}  // namespace xwalk
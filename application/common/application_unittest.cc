@@ -21,6 +21,7 @@ TEST(ApplicationTest, LocationValuesTest) {
   ASSERT_EQ(1, ApplicationData::LOCAL_DIRECTORY);
   ASSERT_EQ(2, ApplicationData::TEMP_DIRECTORY);
   ASSERT_EQ(3, ApplicationData::EXTERNAL_URL);
+  ASSERT_EQ(4, ApplicationData::PACKAGE_ARCHIVE);
 }
 
 }  // namespace application
@@ -7,15 +7,40 @@
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/logging.h"
+#include "base/macros.h"
 #include "base/path_service.h"
-#include "third_party/zlib/google/zip.h"
+#include "base/threading/simple_thread.h"
 #include "xwalk/application/common/id_util.h"
+#include "xwalk/application/common/package/package_extractor.h"
 #include "xwalk/application/common/package/wgt_package.h"
 #include "xwalk/application/common/package/xpk_package.h"
 
 namespace xwalk {
 namespace application {
 
+namespace {
+
+// Runs Package::VerifySignature() on its own thread.
+class SignatureCheck : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit SignatureCheck(Package* package)
+      : package_(package),
+        is_valid_(false) {
+  }
+
+  void Run() override { is_valid_ = package_->VerifySignature(); }
+
+  bool is_valid() const { return is_valid_; }
+
+ private:
+  Package* package_;
+  bool is_valid_;
+
+  DISALLOW_COPY_AND_ASSIGN(SignatureCheck);
+};
+
+}  // namespace
+
 Package::Package(const base::FilePath& source_path,
     Manifest::Type manifest_type)
     : is_valid_(false),
@@ -43,6 +68,16 @@ std::unique_ptr<Package> Package::Create(const base::FilePath& source_path) {
   return std::unique_ptr<Package>();
 }
 
+scoped_refptr<PackageArchive> Package::GetArchive() {
+  if (!archive_.get())
+    archive_ = PackageArchive::Open(source_path_);
+  return archive_;
+}
+
+bool Package::VerifySignature() {
+  return true;
+}
+
 bool Package::ExtractToTemporaryDir(base::FilePath* target_path) {
   if (is_extracted_) {
     *target_path = temp_dir_.GetPath();
@@ -55,10 +90,8 @@ bool Package::ExtractToTemporaryDir(base::FilePath* target_path) {
     return false;
   }
 
-  if (!zip::Unzip(source_path_, temp_dir_.GetPath())) {
-    LOG(ERROR) << "An error occurred during package extraction";
+  if (!ExtractTo(temp_dir_.GetPath()))
     return false;
-  }
 
   is_extracted_ = true;
 
@@ -77,11 +110,46 @@ bool Package::ExtractTo(const base::FilePath& target_path) {
                << "is not empty.";
     return false;
   }
-  if (!zip::Unzip(source_path_, target_path)) {
+  scoped_refptr<PackageArchive> archive = GetArchive();
+  if (!IsValid() || !archive.get()) {
+    LOG(ERROR) << "The package is not valid.";
+    return false;
+  }
+
+  // Stage next to |target_path| so committing is a rename.
+  base::ScopedTempDir staging_dir;
+  if (!staging_dir.CreateUniqueTempDirUnderPath(target_path.DirName())) {
+    LOG(ERROR) << "Can't create a staging directory for the package content.";
+    return false;
+  }
+
+  // Both sides read the same mapping, so the package only comes from the
+  // disk once. GetArchive() was called above, VerifySignature() only gets
+  // the existing archive from the other thread.
+  DCHECK(archive_.get());
+  SignatureCheck signature_check(this);
+  base::DelegateSimpleThread signature_thread(&signature_check,
+                                              "PackageSignature");
+  signature_thread.Start();
+  bool extracted = PackageExtractor(archive).ExtractTo(staging_dir.GetPath());
+  signature_thread.Join();
+
+  if (!extracted) {
     LOG(ERROR) << "An error occurred during package extraction";
     return false;
   }
+  if (!signature_check.is_valid()) {
+    LOG(ERROR) << "The package signature is not valid.";
+    return false;
+  }
 
+  if (!base::DeleteFile(target_path, false) ||
+      !base::Move(staging_dir.GetPath(), target_path)) {
+    LOG(ERROR) << "Can't move the package content to "
+               << target_path.MaybeAsASCII();
+    return false;
+  }
+  ignore_result(staging_dir.Take());
   return true;
 }
 
@@ -11,7 +11,9 @@
 #include "base/files/file_path.h"
 #include "base/files/scoped_file.h"
 #include "base/files/scoped_temp_dir.h"
+#include "base/memory/ref_counted.h"
 #include "xwalk/application/common/manifest.h"
+#include "xwalk/application/common/package/package_archive.h"
 
 namespace xwalk {
 namespace application {
@@ -23,17 +25,34 @@ namespace application {
 class Package {
  public:
   virtual ~Package();
+  // Whether the package header could be parsed. This does NOT mean the XPK
+  // signature was checked, only VerifySignature() does, which ExtractTo()
+  // and ApplicationService::LaunchFromPackagePath() call. Don't trust the
+  // content of a package that didn't go through one of them.
   bool IsValid() const { return is_valid_; }
   const std::string& Id() const { return id_; }
   const std::string& name() const { return name_; }
   // Returns the type of the manifest which the package contains.
   Manifest::Type manifest_type() const { return manifest_type_; }
-  // Factory method for creating a package
+  // Factory method for creating a package. The signature isn't verified,
+  // see IsValid().
   static std::unique_ptr<Package> Create(const base::FilePath& path);
+  // Returns the zip archive of the package, mapped and indexed on first use,
+  // or NULL if the package isn't a valid zip file. Its resources can be read
+  // from there without extracting the package. The archive is created
+  // without locking: the first call must not race with another, which is
+  // why ExtractTo() makes it before starting the signature thread.
+  scoped_refptr<PackageArchive> GetArchive();
+  // Checks the signature of the package, if it has one. This reads the
+  // whole package.
+  virtual bool VerifySignature();
   // The function will unzip the XPK/WGT file and return the target path where
   // to decompress by the parameter |target_path|.
   virtual bool ExtractToTemporaryDir(base::FilePath* result_path);
-  // The function will unzip the XPK/WGT file to the given folder.
+  // The function will unzip the XPK/WGT file to the given folder. The package
+  // is read only once: the signature is checked on another thread while the
+  // entries are extracted to a staging folder, which is moved to
+  // |target_path| only if the signature is good.
   virtual bool ExtractTo(const base::FilePath& target_path);
 
  protected:
@@ -51,6 +70,7 @@ class Package {
   // Represent if the package has been extracted.
   bool is_extracted_;
   Manifest::Type manifest_type_;
+  scoped_refptr<PackageArchive> archive_;
 };
 
 }  // namespace application
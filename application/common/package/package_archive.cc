@@ -0,0 +1,314 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/package/package_archive.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "third_party/zlib/zlib.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// See section 4.3 of the .ZIP File Format Specification (APPNOTE.TXT).
+const uint32_t kEndOfCentralDirectorySignature = 0x06054b50;
+const size_t kEndOfCentralDirectorySize = 22;
+const size_t kMaxCommentSize = 0xffff;
+
+const uint32_t kCentralDirectoryEntrySignature = 0x02014b50;
+const size_t kCentralDirectoryEntrySize = 46;
+
+const uint32_t kLocalFileHeaderSignature = 0x04034b50;
+const size_t kLocalFileHeaderSize = 30;
+
+const uint16_t kEncryptedFlag = 1 << 0;
+const uint16_t kStored = 0;
+const uint16_t kDeflated = 8;
+
+// Values used by ZIP64 archives, which packages never need.
+const uint16_t kZip64EntryCount = 0xffff;
+const uint32_t kZip64Offset = 0xffffffff;
+
+uint16_t ReadUInt16(const uint8_t* data) {
+  return data[0] | data[1] << 8;
+}
+
+uint32_t ReadUInt32(const uint8_t* data) {
+  return data[0] | data[1] << 8 | data[2] << 16 |
+      static_cast<uint32_t>(data[3]) << 24;
+}
+
+}  // namespace
+
+PackageArchive::Reader::Reader(scoped_refptr<const PackageArchive> archive,
+                               const Entry* entry)
+    : archive_(archive),
+      entry_(entry),
+      input_offset_(0),
+      output_size_(0),
+      crc32_(crc32(0L, Z_NULL, 0)),
+      done_(false),
+      failed_(false) {
+  DCHECK(entry_);
+}
+
+PackageArchive::Reader::~Reader() {
+  if (stream_)
+    inflateEnd(stream_.get());
+}
+
+int PackageArchive::Reader::Read(char* buffer, int size) {
+  DCHECK_GT(size, 0);
+  if (failed_)
+    return -1;
+  if (done_)
+    return 0;
+
+  int count = entry_->method == kStored ?
+      CopyStored(buffer, size) : Inflate(buffer, size);
+  if (count < 0 || count > static_cast<int>(entry_->size - output_size_)) {
+    LOG(ERROR) << "Corrupted entry in " << archive_->path().AsUTF8Unsafe();
+    failed_ = true;
+    return -1;
+  }
+
+  crc32_ = crc32(crc32_, reinterpret_cast<Bytef*>(buffer), count);
+  output_size_ += count;
+  if (entry_->method == kStored && output_size_ == entry_->size)
+    done_ = true;
+
+  if (done_ && (output_size_ != entry_->size || crc32_ != entry_->crc32)) {
+    LOG(ERROR) << "Bad CRC in " << archive_->path().AsUTF8Unsafe();
+    failed_ = true;
+    return -1;
+  }
+  return count;
+}
+
+int PackageArchive::Reader::CopyStored(char* buffer, int size) {
+  uint32_t count = std::min<uint32_t>(size, entry_->size - output_size_);
+  memcpy(buffer,
+         archive_->file_.data() + entry_->data_offset + output_size_, count);
+  return count;
+}
+
+int PackageArchive::Reader::Inflate(char* buffer, int size) {
+  if (!stream_) {
+    stream_.reset(new z_stream);
+    memset(stream_.get(), 0, sizeof(z_stream));
+    // Negative window bits: raw deflate data, zip has its own headers.
+    if (inflateInit2(stream_.get(), -MAX_WBITS) != Z_OK) {
+      stream_.reset();
+      return -1;
+    }
+  }
+
+  // zlib doesn't write to the input, it's only not const for historic
+  // reasons.
+  stream_->next_in = const_cast<Bytef*>(
+      archive_->file_.data() + entry_->data_offset + input_offset_);
+  stream_->avail_in = entry_->compressed_size - input_offset_;
+  stream_->next_out = reinterpret_cast<Bytef*>(buffer);
+  stream_->avail_out = size;
+
+  int status = inflate(stream_.get(), Z_NO_FLUSH);
+  input_offset_ = entry_->compressed_size - stream_->avail_in;
+  int count = size - stream_->avail_out;
+  if (status == Z_STREAM_END) {
+    done_ = true;
+    return count;
+  }
+  // Without output space left inflate() always makes progress, so no output
+  // means the compressed data is truncated.
+  if (status != Z_OK || !count)
+    return -1;
+  return count;
+}
+
+PackageArchive::PackageArchive(const base::FilePath& path)
+    : path_(path) {
+}
+
+PackageArchive::~PackageArchive() {
+}
+
+// static
+scoped_refptr<PackageArchive> PackageArchive::Open(
+    const base::FilePath& path) {
+  base::FilePath absolute_path = base::MakeAbsoluteFilePath(path);
+  if (absolute_path.empty())
+    return NULL;
+
+  scoped_refptr<PackageArchive> archive(new PackageArchive(absolute_path));
+  if (!archive->file_.Initialize(absolute_path)) {
+    LOG(ERROR) << "Unable to map " << absolute_path.AsUTF8Unsafe();
+    return NULL;
+  }
+  if (!archive->Index()) {
+    LOG(ERROR) << "Invalid zip archive " << absolute_path.AsUTF8Unsafe();
+    return NULL;
+  }
+  return archive;
+}
+
+bool PackageArchive::Index() {
+  const uint8_t* data = file_.data();
+  const size_t length = file_.length();
+  if (length < kEndOfCentralDirectorySize)
+    return false;
+
+  // The end of central directory record is followed by a comment of up to
+  // 64K, look for its signature backwards.
+  size_t end = length - kEndOfCentralDirectorySize;
+  size_t min_end = end > kMaxCommentSize ? end - kMaxCommentSize : 0;
+  while (ReadUInt32(data + end) != kEndOfCentralDirectorySignature) {
+    if (end == min_end)
+      return false;
+    --end;
+  }
+
+  const uint8_t* record = data + end;
+  uint16_t disk_number = ReadUInt16(record + 4);
+  uint16_t directory_disk_number = ReadUInt16(record + 6);
+  uint16_t entry_count = ReadUInt16(record + 10);
+  uint32_t directory_size = ReadUInt32(record + 12);
+  uint32_t directory_offset = ReadUInt32(record + 16);
+  if (disk_number || directory_disk_number) {
+    LOG(ERROR) << "Multi-volume zip archives are not supported.";
+    return false;
+  }
+  if (entry_count == kZip64EntryCount || directory_offset == kZip64Offset) {
+    LOG(ERROR) << "ZIP64 archives are not supported.";
+    return false;
+  }
+
+  // The offsets in the archive are relative to the beginning of the zip data,
+  // which comes right before the central directory.
+  uint64_t directory_end = static_cast<uint64_t>(directory_offset) +
+      directory_size;
+  if (directory_end > end)
+    return false;
+  const size_t base = end - directory_end;
+
+  entries_.reserve(entry_count);
+  size_t position = base + directory_offset;
+  for (uint16_t i = 0; i < entry_count; ++i) {
+    if (end - position < kCentralDirectoryEntrySize)
+      return false;
+    const uint8_t* header = data + position;
+    if (ReadUInt32(header) != kCentralDirectoryEntrySignature)
+      return false;
+
+    uint16_t flags = ReadUInt16(header + 8);
+    Entry entry;
+    entry.method = ReadUInt16(header + 10);
+    entry.crc32 = ReadUInt32(header + 16);
+    entry.compressed_size = ReadUInt32(header + 20);
+    entry.size = ReadUInt32(header + 24);
+    uint16_t name_length = ReadUInt16(header + 28);
+    uint16_t extra_length = ReadUInt16(header + 30);
+    uint16_t comment_length = ReadUInt16(header + 32);
+    uint32_t local_header_offset = ReadUInt32(header + 42);
+
+    size_t header_size = kCentralDirectoryEntrySize + name_length +
+        extra_length + comment_length;
+    if (end - position < header_size)
+      return false;
+    std::string name(reinterpret_cast<const char*>(header) +
+                     kCentralDirectoryEntrySize, name_length);
+    position += header_size;
+
+    // Directories only exist through the files they contain.
+    if (name.empty() || name[name.size() - 1] == '/')
+      continue;
+
+    if (flags & kEncryptedFlag) {
+      LOG(ERROR) << "Encrypted entry " << name;
+      return false;
+    }
+    if ((entry.method != kStored && entry.method != kDeflated) ||
+        (entry.method == kStored && entry.size != entry.compressed_size)) {
+      LOG(ERROR) << "Unsupported compression of entry " << name;
+      return false;
+    }
+
+    // The local header repeats the name but may have a different extra
+    // field, the data starts right after it.
+    uint64_t local_header = static_cast<uint64_t>(base) + local_header_offset;
+    if (local_header + kLocalFileHeaderSize > end)
+      return false;
+    const uint8_t* local = data + local_header;
+    if (ReadUInt32(local) != kLocalFileHeaderSignature)
+      return false;
+    uint64_t data_offset = local_header + kLocalFileHeaderSize +
+        ReadUInt16(local + 26) + ReadUInt16(local + 28);
+    if (data_offset + entry.compressed_size > end)
+      return false;
+    entry.data_offset = static_cast<size_t>(data_offset);
+
+    entries_.insert(std::make_pair(name, entry));
+  }
+  return true;
+}
+
+const PackageArchive::Entry* PackageArchive::FindEntry(
+    const std::string& name) const {
+  auto it = entries_.find(name);
+  return it != entries_.end() ? &it->second : NULL;
+}
+
+const PackageArchive::Entry* PackageArchive::FindEntry(
+    const base::FilePath& relative_path) const {
+  if (relative_path.IsAbsolute())
+    return NULL;
+
+  std::vector<base::FilePath::StringType> components;
+  relative_path.GetComponents(&components);
+  std::vector<std::string> names;
+  for (const base::FilePath::StringType& component : components) {
+    if (component == base::FilePath::kCurrentDirectory)
+      continue;
+    if (component == base::FilePath::kParentDirectory) {
+      if (names.empty())
+        return NULL;
+      names.pop_back();
+      continue;
+    }
+    names.push_back(base::FilePath(component).AsUTF8Unsafe());
+  }
+
+  std::string name;
+  for (const std::string& component : names) {
+    if (!name.empty())
+      name.push_back('/');
+    name.append(component);
+  }
+  return FindEntry(name);
+}
+
+bool PackageArchive::ReadEntry(const std::string& name,
+                               std::string* contents) const {
+  const Entry* entry = FindEntry(name);
+  if (!entry)
+    return false;
+
+  scoped_refptr<Reader> reader(new Reader(this, entry));
+  contents->clear();
+  contents->reserve(entry->size);
+  char buffer[4096];
+  int count;
+  while ((count = reader->Read(buffer, sizeof(buffer))) > 0)
+    contents->append(buffer, count);
+  return count == 0;
+}
+
+}  // namespace application
+}  // namespace xwalk
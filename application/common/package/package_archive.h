@@ -0,0 +1,116 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_ARCHIVE_H_
+#define XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_ARCHIVE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+
+typedef struct z_stream_s z_stream;
+
+namespace xwalk {
+namespace application {
+
+// Read-only view of the zip archive of a .wgt/.xpk package, used to serve
+// the application resources without extracting them. The package is mapped
+// in memory and its central directory indexed once by Open(), entries are
+// then read on demand straight from the mapping: stored ones are copied out
+// and deflated ones inflated. Like minizip, anything in front of the zip data
+// (i.e. the XPK header) is skipped.
+//
+// The index doesn't change after Open(), so an archive can be shared between
+// threads. Reading an entry touches the mapping and may block on disk.
+class PackageArchive : public base::RefCountedThreadSafe<PackageArchive> {
+ public:
+  struct Entry {
+    uint16_t method;
+    uint32_t crc32;
+    uint32_t compressed_size;
+    uint32_t size;
+    // Where the entry data starts in the mapping.
+    size_t data_offset;
+  };
+
+  // Streams the content of one entry, checking its size and CRC once done.
+  // Holds a reference to the archive, so it can outlive its creator.
+  class Reader : public base::RefCountedThreadSafe<Reader> {
+   public:
+    Reader(scoped_refptr<const PackageArchive> archive, const Entry* entry);
+
+    // Reads up to |size| bytes of the entry into |buffer|. Returns how many
+    // were read, 0 at the end of the entry or -1 if the data is corrupted.
+    int Read(char* buffer, int size);
+
+   private:
+    friend class base::RefCountedThreadSafe<Reader>;
+    ~Reader();
+
+    int CopyStored(char* buffer, int size);
+    int Inflate(char* buffer, int size);
+
+    scoped_refptr<const PackageArchive> archive_;
+    const Entry* entry_;
+    std::unique_ptr<z_stream> stream_;
+    uint32_t input_offset_;
+    uint32_t output_size_;
+    uint32_t crc32_;
+    bool done_;
+    bool failed_;
+
+    DISALLOW_COPY_AND_ASSIGN(Reader);
+  };
+
+  typedef std::unordered_map<std::string, Entry> EntryMap;
+
+  // Maps the package at |path| and indexes its entries. Returns NULL if it
+  // isn't a zip file this class can read.
+  static scoped_refptr<PackageArchive> Open(const base::FilePath& path);
+
+  // Absolute path of the package.
+  const base::FilePath& path() const { return path_; }
+  size_t size() const { return entries_.size(); }
+  const EntryMap& entries() const { return entries_; }
+
+  // The whole mapped package, including what comes before the zip data.
+  const uint8_t* data() const { return file_.data(); }
+  size_t length() const { return file_.length(); }
+
+  // Returns the file entry stored as |name|, a '/' separated path relative to
+  // the archive root, or NULL if there is none.
+  const Entry* FindEntry(const std::string& name) const;
+  // Same for a relative file path, "." and ".." components are resolved but
+  // can't go above the archive root.
+  const Entry* FindEntry(const base::FilePath& relative_path) const;
+
+  // Reads the whole content of the entry |name| into |contents|.
+  bool ReadEntry(const std::string& name, std::string* contents) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<PackageArchive>;
+
+  explicit PackageArchive(const base::FilePath& path);
+  ~PackageArchive();
+
+  bool Index();
+
+  base::FilePath path_;
+  base::MemoryMappedFile file_;
+  EntryMap entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(PackageArchive);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_ARCHIVE_H_
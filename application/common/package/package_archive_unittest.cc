@@ -0,0 +1,84 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/package/package_archive.h"
+
+#include <string>
+
+#include "base/path_service.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace xwalk {
+namespace application {
+
+class PackageArchiveTest : public testing::Test {
+ public:
+  base::FilePath GetPackagePath(const std::string& name) {
+    base::FilePath path;
+    PathService::Get(base::DIR_SOURCE_ROOT, &path);
+    return path.AppendASCII("xwalk")
+        .AppendASCII("application")
+        .AppendASCII("test")
+        .AppendASCII("unpacker")
+        .AppendASCII(name);
+  }
+};
+
+TEST_F(PackageArchiveTest, Good) {
+  // good.xpk is a deflated zip preceded by the XPK header.
+  scoped_refptr<PackageArchive> archive =
+      PackageArchive::Open(GetPackagePath("good.xpk"));
+  ASSERT_TRUE(archive.get());
+  EXPECT_EQ(2u, archive->size());
+  EXPECT_TRUE(archive->FindEntry("index.html"));
+  EXPECT_FALSE(archive->FindEntry("missing.html"));
+
+  std::string manifest;
+  ASSERT_TRUE(archive->ReadEntry("manifest.json", &manifest));
+  EXPECT_EQ(archive->FindEntry("manifest.json")->size,
+            manifest.size());
+  EXPECT_EQ('{', manifest[0]);
+}
+
+TEST_F(PackageArchiveTest, RelativePaths) {
+  scoped_refptr<PackageArchive> archive =
+      PackageArchive::Open(GetPackagePath("good.xpk"));
+  ASSERT_TRUE(archive.get());
+  EXPECT_TRUE(archive->FindEntry(
+      base::FilePath(FILE_PATH_LITERAL("index.html"))));
+  EXPECT_TRUE(archive->FindEntry(
+      base::FilePath(FILE_PATH_LITERAL("./dir/../index.html"))));
+  EXPECT_FALSE(archive->FindEntry(
+      base::FilePath(FILE_PATH_LITERAL("../index.html"))));
+  EXPECT_FALSE(archive->FindEntry(
+      base::FilePath(FILE_PATH_LITERAL("dir/../../index.html"))));
+}
+
+TEST_F(PackageArchiveTest, StreamEntry) {
+  scoped_refptr<PackageArchive> archive =
+      PackageArchive::Open(GetPackagePath("good.xpk"));
+  ASSERT_TRUE(archive.get());
+  std::string expected;
+  ASSERT_TRUE(archive->ReadEntry("index.html", &expected));
+
+  // Small reads have to go through several inflate() calls.
+  scoped_refptr<PackageArchive::Reader> reader(new PackageArchive::Reader(
+      archive, archive->FindEntry("index.html")));
+  std::string contents;
+  char buffer[7];
+  int count;
+  while ((count = reader->Read(buffer, sizeof(buffer))) > 0)
+    contents.append(buffer, count);
+  EXPECT_EQ(0, count);
+  EXPECT_EQ(expected, contents);
+  EXPECT_EQ(0, reader->Read(buffer, sizeof(buffer)));
+}
+
+TEST_F(PackageArchiveTest, BadZip) {
+  EXPECT_FALSE(PackageArchive::Open(GetPackagePath("bad_zip.xpk")).get());
+  EXPECT_FALSE(PackageArchive::Open(GetPackagePath("missing.xpk")).get());
+}
+
+}  // namespace application
+}  // namespace xwalk
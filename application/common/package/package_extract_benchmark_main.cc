@@ -0,0 +1,181 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This is the package extraction benchmark. It builds synthetic packages
+// with various entry counts and sizes, then extracts each of them with
+// minizip (the former zip::Unzip() path), with PackageExtractor on the
+// calling thread and with PackageExtractor on growing thread pools.
+//
+// Every package is extracted once before being measured, so it is read
+// from the page cache: this measures inflating and writing, not reading.
+//
+// Results are printed to stdout as CSV:
+//   entries,entry_size,method,threads,ms,mb_per_sec
+//
+// Usage: package_extract_benchmark [--max-total-size=BYTES]
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+
+#include "base/at_exit.h"
+#include "base/command_line.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/macros.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "third_party/zlib/google/zip.h"
+#include "xwalk/application/common/package/package_archive.h"
+#include "xwalk/application/common/package/package_extractor.h"
+
+using xwalk::application::PackageArchive;
+using xwalk::application::PackageExtractor;
+
+// Skips the packages bigger than this many bytes once extracted.
+const char kMaxTotalSize[] = "max-total-size";
+
+namespace {
+
+const int64_t kDefaultMaxTotalSize = 256 * 1024 * 1024;
+
+const int kEntryCounts[] = {16, 256, 2048, 8192};
+const int kEntrySizes[] = {1024, 16 * 1024, 256 * 1024};
+const int kThreadCounts[] = {2, 4, 8};
+
+// Like most web assets, the entries are made of words and compress a few
+// times.
+std::string GenerateContent(int size, uint32_t seed) {
+  static const char* const kWords[] = {
+    "function", "var", "return", "this", "div", "class", "style", "width",
+    "height", "0px", "color", "null", "if", "else", "for", "{", "}", "()",
+  };
+  std::string content;
+  content.reserve(size + 16);
+  while (static_cast<int>(content.size()) < size) {
+    seed = seed * 1103515245 + 12345;
+    content.append(kWords[(seed >> 16) % arraysize(kWords)]);
+    content.push_back((seed >> 8) % 8 ? ' ' : '\n');
+  }
+  content.resize(size);
+  return content;
+}
+
+// Builds a package of |entry_count| entries of |entry_size| bytes, 64 per
+// directory.
+bool MakePackage(const base::FilePath& dir, int entry_count, int entry_size,
+                 base::FilePath* package_path) {
+  base::FilePath source_path;
+  if (!base::CreateTemporaryDirInDir(dir, FILE_PATH_LITERAL("source"),
+                                     &source_path))
+    return false;
+  for (int i = 0; i < entry_count; ++i) {
+    base::FilePath entry_path = source_path
+        .AppendASCII(base::StringPrintf("dir%d", i / 64))
+        .AppendASCII(base::StringPrintf("entry%d.js", i));
+    std::string content = GenerateContent(entry_size, i);
+    if (!base::CreateDirectory(entry_path.DirName()) ||
+        base::WriteFile(entry_path, content.data(), content.size()) !=
+            static_cast<int>(content.size()))
+      return false;
+  }
+
+  *package_path = dir.AppendASCII(
+      base::StringPrintf("package_%d_%d.wgt", entry_count, entry_size));
+  bool zipped = zip::Zip(source_path, *package_path, true);
+  base::DeleteFile(source_path, true);
+  return zipped;
+}
+
+// Extracts the package to a new directory with |thread_count| threads, or
+// with minizip if it is 0. Returns the time it took, or a negative value on
+// failure.
+double Extract(const base::FilePath& dir, const base::FilePath& package_path,
+               int thread_count) {
+  base::FilePath target_path;
+  if (!base::CreateTemporaryDirInDir(dir, FILE_PATH_LITERAL("target"),
+                                     &target_path))
+    return -1;
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  bool extracted;
+  if (!thread_count) {
+    extracted = zip::Unzip(package_path, target_path);
+  } else {
+    scoped_refptr<PackageArchive> archive =
+        PackageArchive::Open(package_path);
+    PackageExtractor extractor(archive);
+    extractor.set_thread_count(thread_count);
+    extracted = archive.get() && extractor.ExtractTo(target_path);
+  }
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  base::DeleteFile(target_path, true);
+  return extracted ? elapsed.InMillisecondsF() : -1;
+}
+
+void Report(int entry_count, int entry_size, const char* method,
+            int thread_count, double ms) {
+  if (ms < 0) {
+    printf("%d,%d,%s,%d,failed,\n", entry_count, entry_size, method,
+           thread_count);
+    return;
+  }
+  double mb = static_cast<double>(entry_count) * entry_size / (1024 * 1024);
+  printf("%d,%d,%s,%d,%.1f,%.1f\n", entry_count, entry_size, method,
+         thread_count, ms, mb / (std::max(ms, 0.1) / 1000));
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  base::AtExitManager exit_manager;
+  base::CommandLine::Init(argc, argv);
+
+  int64_t max_total_size = kDefaultMaxTotalSize;
+  base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
+  if (cmd_line->HasSwitch(kMaxTotalSize) &&
+      !base::StringToInt64(cmd_line->GetSwitchValueASCII(kMaxTotalSize),
+                           &max_total_size)) {
+    fprintf(stderr, "Invalid --%s value.\n", kMaxTotalSize);
+    return 1;
+  }
+
+  base::ScopedTempDir temp_dir;
+  if (!temp_dir.CreateUniqueTempDir()) {
+    fprintf(stderr, "Can't create a temporary directory.\n");
+    return 1;
+  }
+
+  printf("entries,entry_size,method,threads,ms,mb_per_sec\n");
+  for (int entry_count : kEntryCounts) {
+    for (int entry_size : kEntrySizes) {
+      if (static_cast<int64_t>(entry_count) * entry_size > max_total_size)
+        continue;
+
+      base::FilePath package_path;
+      if (!MakePackage(temp_dir.GetPath(), entry_count, entry_size,
+                       &package_path) ||
+          Extract(temp_dir.GetPath(), package_path, 1) < 0) {
+        fprintf(stderr, "Can't build a package of %d entries of %d bytes.\n",
+                entry_count, entry_size);
+        return 1;
+      }
+
+      Report(entry_count, entry_size, "minizip", 1,
+             Extract(temp_dir.GetPath(), package_path, 0));
+      Report(entry_count, entry_size, "serial", 1,
+             Extract(temp_dir.GetPath(), package_path, 1));
+      for (int thread_count : kThreadCounts) {
+        Report(entry_count, entry_size, "parallel", thread_count,
+               Extract(temp_dir.GetPath(), package_path, thread_count));
+      }
+      base::DeleteFile(package_path, false);
+    }
+  }
+  return 0;
+}
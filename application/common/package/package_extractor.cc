@@ -0,0 +1,121 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/package/package_extractor.h"
+
+#include <algorithm>
+#include <set>
+#include <utility>
+
+#include "base/files/file.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/sys_info.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const int kMaxThreadCount = 8;
+const int kBufferSize = 256 * 1024;
+
+}  // namespace
+
+PackageExtractor::PackageExtractor(scoped_refptr<PackageArchive> archive)
+    : archive_(archive),
+      thread_count_(GetDefaultThreadCount()),
+      next_task_(0),
+      failed_(0) {
+}
+
+PackageExtractor::~PackageExtractor() {
+}
+
+// static
+int PackageExtractor::GetDefaultThreadCount() {
+  return std::min(base::SysInfo::NumberOfProcessors(), kMaxThreadCount);
+}
+
+bool PackageExtractor::ExtractTo(const base::FilePath& target_path) {
+  std::vector<std::pair<size_t, const std::string*>> names;
+  names.reserve(archive_->size());
+  for (const auto& entry : archive_->entries())
+    names.push_back(std::make_pair(entry.second.data_offset, &entry.first));
+  std::sort(names.begin(), names.end());
+
+  tasks_.clear();
+  tasks_.reserve(names.size());
+  std::set<base::FilePath> directories;
+  for (const auto& name : names) {
+    base::FilePath relative_path =
+        base::FilePath::FromUTF8Unsafe(*name.second);
+    if (relative_path.IsAbsolute() || relative_path.ReferencesParent()) {
+      LOG(ERROR) << "Invalid entry path " << *name.second;
+      return false;
+    }
+    Task task;
+    task.entry = archive_->FindEntry(*name.second);
+    task.path = target_path.Append(relative_path);
+    directories.insert(task.path.DirName());
+    tasks_.push_back(task);
+  }
+
+  // Parents sort before their children, so each call creates at most one
+  // level and the threads never race on a directory.
+  for (const base::FilePath& directory : directories) {
+    if (!base::CreateDirectory(directory)) {
+      LOG(ERROR) << "Can't create " << directory.AsUTF8Unsafe();
+      return false;
+    }
+  }
+
+  base::subtle::NoBarrier_Store(&next_task_, 0);
+  base::subtle::NoBarrier_Store(&failed_, 0);
+  int thread_count = std::min<int>(thread_count_, tasks_.size());
+  if (thread_count <= 1) {
+    Run();
+  } else {
+    base::DelegateSimpleThreadPool pool("PackageExtractor", thread_count);
+    pool.AddWork(this, thread_count);
+    pool.Start();
+    pool.JoinAll();
+  }
+  return !base::subtle::Acquire_Load(&failed_);
+}
+
+void PackageExtractor::Run() {
+  std::vector<char> buffer(kBufferSize);
+  while (!base::subtle::Acquire_Load(&failed_)) {
+    size_t index =
+        base::subtle::NoBarrier_AtomicIncrement(&next_task_, 1) - 1;
+    if (index >= tasks_.size())
+      return;
+    if (!ExtractEntry(tasks_[index], &buffer)) {
+      LOG(ERROR) << "Can't extract " << tasks_[index].path.AsUTF8Unsafe();
+      base::subtle::Release_Store(&failed_, 1);
+    }
+  }
+}
+
+bool PackageExtractor::ExtractEntry(const Task& task,
+                                    std::vector<char>* buffer) {
+  base::File file(task.path,
+                  base::File::FLAG_CREATE | base::File::FLAG_WRITE);
+  if (!file.IsValid())
+    return false;
+
+  scoped_refptr<PackageArchive::Reader> reader(
+      new PackageArchive::Reader(archive_, task.entry));
+  int count;
+  int size = static_cast<int>(buffer->size());
+  while ((count = reader->Read(&buffer->front(), size)) > 0) {
+    if (file.WriteAtCurrentPos(&buffer->front(), count) != count)
+      return false;
+  }
+  return count == 0;
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,67 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_EXTRACTOR_H_
+#define XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_EXTRACTOR_H_
+
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/threading/simple_thread.h"
+#include "xwalk/application/common/package/package_archive.h"
+
+namespace xwalk {
+namespace application {
+
+// Extracts every entry of a PackageArchive to a directory. The directories
+// are all created up front, then the entries are shared between a pool of
+// threads, each of them inflating and writing whole entries. They take the
+// entries in the order they are stored, so the archive is still read mostly
+// sequentially.
+class PackageExtractor : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit PackageExtractor(scoped_refptr<PackageArchive> archive);
+  ~PackageExtractor() override;
+
+  // The number of processors, up to 8.
+  static int GetDefaultThreadCount();
+
+  // 1 extracts the entries on the calling thread. Defaults to
+  // GetDefaultThreadCount().
+  void set_thread_count(int thread_count) { thread_count_ = thread_count; }
+
+  // Extracts the archive to |target_path|, which must exist. Blocks until
+  // all the entries are written or one of them fails.
+  bool ExtractTo(const base::FilePath& target_path);
+
+ private:
+  struct Task {
+    const PackageArchive::Entry* entry;
+    base::FilePath path;
+  };
+
+  // base::DelegateSimpleThread::Delegate implementation, run by every
+  // thread: extracts entries until none is left.
+  void Run() override;
+
+  bool ExtractEntry(const Task& task, std::vector<char>* buffer);
+
+  scoped_refptr<PackageArchive> archive_;
+  int thread_count_;
+
+  std::vector<Task> tasks_;
+  base::subtle::Atomic32 next_task_;
+  base::subtle::Atomic32 failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(PackageExtractor);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_EXTRACTOR_H_
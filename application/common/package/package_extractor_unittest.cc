@@ -0,0 +1,133 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/package/package_extractor.h"
+
+#include <string>
+
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/string_number_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/google/zip.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const int kEntryCount = 200;
+
+}  // namespace
+
+class PackageExtractorTest : public testing::Test {
+ public:
+  // Zips kEntryCount files of different sizes, spread over a few
+  // directories.
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    base::FilePath source = temp_dir_.GetPath().AppendASCII("source");
+    for (int i = 0; i < kEntryCount; ++i) {
+      base::FilePath path = source.AppendASCII("dir" + base::IntToString(i % 7))
+                                .AppendASCII(base::IntToString(i) + ".txt");
+      std::string contents(i * 97, static_cast<char>('a' + i % 26));
+      contents += base::IntToString(i);
+      ASSERT_TRUE(base::CreateDirectory(path.DirName()));
+      ASSERT_EQ(static_cast<int>(contents.size()),
+                base::WriteFile(path, contents.data(), contents.size()));
+    }
+
+    base::FilePath zip_path = temp_dir_.GetPath().AppendASCII("package.zip");
+    ASSERT_TRUE(zip::Zip(source, zip_path, false));
+    archive_ = PackageArchive::Open(zip_path);
+    ASSERT_TRUE(archive_.get());
+    ASSERT_LE(static_cast<size_t>(kEntryCount), archive_->size());
+  }
+
+  base::FilePath CreateTargetDirectory(const std::string& name) {
+    base::FilePath path = temp_dir_.GetPath().AppendASCII(name);
+    EXPECT_TRUE(base::CreateDirectory(path));
+    return path;
+  }
+
+  // Path of the entry stored first, the one extracted first.
+  base::FilePath GetFirstEntryPath() {
+    const std::string* first = NULL;
+    size_t first_offset = 0;
+    for (const auto& entry : archive_->entries()) {
+      if (!first || entry.second.data_offset < first_offset) {
+        first = &entry.first;
+        first_offset = entry.second.data_offset;
+      }
+    }
+    return base::FilePath::FromUTF8Unsafe(*first);
+  }
+
+  static int CountFiles(const base::FilePath& path) {
+    int count = 0;
+    base::FileEnumerator enumerator(path, true, base::FileEnumerator::FILES);
+    while (!enumerator.Next().empty())
+      ++count;
+    return count;
+  }
+
+ protected:
+  base::ScopedTempDir temp_dir_;
+  scoped_refptr<PackageArchive> archive_;
+};
+
+TEST_F(PackageExtractorTest, ParallelMatchesSerial) {
+  base::FilePath serial = CreateTargetDirectory("serial");
+  PackageExtractor serial_extractor(archive_);
+  serial_extractor.set_thread_count(1);
+  ASSERT_TRUE(serial_extractor.ExtractTo(serial));
+
+  base::FilePath parallel = CreateTargetDirectory("parallel");
+  PackageExtractor parallel_extractor(archive_);
+  parallel_extractor.set_thread_count(4);
+  ASSERT_TRUE(parallel_extractor.ExtractTo(parallel));
+
+  EXPECT_EQ(kEntryCount, CountFiles(serial));
+  EXPECT_EQ(kEntryCount, CountFiles(parallel));
+  base::FileEnumerator enumerator(serial, true, base::FileEnumerator::FILES);
+  for (base::FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    base::FilePath relative_path;
+    ASSERT_TRUE(serial.AppendRelativePath(path, &relative_path));
+    EXPECT_TRUE(base::ContentsEqual(path, parallel.Append(relative_path)))
+        << relative_path.value();
+  }
+}
+
+TEST_F(PackageExtractorTest, FailureStopsTheOtherThreads) {
+  // Entries are never overwritten, so the first one fails.
+  base::FilePath target = CreateTargetDirectory("target");
+  base::FilePath blocker = target.Append(GetFirstEntryPath());
+  ASSERT_TRUE(base::CreateDirectory(blocker.DirName()));
+  ASSERT_EQ(1, base::WriteFile(blocker, "x", 1));
+
+  PackageExtractor extractor(archive_);
+  extractor.set_thread_count(4);
+  EXPECT_FALSE(extractor.ExtractTo(target));
+
+  // The entries already taken by the other threads are still written, but
+  // most of them must be left alone.
+  EXPECT_LT(CountFiles(target), kEntryCount / 2);
+}
+
+TEST_F(PackageExtractorTest, SerialFailureStopsRightAway) {
+  base::FilePath target = CreateTargetDirectory("target");
+  base::FilePath blocker = target.Append(GetFirstEntryPath());
+  ASSERT_TRUE(base::CreateDirectory(blocker.DirName()));
+  ASSERT_EQ(1, base::WriteFile(blocker, "x", 1));
+
+  PackageExtractor extractor(archive_);
+  extractor.set_thread_count(1);
+  EXPECT_FALSE(extractor.ExtractTo(target));
+  EXPECT_EQ(1, CountFiles(target));
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -42,6 +42,16 @@ TEST_F(PackageTest, Good) {
   EXPECT_TRUE(temp_dir_.Set(path));
 }
 
+TEST_F(PackageTest, ExtractTo) {
+  SetupPackage("good.xpk");
+  EXPECT_TRUE(package_->VerifySignature());
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  EXPECT_TRUE(package_->ExtractTo(temp_dir_.GetPath()));
+  EXPECT_TRUE(base::PathExists(
+      temp_dir_.GetPath().AppendASCII("manifest.json")));
+  EXPECT_TRUE(base::PathExists(temp_dir_.GetPath().AppendASCII("index.html")));
+}
+
 TEST_F(PackageTest, BadMagicString) {
   SetupPackage("bad_magic.xpk");
   base::FilePath path;
@@ -51,9 +61,17 @@ TEST_F(PackageTest, BadMagicString) {
 TEST_F(PackageTest, BadSignature) {
   SetupPackage("bad_signature.xpk");
   base::FilePath path;
+  EXPECT_FALSE(package_->VerifySignature());
   EXPECT_FALSE(package_->ExtractToTemporaryDir(&path));
 }
 
+TEST_F(PackageTest, BadSignatureNotExtracted) {
+  SetupPackage("bad_signature.xpk");
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  EXPECT_FALSE(package_->ExtractTo(temp_dir_.GetPath()));
+  EXPECT_TRUE(base::IsDirectoryEmpty(temp_dir_.GetPath()));
+}
+
 TEST_F(PackageTest, NoMagicHeader) {
   SetupPackage("no_magic_header.xpk");
   base::FilePath path;
@@ -15,6 +15,7 @@ namespace application {
 
 namespace {
 
+const char kConfigFileName[] = "config.xml";
 const char kIdNodeName[] = "widget";
 
 }  // namespace
@@ -26,14 +27,15 @@ WGTPackage::WGTPackage(const base::FilePath& path)
     : Package(path, Manifest::TYPE_WIDGET) {
   if (!base::PathExists(path))
     return;
-  base::FilePath extracted_path;
-  // FIXME : we should not call 'extract' here!
-  if (!ExtractToTemporaryDir(&extracted_path))
+  scoped_refptr<PackageArchive> archive = GetArchive();
+  std::string config;
+  if (!archive.get() || !archive->ReadEntry(kConfigFileName, &config)) {
+    LOG(ERROR) << "Unable to load WGT package config.xml file.";
     return;
+  }
 
   XmlReader xml;
-  if (!xml.LoadFile(extracted_path.Append(FILE_PATH_LITERAL("config.xml"))
-                    .MaybeAsASCII())) {
+  if (!xml.Load(config)) {
     LOG(ERROR) << "Unable to load WGT package config.xml file.";
     return;
   }
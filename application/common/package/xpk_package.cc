@@ -4,6 +4,7 @@
 
 #include "xwalk/application/common/package/xpk_package.h"
 
+#include <algorithm>
 #include <string>
 
 #include "base/files/file_util.h"
@@ -15,6 +16,12 @@
 namespace xwalk {
 namespace application {
 
+namespace {
+
+const size_t kVerifyChunkSize = 1024 * 1024;
+
+}  // namespace
+
 const char XPKPackage::kXPKPackageHeaderMagic[] = "CrWk";
 
 XPKPackage::~XPKPackage() {
@@ -57,9 +64,6 @@ XPKPackage::XPKPackage(const base::FilePath& path)
     if (len < header_.signature_size)
       is_valid_ = false;
 
-    if (!VerifySignature())
-      is_valid_ = false;
-
     std::string public_key =
         std::string(reinterpret_cast<char*>(&key_.front()), key_.size());
     id_ = GenerateId(public_key);
@@ -67,9 +71,9 @@ XPKPackage::XPKPackage(const base::FilePath& path)
 }
 
 bool XPKPackage::VerifySignature() {
-// Set the file read position to the beginning of compressed resource file,
-// which is behind the magic header, public key and signature key.
-  if (fseek(file_->get(), zip_addr_, SEEK_SET))
+  scoped_refptr<PackageArchive> archive = GetArchive();
+  if (!IsValid() || !archive.get() ||
+      archive->length() < static_cast<size_t>(zip_addr_))
     return false;
   crypto::SignatureVerifier verifier;
   if (!verifier.VerifyInit(crypto::SignatureVerifier::RSA_PKCS1_SHA1,
@@ -78,14 +82,18 @@ bool XPKPackage::VerifySignature() {
                            &key_.front(),
                            base::checked_cast<int>(key_.size())))
     return false;
-  unsigned char buf[1 << 12];
-  size_t len = 0;
-  while ((len = fread(buf, 1, sizeof(buf), file_->get())) > 0)
-    verifier.VerifyUpdate(buf, base::checked_cast<int>(len));
-  if (!verifier.VerifyFinal())
-    return false;
 
-  return true;
+  // The signature covers the compressed resource file, which is behind the
+  // magic header, public key and signature key.
+  const uint8_t* data = archive->data() + zip_addr_;
+  size_t size = archive->length() - zip_addr_;
+  while (size) {
+    size_t chunk_size = std::min(size, kVerifyChunkSize);
+    verifier.VerifyUpdate(data, base::checked_cast<int>(chunk_size));
+    data += chunk_size;
+    size -= chunk_size;
+  }
+  return verifier.VerifyFinal();
 }
 
 bool XPKPackage::ExtractToTemporaryDir(base::FilePath* target_path) {
@@ -27,11 +27,13 @@ class XPKPackage : public Package {
   };
   ~XPKPackage() override;
   explicit XPKPackage(const base::FilePath& path);
+  // Verifies the signature of the zip data against the package key, reading
+  // it from the mapped archive. Safe to call on any thread once GetArchive()
+  // has been called.
+  bool VerifySignature() override;
   bool ExtractToTemporaryDir(base::FilePath* target_path) override;
 
  private:
-  // verify the signature in the xpk package
-  virtual bool VerifySignature();
 
   Header header_;
   std::vector<uint8_t> signature_;
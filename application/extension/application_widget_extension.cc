@@ -122,14 +122,22 @@ void AppWidgetExtensionInstance::HandleMessage(std::unique_ptr<base::Value> msg)
 
 void AppWidgetExtensionInstance::HandleSyncMessage(
     std::unique_ptr<base::Value> msg) {
+  SendSyncReplyToJS(HandleCommand(std::move(msg)));
+}
+
+void AppWidgetExtensionInstance::HandleRequest(
+    int request_id, std::unique_ptr<base::Value> msg) {
+  SendRequestReplyToJS(request_id, HandleCommand(std::move(msg)));
+}
+
+std::unique_ptr<base::Value> AppWidgetExtensionInstance::HandleCommand(
+    std::unique_ptr<base::Value> msg) {
   base::DictionaryValue* dict;
   std::string command;
-  msg->GetAsDictionary(&dict);
 
   if (!msg->GetAsDictionary(&dict) || !dict->GetString(kCommandKey, &command)) {
     LOG(ERROR) << "Fail to handle command sync message.";
-    SendSyncReplyToJS(std::unique_ptr<base::Value>(new base::StringValue("")));
-    return;
+    return std::unique_ptr<base::Value>(new base::StringValue(""));
   }
 
   std::unique_ptr<base::Value> result(new base::StringValue(""));
@@ -151,7 +159,7 @@ void AppWidgetExtensionInstance::HandleSyncMessage(
     LOG(ERROR) << command << " ASSERT NOT REACHED.";
   }
 
-  SendSyncReplyToJS(std::move(result));
+  return result;
 }
 
 std::unique_ptr<base::StringValue> AppWidgetExtensionInstance::GetWidgetInfo(
@@ -34,8 +34,11 @@ class AppWidgetExtensionInstance : public XWalkExtensionInstance {
 
   void HandleMessage(std::unique_ptr<base::Value> msg) override;
   void HandleSyncMessage(std::unique_ptr<base::Value> msg) override;
+  void HandleRequest(int request_id, std::unique_ptr<base::Value> msg) override;
 
  private:
+  // Runs the command of a sync message or request and returns its result.
+  std::unique_ptr<base::Value> HandleCommand(std::unique_ptr<base::Value> msg);
   std::unique_ptr<base::StringValue> GetWidgetInfo(std::unique_ptr<base::Value> msg);
   std::unique_ptr<base::Value> SetPreferencesItem(
       std::unique_ptr<base::Value> mgs);
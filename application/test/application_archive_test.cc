@@ -0,0 +1,96 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/strings/stringprintf.h"
+#include "content/public/browser/web_contents.h"
+#include "content/public/test/browser_test_utils.h"
+#include "content/public/test/test_utils.h"
+#include "xwalk/application/browser/application.h"
+#include "xwalk/application/browser/application_service.h"
+#include "xwalk/application/common/package/package_archive.h"
+#include "xwalk/application/test/application_browsertest.h"
+#include "xwalk/runtime/browser/runtime.h"
+
+using xwalk::application::Application;
+
+// Packaged applications are served straight from their archive, see
+// URLRequestApplicationArchiveJob.
+class ApplicationArchiveTest : public ApplicationBrowserTest {
+ protected:
+  Application* LaunchPackage(const std::string& name) {
+    base::FilePath package_path = test_data_dir_.DirName()
+        .Append(FILE_PATH_LITERAL("unpacker")).AppendASCII(name);
+    Application* app =
+        application_sevice()->LaunchFromPackagePath(package_path);
+    if (!app || app->runtimes().empty())
+      return NULL;
+    web_contents_ = app->runtimes()[0]->web_contents();
+    if (!content::WaitForLoadStop(web_contents_))
+      return NULL;
+    return app;
+  }
+
+  // Returns "<status>:<body>" of a synchronous XHR to |path|, or "error" if
+  // the request failed.
+  std::string Fetch(const std::string& method, const std::string& path,
+                    const std::string& range = std::string()) {
+    std::string script = base::StringPrintf(
+        "var xhr = new XMLHttpRequest();"
+        "xhr.open('%s', '%s', false);"
+        "if ('%s') xhr.setRequestHeader('Range', '%s');"
+        "try {"
+        "  xhr.send();"
+        "  window.domAutomationController.send("
+        "      xhr.status + ':' + xhr.responseText);"
+        "} catch (e) {"
+        "  window.domAutomationController.send('error');"
+        "}",
+        method.c_str(), path.c_str(), range.c_str(), range.c_str());
+    std::string result;
+    EXPECT_TRUE(
+        content::ExecuteScriptAndExtractString(web_contents_, script, &result));
+    return result;
+  }
+
+  content::WebContents* web_contents_ = NULL;
+};
+
+IN_PROC_BROWSER_TEST_F(ApplicationArchiveTest, XPKResources) {
+  Application* app = LaunchPackage("good.xpk");
+  ASSERT_TRUE(app);
+  EXPECT_EQ(app->data()->archive()->path().BaseName().value(),
+            FILE_PATH_LITERAL("good.xpk"));
+
+  // index.html is deflated.
+  std::string index = Fetch("GET", "index.html");
+  EXPECT_EQ(0u, index.find("200:<!DOCTYPE"));
+  EXPECT_NE(std::string::npos, index.find("Hello, world"));
+  EXPECT_EQ("404:", Fetch("GET", "missing.html"));
+  EXPECT_EQ(0u, Fetch("POST", "index.html").find("501:"));
+}
+
+IN_PROC_BROWSER_TEST_F(ApplicationArchiveTest, WGTResources) {
+  Application* app = LaunchPackage("archive.wgt");
+  ASSERT_TRUE(app);
+
+  EXPECT_EQ("200:0123456789", Fetch("GET", "stored.txt"));
+  std::string deflated = Fetch("GET", "deflated.txt");
+  EXPECT_EQ(4u + 10000u, deflated.size());
+  EXPECT_EQ(0u, deflated.find("200:crosswalk crosswalk "));
+
+  // Only the default locale, "fr", has a localized greeting.
+  EXPECT_EQ("200:bonjour", Fetch("GET", "greeting.txt"));
+
+  EXPECT_EQ("404:", Fetch("GET", "locales/de/greeting.txt"));
+  EXPECT_EQ(0u, Fetch("PUT", "stored.txt").find("501:"));
+
+  // Single byte ranges, on both stored and deflated entries.
+  EXPECT_EQ("200:2345", Fetch("GET", "stored.txt", "bytes=2-5"));
+  EXPECT_EQ("200:789", Fetch("GET", "stored.txt", "bytes=-3"));
+  EXPECT_EQ("200:crosswalk ", Fetch("GET", "deflated.txt", "bytes=9990-"));
+  EXPECT_EQ("error", Fetch("GET", "stored.txt", "bytes=20-30"));
+  EXPECT_EQ("error", Fetch("GET", "stored.txt", "bytes=0-1,4-5"));
+}
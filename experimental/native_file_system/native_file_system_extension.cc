@@ -117,13 +117,22 @@ void NativeFileSystemInstance::OnRequestNativeFileSystem(
 }
 
 void NativeFileSystemInstance::HandleSyncMessage(std::unique_ptr<base::Value> msg) {
+  SendSyncReplyToJS(HandleCommand(std::move(msg)));
+}
+
+void NativeFileSystemInstance::HandleRequest(int request_id,
+                                             std::unique_ptr<base::Value> msg) {
+  SendRequestReplyToJS(request_id, HandleCommand(std::move(msg)));
+}
+
+std::unique_ptr<base::Value> NativeFileSystemInstance::HandleCommand(
+    std::unique_ptr<base::Value> msg) {
   base::DictionaryValue* dict;
   std::string command;
 
   if (!msg->GetAsDictionary(&dict) || !dict->GetString("command", &command)) {
     LOG(ERROR) << "Fail to handle sync message.";
-    SendSyncReplyToJS(std::unique_ptr<base::Value>(new base::StringValue("")));
-    return;
+    return base::WrapUnique(new base::StringValue(""));
   }
 
   std::unique_ptr<base::Value> result(new base::StringValue(""));
@@ -132,7 +141,7 @@ void NativeFileSystemInstance::HandleSyncMessage(std::unique_ptr<base::Value> ms
   } else {
     LOG(ERROR) << "Unknown command '" << command << "'";
   }
-  SendSyncReplyToJS(std::move(result));
+  return result;
 }
 
 }  // namespace experimental
@@ -39,8 +39,11 @@ class NativeFileSystemInstance : public XWalkExtensionInstance {
   // XWalkExtensionInstance implementation.
   void HandleMessage(std::unique_ptr<base::Value> msg) override;
   void HandleSyncMessage(std::unique_ptr<base::Value> msg) override;
+  void HandleRequest(int request_id, std::unique_ptr<base::Value> msg) override;
 
  private:
+  // Runs the command of a sync message or request and returns its result.
+  std::unique_ptr<base::Value> HandleCommand(std::unique_ptr<base::Value> msg);
   void OnRequestNativeFileSystem(std::unique_ptr<XWalkExtensionFunctionInfo> info);
 
   XWalkExtensionFunctionHandler handler_;
@@ -7,6 +7,7 @@
 #include "content/public/browser/browser_thread.h"
 #include "xwalk/extensions/browser/xwalk_extension_process_host.h"
 #include "xwalk/extensions/browser/xwalk_extension_service.h"
+#include "xwalk/extensions/browser/xwalk_extension_thread_pool.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
 using content::BrowserThread;
@@ -16,6 +17,7 @@ namespace extensions {
 
 XWalkExtensionData::XWalkExtensionData()
     : extension_thread_(nullptr),
+      extension_thread_pool_(nullptr),
       render_process_host_(nullptr),
       in_process_message_filter_(nullptr) {}
 
@@ -29,8 +31,16 @@ XWalkExtensionData::~XWalkExtensionData() {
   in_process_ui_thread_server_->Invalidate();
   in_process_message_filter_->Invalidate();
 
-  extension_thread_->message_loop()->task_runner()->DeleteSoon(
-      FROM_HERE, in_process_extension_thread_server_.release());
+  // Instances living on the thread pool have to be deleted on their own
+  // threads first.
+  if (extension_thread_pool_) {
+    extension_thread_pool_->DeleteServerSoon(
+        std::move(in_process_extension_thread_server_),
+        extension_thread_->task_runner());
+  } else {
+    extension_thread_->message_loop()->task_runner()->DeleteSoon(
+        FROM_HERE, in_process_extension_thread_server_.release());
+  }
 
   if (extension_process_host_) {
     BrowserThread::DeleteSoon(
@@ -21,6 +21,7 @@ namespace extensions {
 class ExtensionServerMessageFilter;
 class XWalkExtensionProcessHost;
 class XWalkExtensionServer;
+class XWalkExtensionThreadPool;
 
 // For each render process we create an ExtensionData with runtime information
 // of extensions associated to that particular render process. It holds pointers
@@ -65,6 +66,10 @@ class XWalkExtensionData {
     extension_thread_ = thread;
   }
 
+  void set_extension_thread_pool(XWalkExtensionThreadPool* pool) {
+    extension_thread_pool_ = pool;
+  }
+
   void set_render_process_host(content::RenderProcessHost* rph) {
     render_process_host_ = rph;
   }
@@ -82,6 +87,7 @@ class XWalkExtensionData {
   std::unique_ptr<XWalkExtensionProcessHost> extension_process_host_;
 
   base::Thread* extension_thread_;
+  XWalkExtensionThreadPool* extension_thread_pool_;
 
   content::RenderProcessHost* render_process_host_;
   ExtensionServerMessageFilter* in_process_message_filter_;
@@ -39,29 +39,32 @@ void XWalkExtensionFunctionHandler::HandleMessage(std::unique_ptr<base::Value> m
     return;
   }
 
-  // The first parameter stands for the function signature.
-  std::string function_name;
-  if (!args->GetString(0, &function_name)) {
-    LOG(WARNING) << "The function name is not a string.";
+  InternedFunction* function = PopFunction(args);
+  if (!function)
     return;
-  }
 
-  // The second parameter stands for callback id, the remaining
-  // ones are the function arguments.
-  std::string callback_id;
-  if (!args->GetString(1, &callback_id)) {
-    LOG(WARNING) << "The callback id is not a string.";
+  int callback_id;
+  if (!args->GetInteger(args->GetSize() - 1, &callback_id)) {
+    LOG(WARNING) << "The callback id is not an integer.";
     return;
   }
 
-  // We reuse args to pass the extra arguments to the handler, so remove
-  // function_name and callback_id from it.
-  args->Remove(0, NULL);
-  args->Remove(0, NULL);
+  // What is left are the function arguments.
+  args->Remove(args->GetSize() - 1, NULL);
+
+  if (!function->handler) {
+    FunctionHandlerMap::const_iterator iter = handlers_.find(function->name);
+    if (iter == handlers_.end()) {
+      DLOG(WARNING) << "Function not registered: " << function->name;
+      return;
+    }
+
+    function->handler = &iter->second;
+  }
 
   std::unique_ptr<XWalkExtensionFunctionInfo> info(
       new XWalkExtensionFunctionInfo(
-          function_name,
+          function->name,
           base::WrapUnique(static_cast<base::ListValue*>(msg.release())),
           base::Bind(&XWalkExtensionFunctionHandler::DispatchResult,
                      weak_factory_.GetWeakPtr(),
@@ -70,10 +73,44 @@ void XWalkExtensionFunctionHandler::HandleMessage(std::unique_ptr<base::Value> m
                          : nullptr,
                      callback_id)));
 
-  if (!HandleFunction(std::move(info))) {
-    DLOG(WARNING) << "Function not registered: " << function_name;
-    return;
+  function->handler->Run(std::move(info));
+}
+
+XWalkExtensionFunctionHandler::InternedFunction*
+XWalkExtensionFunctionHandler::PopFunction(base::ListValue* args) {
+  // A function called for the first time comes with its name.
+  std::string function_name;
+  bool is_new_function = args->GetString(args->GetSize() - 1, &function_name);
+  if (is_new_function)
+    args->Remove(args->GetSize() - 1, NULL);
+
+  int function_id;
+  if (args->empty() ||
+      !args->GetInteger(args->GetSize() - 1, &function_id) ||
+      function_id < 0) {
+    LOG(WARNING) << "The function id is not valid.";
+    return nullptr;
   }
+
+  args->Remove(args->GetSize() - 1, NULL);
+  size_t index = static_cast<size_t>(function_id);
+
+  if (is_new_function) {
+    // The JavaScript side numbers the functions in sequence.
+    if (index != functions_.size()) {
+      LOG(WARNING) << "Unexpected id " << function_id << " for the function "
+                   << function_name;
+      return nullptr;
+    }
+
+    InternedFunction function = { function_name, nullptr };
+    functions_.push_back(function);
+  } else if (index >= functions_.size()) {
+    LOG(WARNING) << "Unknown function id " << function_id;
+    return nullptr;
+  }
+
+  return &functions_[index];
 }
 
 bool XWalkExtensionFunctionHandler::HandleFunction(
@@ -91,7 +128,7 @@ bool XWalkExtensionFunctionHandler::HandleFunction(
 void XWalkExtensionFunctionHandler::DispatchResult(
     const base::WeakPtr<XWalkExtensionFunctionHandler>& handler,
     scoped_refptr<base::SingleThreadTaskRunner> client_task_runner,
-    const std::string& callback_id,
+    int callback_id,
     std::unique_ptr<base::ListValue> result) {
   DCHECK(result);
 
@@ -108,7 +145,7 @@ void XWalkExtensionFunctionHandler::DispatchResult(
     return;
   }
 
-  if (callback_id.empty()) {
+  if (!callback_id) {
     DLOG(WARNING) << "Sending a reply with an empty callback id has no"
         "practical effect. This code can be optimized by not creating "
         "and not posting the result.";
@@ -117,7 +154,7 @@ void XWalkExtensionFunctionHandler::DispatchResult(
 
   // Prepend the callback id to the list, so the handlers
   // on the JavaScript side know which callback should be evoked.
-  result->Insert(0, base::MakeUnique<base::Value>(new base::StringValue(callback_id)));
+  result->Insert(0, base::MakeUnique<base::Value>(callback_id));
 
   if (handler)
     handler->PostMessageToInstance(std::move(result));
@@ -7,6 +7,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include "base/bind.h"
 #include "base/memory/weak_ptr.h"
 #include "base/message_loop/message_loop.h"
@@ -43,6 +44,12 @@ class XWalkExtensionFunctionInfo {
     return name_;
   }
 
+  // Used when forwarding the call to a function with a different name, like
+  // BindingObjectStore does, without copying the arguments.
+  void set_name(const std::string& name) {
+    name_ = name;
+  }
+
   base::ListValue* arguments() const {
     return arguments_.get();
   }
@@ -73,7 +80,17 @@ class XWalkExtensionFunctionHandler {
   ~XWalkExtensionFunctionHandler();
 
   // Converts a raw message from the renderer to a XWalkExtensionFunctionInfo
-  // data structure and invokes HandleFunction().
+  // data structure and invokes the handler of the function.
+  //
+  // The messages are built by xwalk_internal_api.js as the list of arguments
+  // followed by the callback ID (0 meaning no callback) and the function ID.
+  // Function IDs are assigned by the JavaScript side the first time a
+  // function is called, that message carries the function name as well:
+  //
+  //   [arg1, ..., argN, callback_id, function_id(, function_name)]
+  //
+  // This trailer is cheap to pop, and dispatching is an index in
+  // |functions_| instead of a lookup by name.
   void HandleMessage(std::unique_ptr<base::Value> msg);
 
   // Executes the handler associated to the |name| tag of the |info| argument
@@ -103,17 +120,30 @@ class XWalkExtensionFunctionHandler {
   }
 
  private:
+  // A function interned by the JavaScript side. |handler| is resolved the
+  // first time the function is called, as it might be registered later.
+  struct InternedFunction {
+    std::string name;
+    const FunctionHandler* handler;
+  };
+
   static void DispatchResult(
       const base::WeakPtr<XWalkExtensionFunctionHandler>& handler,
       scoped_refptr<base::SingleThreadTaskRunner> client_task_runner,
-      const std::string& callback_id,
+      int callback_id,
       std::unique_ptr<base::ListValue> result);
 
+  // Returns the function referred by the trailer of |args|, removing it.
+  InternedFunction* PopFunction(base::ListValue* args);
+
   void PostMessageToInstance(std::unique_ptr<base::Value> msg);
 
   typedef std::map<std::string, FunctionHandler> FunctionHandlerMap;
   FunctionHandlerMap handlers_;
 
+  // Indexed by function ID.
+  std::vector<InternedFunction> functions_;
+
   XWalkExtensionInstance* instance_;
   base::WeakPtrFactory<XWalkExtensionFunctionHandler> weak_factory_;
 
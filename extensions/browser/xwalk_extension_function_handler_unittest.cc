@@ -112,8 +112,9 @@ TEST(XWalkExtensionFunctionHandlerTest, PostingResultAfterDeletingTheHandler) {
   handler->Register("storeFunctionInfo", base::Bind(&StoreFunctionInfo, &info));
 
   std::unique_ptr<base::ListValue> msg(new base::ListValue);
+  msg->AppendInteger(1);  // Callback ID.
+  msg->AppendInteger(0);  // Function ID.
   msg->AppendString("storeFunctionInfo");  // Function name.
-  msg->AppendString("id");  // Callback ID.
 
   handler->HandleMessage(std::move(msg));
   handler.reset();
@@ -124,3 +125,61 @@ TEST(XWalkExtensionFunctionHandlerTest, PostingResultAfterDeletingTheHandler) {
   info->PostResult(base::WrapUnique(new base::ListValue));
   delete info;
 }
+
+TEST(XWalkExtensionFunctionHandlerTest, HandleMessageWithInternedFunctions) {
+  XWalkExtensionFunctionHandler handler(NULL);
+
+  int echo_counter = 0;
+  int reset_counter = 0;
+  handler.Register("echoData", base::Bind(&EchoData, &echo_counter));
+  handler.Register("reset", base::Bind(&ResetCounter, &reset_counter));
+
+  // The first message of each function defines its ID.
+  std::unique_ptr<base::ListValue> msg1(new base::ListValue);
+  msg1->AppendString(kTestString);
+  msg1->AppendInteger(0);
+  msg1->AppendInteger(0);
+  msg1->AppendString("echoData");
+  handler.HandleMessage(std::move(msg1));
+  EXPECT_EQ(echo_counter, 1);
+
+  reset_counter = 1;
+  std::unique_ptr<base::ListValue> msg2(new base::ListValue);
+  msg2->AppendInteger(0);
+  msg2->AppendInteger(1);
+  msg2->AppendString("reset");
+  handler.HandleMessage(std::move(msg2));
+  EXPECT_EQ(reset_counter, 0);
+
+  // Then the ID is enough.
+  for (int i = 0; i < 1000; ++i) {
+    std::unique_ptr<base::ListValue> msg(new base::ListValue);
+    msg->AppendString(kTestString);
+    msg->AppendInteger(0);
+    msg->AppendInteger(0);
+    handler.HandleMessage(std::move(msg));
+  }
+  EXPECT_EQ(echo_counter, 1001);
+
+  // Unknown IDs, IDs out of sequence and non registered functions should
+  // not crash.
+  std::unique_ptr<base::ListValue> msg3(new base::ListValue);
+  msg3->AppendInteger(0);
+  msg3->AppendInteger(42);
+  handler.HandleMessage(std::move(msg3));
+
+  std::unique_ptr<base::ListValue> msg4(new base::ListValue);
+  msg4->AppendInteger(0);
+  msg4->AppendInteger(5);
+  msg4->AppendString("foobar");
+  handler.HandleMessage(std::move(msg4));
+
+  std::unique_ptr<base::ListValue> msg5(new base::ListValue);
+  msg5->AppendInteger(0);
+  msg5->AppendInteger(2);
+  msg5->AppendString("foobar");
+  handler.HandleMessage(std::move(msg5));
+
+  EXPECT_EQ(echo_counter, 1001);
+  EXPECT_EQ(reset_counter, 0);
+}
@@ -10,8 +10,11 @@
 #include "base/command_line.h"
 #include "base/memory/ptr_util.h"
 #include "base/pickle.h"
+#include "base/process/process.h"
 #include "base/scoped_native_library.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/synchronization/lock.h"
+#include "base/sys_info.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/notification_types.h"
 #include "content/public/browser/notification_service.h"
@@ -19,7 +22,10 @@
 #include "ipc/ipc_message_macros.h"
 #include "xwalk/extensions/browser/xwalk_extension_data.h"
 #include "xwalk/extensions/browser/xwalk_extension_process_host.h"
+#include "xwalk/extensions/browser/xwalk_extension_thread_pool.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_metrics.h"
+#include "xwalk/extensions/common/xwalk_extension_registry.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 #include "xwalk/extensions/common/xwalk_extension_switches.h"
 
@@ -38,17 +44,53 @@ XWalkExtensionService::CreateExtensionsCallback
 
 base::FilePath g_external_extensions_path_for_testing_;
 
+// Returns zero if the extension thread pool shouldn't be used.
+size_t GetNumberOfExtensionWorkerThreads() {
+  base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
+  if (!cmd_line->HasSwitch(switches::kXWalkExtensionWorkerThreads))
+    return 0;
+
+  unsigned num_threads = 0;
+  if (!base::StringToUint(cmd_line->GetSwitchValueASCII(
+          switches::kXWalkExtensionWorkerThreads), &num_threads) ||
+      num_threads == 0) {
+    num_threads = base::SysInfo::NumberOfProcessors();
+  }
+  return num_threads;
+}
+
+void RunExtensionThreadTask(const base::Closure& task) {
+  XWalkExtensionMetrics::GetInstance()->OnTaskStarted();
+  task.Run();
+}
+
+// Posts |task| for the extension thread server, keeping track of the depth of
+// the extension thread queue when the metrics are enabled.
+void PostExtensionThreadTask(base::TaskRunner* task_runner,
+                             const base::Closure& task) {
+  if (!XWalkExtensionMetrics::IsEnabled()) {
+    task_runner->PostTask(FROM_HERE, task);
+    return;
+  }
+  XWalkExtensionMetrics::GetInstance()->OnTaskQueued();
+  task_runner->PostTask(FROM_HERE, base::Bind(&RunExtensionThreadTask, task));
+}
+
 }  // namespace
 
 
 ExtensionServerMessageFilter::ExtensionServerMessageFilter(
     scoped_refptr<base::SequencedTaskRunner> task_runner,
     XWalkExtensionServer* extension_thread_server,
-    XWalkExtensionServer* ui_thread_server)
+    XWalkExtensionServer* ui_thread_server,
+    XWalkExtensionThreadPool* thread_pool,
+    bool publish_registry)
       : sender_(NULL),
         task_runner_(task_runner),
         extension_thread_server_(extension_thread_server),
-        ui_thread_server_(ui_thread_server) {}
+        ui_thread_server_(ui_thread_server),
+        thread_pool_(thread_pool),
+        publish_registry_(publish_registry) {}
 
 ExtensionServerMessageFilter::~ExtensionServerMessageFilter() {}
 
@@ -58,6 +100,8 @@ void ExtensionServerMessageFilter::Invalidate() {
   task_runner_ = nullptr;
   extension_thread_server_ = nullptr;
   ui_thread_server_ = nullptr;
+  thread_pool_ = nullptr;
+  extension_thread_instances_.clear();
 }
 
 // IPC::ChannelProxy::MessageFilter implementation.
@@ -69,6 +113,42 @@ void ExtensionServerMessageFilter::OnFilterRemoved() {
   sender_ = nullptr;
 }
 
+void ExtensionServerMessageFilter::OnChannelConnected(int32_t peer_pid) {
+  base::AutoLock l(lock_);
+  if (!extension_thread_server_ || !ui_thread_server_)
+    return;
+
+  // The in process servers are not listeners of the channel, let them know
+  // about the peer on their own threads so they can share memory with it.
+  task_runner_->PostTask(FROM_HERE, base::Bind(
+      &XWalkExtensionServer::SetPeerProcess,
+      extension_thread_server_->AsWeakPtr(), peer_pid));
+  BrowserThread::PostTask(BrowserThread::UI, FROM_HERE, base::Bind(
+      &XWalkExtensionServer::SetPeerProcess,
+      ui_thread_server_->AsWeakPtr(), peer_pid));
+
+  if (publish_registry_)
+    SendRegistry(peer_pid);
+}
+
+void ExtensionServerMessageFilter::SendRegistry(int32_t peer_pid) {
+  std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams> extensions;
+  OnGetExtensions(&extensions);
+
+  // On failure the client falls back to asking for the extensions.
+  XWalkExtensionRegistry* registry =
+      XWalkExtensionRegistry::Publish(extensions);
+  base::Process process = base::Process::OpenWithExtraPrivileges(peer_pid);
+  base::SharedMemoryHandle handle;
+  if (!registry || !process.IsValid() ||
+      !registry->ShareToProcess(process.Handle(), &handle)) {
+    LOG(WARNING) << "Can't share extension registry";
+    return;
+  }
+
+  Send(new XWalkExtensionClientMsg_SetupRegistry(handle, registry->size()));
+}
+
 void ExtensionServerMessageFilter::OnChannelClosing() {
   sender_ = nullptr;
 }
@@ -87,36 +167,24 @@ bool ExtensionServerMessageFilter::Send(IPC::Message* msg_ptr) {
   return sender_->Send(msg.release());
 }
 
-int64_t ExtensionServerMessageFilter::GetInstanceIDFromMessage(
-    const IPC::Message& message) {
-  base::PickleIterator iter;
-
-  if (message.is_sync())
-    iter = IPC::SyncMessage::GetDataIterator(&message);
-  else
-    iter = base::PickleIterator(message);
-
-  int64_t instance_id;
-  if (!iter.ReadInt64(&instance_id))
-    return -1;
-
-  return instance_id;
- }
-
 void ExtensionServerMessageFilter::RouteMessageToServer(
     const IPC::Message& message) {
-  int64_t id = GetInstanceIDFromMessage(message);
+  int64_t id = XWalkExtensionServer::GetInstanceIDFromMessage(message);
   DCHECK_NE(id, -1);
 
   XWalkExtensionServer* server;
   base::TaskRunner* task_runner;
   scoped_refptr<base::TaskRunner> task_runner_ref;
 
-  auto it = extension_thread_instances_ids_.find(id);
+  auto it = extension_thread_instances_.find(id);
 
-  if (it != extension_thread_instances_ids_.end()) {
+  if (it != extension_thread_instances_.end()) {
     server = extension_thread_server_;
-    task_runner = task_runner_.get();
+    task_runner_ref = it->second;
+    task_runner = task_runner_ref.get();
+
+    if (message.type() == XWalkExtensionServerMsg_DestroyInstance::ID)
+      extension_thread_instances_.erase(it);
   } else {
     server = ui_thread_server_;
     task_runner_ref =
@@ -124,21 +192,44 @@ void ExtensionServerMessageFilter::RouteMessageToServer(
     task_runner = task_runner_ref.get();
   }
 
-  base::Closure closure = base::Bind(
-      base::IgnoreResult(&XWalkExtensionServer::OnMessageReceived),
-      server->AsWeakPtr(), message);
+  base::Closure closure;
+  if (thread_pool_ && server == extension_thread_server_) {
+    // Weak pointers can't be used from several threads. The server is only
+    // deleted after the tasks posted to the pool, see
+    // XWalkExtensionThreadPool::DeleteServerSoon().
+    closure = base::Bind(
+        base::IgnoreResult(&XWalkExtensionServer::OnMessageReceived),
+        base::Unretained(server), message);
+  } else {
+    closure = base::Bind(
+        base::IgnoreResult(&XWalkExtensionServer::OnMessageReceived),
+        server->AsWeakPtr(), message);
+  }
 
-  task_runner->PostTask(FROM_HERE, closure);
+  if (server == extension_thread_server_)
+    PostExtensionThreadTask(task_runner, closure);
+  else
+    task_runner->PostTask(FROM_HERE, closure);
 }
 
 void ExtensionServerMessageFilter::OnCreateInstance(
     int64_t instance_id, std::string name) {
+  if (extension_thread_server_->ContainsExtension(name) && thread_pool_) {
+    scoped_refptr<base::SequencedTaskRunner> instance_task_runner =
+        thread_pool_->GetTaskRunnerForExtension(name);
+    extension_thread_instances_[instance_id] = instance_task_runner;
+    PostExtensionThreadTask(instance_task_runner.get(), base::Bind(
+        &XWalkExtensionServer::OnCreateInstance,
+        base::Unretained(extension_thread_server_), instance_id, name));
+    return;
+  }
+
   XWalkExtensionServer* server;
   base::TaskRunner* task_runner;
   scoped_refptr<base::TaskRunner> task_runner_ref;
 
   if (extension_thread_server_->ContainsExtension(name)) {
-    extension_thread_instances_ids_.insert(instance_id);
+    extension_thread_instances_[instance_id] = task_runner_;
     server = extension_thread_server_;
     task_runner = task_runner_.get();
   } else {
@@ -152,7 +243,10 @@ void ExtensionServerMessageFilter::OnCreateInstance(
       base::IgnoreResult(&XWalkExtensionServer::OnCreateInstance),
       server->AsWeakPtr(), instance_id, name);
 
-  task_runner->PostTask(FROM_HERE, closure);
+  if (server == extension_thread_server_)
+    PostExtensionThreadTask(task_runner, closure);
+  else
+    task_runner->PostTask(FROM_HERE, closure);
 }
 
 void ExtensionServerMessageFilter::OnGetExtensions(
@@ -203,6 +297,12 @@ XWalkExtensionService::XWalkExtensionService(Delegate* delegate)
   // IO main loop is needed by extensions watching file descriptors events.
   base::Thread::Options options(base::MessageLoop::TYPE_IO, 0);
   extension_thread_.StartWithOptions(options);
+
+  size_t num_worker_threads = GetNumberOfExtensionWorkerThreads();
+  if (num_worker_threads) {
+    extension_thread_pool_.reset(
+        new XWalkExtensionThreadPool(num_worker_threads));
+  }
 }
 
 XWalkExtensionService::~XWalkExtensionService() {
@@ -210,6 +310,8 @@ XWalkExtensionService::~XWalkExtensionService() {
   // extension thread.
   if (!extension_data_map_.empty())
     VLOG(1) << "The ExtensionData map is not empty!";
+
+  XWalkExtensionMetrics::GetInstance()->DumpSnapshot();
 }
 
 void XWalkExtensionService::RegisterExternalExtensionsForPath(
@@ -357,10 +459,20 @@ void XWalkExtensionService::CreateInProcessExtensionServers(
     RegisterExtensionsIntoServer(&extensions, extension_thread_server.get());
   }
 
+  // External extensions registered later on the FILE thread (see
+  // OnRenderProcessHostCreatedInternal()) would be missing from a registry
+  // published when the channel gets connected.
+  base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
+  bool publish_registry =
+      !cmd_line->HasSwitch(switches::kXWalkDisableExtensionProcess) ||
+      external_extensions_path_.empty();
+
   ExtensionServerMessageFilter* message_filter =
       new ExtensionServerMessageFilter(extension_thread_.task_runner(),
                                        extension_thread_server.get(),
-                                       ui_thread_server.get());
+                                       ui_thread_server.get(),
+                                       extension_thread_pool_.get(),
+                                       publish_registry);
 
   channel->AddFilter(message_filter);
 
@@ -370,6 +482,7 @@ void XWalkExtensionService::CreateInProcessExtensionServers(
   data->set_in_process_message_filter(message_filter);
 
   data->set_extension_thread(&extension_thread_);
+  data->set_extension_thread_pool(extension_thread_pool_.get());
 }
 
 void XWalkExtensionService::CreateExtensionProcessHost(
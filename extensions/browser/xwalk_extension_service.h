@@ -33,6 +33,7 @@ namespace extensions {
 class XWalkExtension;
 class XWalkExtensionData;
 class XWalkExtensionServer;
+class XWalkExtensionThreadPool;
 
 // This is the entry point for Crosswalk extensions. Its responsible for keeping
 // track of the extensions, and enable them on WebContents once they are
@@ -132,8 +133,10 @@ class XWalkExtensionService : public content::NotificationObserver,
       XWalkExtensionData* data, std::unique_ptr<base::DictionaryValue::DictStorage> runtime_variables);
 
   // The server that handles in process extensions will live in the
-  // extension_thread_.
+  // extension_thread_. When the worker threads switch is given, the
+  // instances of these extensions live on extension_thread_pool_ instead.
   base::Thread extension_thread_;
+  std::unique_ptr<XWalkExtensionThreadPool> extension_thread_pool_;
 
   content::NotificationRegistrar registrar_;
 
@@ -152,14 +155,23 @@ class XWalkExtensionService : public content::NotificationObserver,
 // task runner. Like other filters, this filter will run in the IO-thread.
 //
 // In the case of in process extensions, we will pass the task runner of the
-// extension thread.
+// extension thread. If |thread_pool| is given, the instances of the extension
+// thread server live on the pool thread of their extension instead, and their
+// messages are dispatched there.
+//
+// When the channel gets connected, the filter publishes the registry of the
+// extensions of both in process servers to the client, unless
+// |publish_registry| is false (e.g. when extensions are still to be
+// registered), in which case the client asks for them.
 class ExtensionServerMessageFilter : public IPC::MessageFilter,
   public IPC::Sender {
 public:
   ExtensionServerMessageFilter(
       scoped_refptr<base::SequencedTaskRunner> task_runner,
       XWalkExtensionServer* extension_thread_server,
-      XWalkExtensionServer* ui_thread_server);
+      XWalkExtensionServer* ui_thread_server,
+      XWalkExtensionThreadPool* thread_pool,
+      bool publish_registry);
 
   void Invalidate();
 
@@ -168,15 +180,16 @@ public:
 
 private:
   ~ExtensionServerMessageFilter() override;
-  int64_t GetInstanceIDFromMessage(const IPC::Message& message);
   void RouteMessageToServer(const IPC::Message& message);
   void OnCreateInstance(int64_t instance_id, std::string name);
   void OnGetExtensions(
       std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>* reply);
+  void SendRegistry(int32_t peer_pid);
 
   // IPC::ChannelProxy::MessageFilter implementation.
   void OnFilterAdded(IPC::Channel* channel) override;
   void OnFilterRemoved() override;
+  void OnChannelConnected(int32_t peer_pid) override;
   void OnChannelClosing() override;
   void OnChannelError() override;
   bool OnMessageReceived(const IPC::Message& message) override;
@@ -186,7 +199,13 @@ private:
   scoped_refptr<base::SequencedTaskRunner> task_runner_;
   XWalkExtensionServer* extension_thread_server_;
   XWalkExtensionServer* ui_thread_server_;
-  std::set<int64_t> extension_thread_instances_ids_;
+  XWalkExtensionThreadPool* thread_pool_;
+  bool publish_registry_;
+
+  // Task runners of the instances of the extension thread server.
+  typedef std::map<int64_t, scoped_refptr<base::SequencedTaskRunner>>
+      InstanceTaskRunnerMap;
+  InstanceTaskRunnerMap extension_thread_instances_;
 };
 
 }  // namespace extensions
@@ -0,0 +1,80 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/browser/xwalk_extension_thread_pool.h"
+
+#include "base/barrier_closure.h"
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/strings/stringprintf.h"
+#include "xwalk/extensions/common/xwalk_extension_server.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+void DeleteInstancesOnCurrentThread(XWalkExtensionServer* server,
+                                    const base::Closure& done) {
+  server->DeleteInstancesOnCurrentThread();
+  done.Run();
+}
+
+void DeleteServer(
+    XWalkExtensionServer* server,
+    scoped_refptr<base::SingleThreadTaskRunner> server_task_runner) {
+  server_task_runner->DeleteSoon(FROM_HERE, server);
+}
+
+}  // namespace
+
+XWalkExtensionThreadPool::XWalkExtensionThreadPool(size_t num_threads)
+    : next_thread_(0) {
+  DCHECK_GT(num_threads, 0u);
+
+  // IO main loop is needed by extensions watching file descriptors events.
+  base::Thread::Options options(base::MessageLoop::TYPE_IO, 0);
+  for (size_t i = 0; i < num_threads; ++i) {
+    std::unique_ptr<base::Thread> thread(new base::Thread(
+        base::StringPrintf("XWalkExtensionWorker%d", static_cast<int>(i))));
+    thread->StartWithOptions(options);
+    threads_.push_back(std::move(thread));
+  }
+}
+
+XWalkExtensionThreadPool::~XWalkExtensionThreadPool() {}
+
+scoped_refptr<base::SingleThreadTaskRunner>
+XWalkExtensionThreadPool::GetTaskRunnerForExtension(
+    const std::string& extension_name) {
+  base::AutoLock l(lock_);
+  auto it = extension_threads_.find(extension_name);
+  if (it == extension_threads_.end()) {
+    it = extension_threads_.insert(
+        std::make_pair(extension_name, next_thread_)).first;
+    next_thread_ = (next_thread_ + 1) % threads_.size();
+  }
+  return threads_[it->second]->task_runner();
+}
+
+void XWalkExtensionThreadPool::DeleteServerSoon(
+    std::unique_ptr<XWalkExtensionServer> server,
+    scoped_refptr<base::SingleThreadTaskRunner> server_task_runner) {
+  // The tasks already queued for the server run before the deletion of the
+  // instances, and the server is only deleted once every thread is done with
+  // its instances, so none of them can call back into a deleted server.
+  XWalkExtensionServer* raw_server = server.release();
+  base::Closure delete_server = base::BarrierClosure(
+      threads_.size(),
+      base::Bind(&DeleteServer, raw_server, server_task_runner));
+
+  for (const auto& thread : threads_) {
+    thread->task_runner()->PostTask(FROM_HERE, base::Bind(
+        &DeleteInstancesOnCurrentThread, raw_server, delete_server));
+  }
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,70 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_THREAD_POOL_H_
+#define XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_THREAD_POOL_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/single_thread_task_runner.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread.h"
+
+namespace xwalk {
+namespace extensions {
+
+class XWalkExtensionServer;
+
+// Set of threads shared by the in process extension instances of every render
+// process, used instead of the single XWalkExtensionThread when the
+// --xwalk-extension-worker-threads switch is given.
+//
+// Each extension is pinned to one of the threads the first time one of its
+// instances is created: XWalkExtension::CreateInstance() and every instance
+// of the extension, whatever the render process, run there. Extensions
+// don't need to be thread-safe, since their state is only ever touched from
+// that thread. The messages of an instance are posted to the thread's task
+// runner, so they are still handled in order, while different extensions run
+// in parallel. The threads run IO message loops, since extensions might watch
+// file descriptors or sockets.
+class XWalkExtensionThreadPool {
+ public:
+  explicit XWalkExtensionThreadPool(size_t num_threads);
+  ~XWalkExtensionThreadPool();
+
+  // Returns the task runner the instances of |extension_name| live on,
+  // picking the next thread for an extension seen for the first time. Can be
+  // called from any thread.
+  scoped_refptr<base::SingleThreadTaskRunner> GetTaskRunnerForExtension(
+      const std::string& extension_name);
+
+  // Deletes the instances |server| created on the pool threads, each on its
+  // own thread, and then |server| itself on |server_task_runner|. The server
+  // must be already invalidated, so no new tasks are posted for it.
+  void DeleteServerSoon(
+      std::unique_ptr<XWalkExtensionServer> server,
+      scoped_refptr<base::SingleThreadTaskRunner> server_task_runner);
+
+  size_t size() const { return threads_.size(); }
+
+ private:
+  std::vector<std::unique_ptr<base::Thread>> threads_;
+
+  base::Lock lock_;
+  // Index in |threads_| of the thread of every extension seen so far.
+  std::map<std::string, size_t> extension_threads_;
+  size_t next_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionThreadPool);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_THREAD_POOL_H_
@@ -0,0 +1,197 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/browser/xwalk_extension_thread_pool.h"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "base/values.h"
+#include "ipc/message_filter.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/extensions/browser/xwalk_extension_service.h"
+#include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_server.h"
+
+using xwalk::extensions::ExtensionServerMessageFilter;
+using xwalk::extensions::XWalkExtension;
+using xwalk::extensions::XWalkExtensionInstance;
+using xwalk::extensions::XWalkExtensionServer;
+using xwalk::extensions::XWalkExtensionThreadPool;
+
+namespace {
+
+void AppendValue(std::vector<int>* values, int value) {
+  values->push_back(value);
+}
+
+// What the instances of the routing test saw, filled from the pool threads.
+struct Recorder {
+  explicit Recorder(size_t expected_messages)
+      : expected_messages(expected_messages),
+        received_messages(0),
+        done(base::WaitableEvent::ResetPolicy::MANUAL,
+             base::WaitableEvent::InitialState::NOT_SIGNALED) {}
+
+  void Record(const std::string& extension, int instance, int value) {
+    base::AutoLock l(lock);
+    threads[extension].insert(base::PlatformThread::CurrentId());
+    if (value < 0)
+      return;
+    values[instance].push_back(value);
+    if (++received_messages == expected_messages)
+      done.Signal();
+  }
+
+  base::Lock lock;
+  // Threads each extension and its instances ran on.
+  std::map<std::string, std::set<base::PlatformThreadId>> threads;
+  // Messages received by each instance, in order.
+  std::map<int, std::vector<int>> values;
+  const size_t expected_messages;
+  size_t received_messages;
+  base::WaitableEvent done;
+};
+
+// Messages are "instance * 1000 + value".
+class RecordingInstance : public XWalkExtensionInstance {
+ public:
+  RecordingInstance(const std::string& extension, Recorder* recorder)
+      : extension_(extension), recorder_(recorder) {}
+
+  void HandleMessage(std::unique_ptr<base::Value> msg) override {
+    int value = -1;
+    ASSERT_TRUE(msg->GetAsInteger(&value));
+    recorder_->Record(extension_, value / 1000, value % 1000);
+  }
+
+ private:
+  std::string extension_;
+  Recorder* recorder_;
+};
+
+class RecordingExtension : public XWalkExtension {
+ public:
+  RecordingExtension(const std::string& name, Recorder* recorder)
+      : recorder_(recorder) {
+    set_name(name);
+  }
+
+  XWalkExtensionInstance* CreateInstance() override {
+    recorder_->Record(name(), 0, -1);
+    return new RecordingInstance(name(), recorder_);
+  }
+
+ private:
+  Recorder* recorder_;
+};
+
+}  // namespace
+
+TEST(XWalkExtensionThreadPoolTest, PinsExtensionsToThreads) {
+  XWalkExtensionThreadPool pool(3);
+  ASSERT_EQ(3u, pool.size());
+
+  const char* const kNames[] = { "a", "b", "c" };
+  std::set<base::SingleThreadTaskRunner*> task_runners;
+  for (const char* name : kNames)
+    task_runners.insert(pool.GetTaskRunnerForExtension(name).get());
+  EXPECT_EQ(pool.size(), task_runners.size());
+
+  // Every instance of an extension goes to the same thread.
+  EXPECT_EQ(pool.GetTaskRunnerForExtension("a"),
+            pool.GetTaskRunnerForExtension("a"));
+
+  // Once every thread has an extension, they start being shared.
+  EXPECT_EQ(1u, task_runners.count(pool.GetTaskRunnerForExtension("d").get()));
+}
+
+TEST(XWalkExtensionThreadPoolTest, PreservesOrderingPerInstance) {
+  XWalkExtensionThreadPool pool(2);
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner =
+      pool.GetTaskRunnerForExtension("a");
+
+  std::vector<int> values;
+  for (int i = 0; i < 100; ++i)
+    task_runner->PostTask(FROM_HERE, base::Bind(&AppendValue, &values, i));
+
+  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::MANUAL,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  task_runner->PostTask(FROM_HERE, base::Bind(&base::WaitableEvent::Signal,
+                                              base::Unretained(&done)));
+  done.Wait();
+
+  ASSERT_EQ(100u, values.size());
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(i, values[i]);
+}
+
+TEST(XWalkExtensionThreadPoolTest, FilterRoutesMessagesToExtensionThread) {
+  const int kMessagesPerInstance = 100;
+  // Instances 1 and 2 are of extension "a", 3 of extension "b".
+  const int kInstances = 3;
+  Recorder recorder(kInstances * kMessagesPerInstance);
+
+  // The server is deleted from this thread, so it must outlive the pool.
+  base::Thread server_thread("ServerThread");
+  ASSERT_TRUE(server_thread.Start());
+  XWalkExtensionThreadPool pool(2);
+
+  std::unique_ptr<XWalkExtensionServer> server(new XWalkExtensionServer);
+  ASSERT_TRUE(server->RegisterExtension(std::unique_ptr<XWalkExtension>(
+      new RecordingExtension("a", &recorder))));
+  ASSERT_TRUE(server->RegisterExtension(std::unique_ptr<XWalkExtension>(
+      new RecordingExtension("b", &recorder))));
+  std::unique_ptr<XWalkExtensionServer> ui_server(new XWalkExtensionServer);
+
+  scoped_refptr<ExtensionServerMessageFilter> filter(
+      new ExtensionServerMessageFilter(
+          scoped_refptr<base::SequencedTaskRunner>(), server.get(),
+          ui_server.get(), &pool, false));
+  IPC::MessageFilter* message_filter = filter.get();
+
+  for (int instance = 1; instance <= kInstances; ++instance) {
+    EXPECT_TRUE(message_filter->OnMessageReceived(
+        XWalkExtensionServerMsg_CreateInstance(instance,
+                                               instance < 3 ? "a" : "b")));
+  }
+  for (int i = 0; i < kMessagesPerInstance; ++i) {
+    for (int instance = 1; instance <= kInstances; ++instance) {
+      base::ListValue msg;
+      msg.AppendInteger(instance * 1000 + i);
+      EXPECT_TRUE(message_filter->OnMessageReceived(
+          XWalkExtensionServerMsg_PostMessageToNative(instance, msg)));
+    }
+  }
+  recorder.done.Wait();
+
+  {
+    base::AutoLock l(recorder.lock);
+    for (int instance = 1; instance <= kInstances; ++instance) {
+      const std::vector<int>& values = recorder.values[instance];
+      ASSERT_EQ(static_cast<size_t>(kMessagesPerInstance), values.size());
+      for (int i = 0; i < kMessagesPerInstance; ++i)
+        EXPECT_EQ(i, values[i]) << "instance " << instance;
+    }
+
+    // The instances of an extension never left its thread, and the two
+    // extensions were given different threads.
+    ASSERT_EQ(1u, recorder.threads["a"].size());
+    ASSERT_EQ(1u, recorder.threads["b"].size());
+    EXPECT_NE(*recorder.threads["a"].begin(), *recorder.threads["b"].begin());
+  }
+
+  filter->Invalidate();
+  pool.DeleteServerSoon(std::move(server), server_thread.task_runner());
+}
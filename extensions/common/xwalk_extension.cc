@@ -4,7 +4,9 @@
 
 #include "xwalk/extensions/common/xwalk_extension.h"
 
+#include "base/location.h"
 #include "base/logging.h"
+#include "base/threading/thread_task_runner_handle.h"
 
 namespace xwalk {
 namespace extensions {
@@ -41,7 +43,11 @@ bool XWalkExtension::RegisterPermissions(const char* perm_table) const {
   return permissions_delegate_->RegisterPermissions(name(), perm_table);
 }
 
-XWalkExtensionInstance::XWalkExtensionInstance() {}
+const size_t XWalkExtensionInstance::kMaxMessageBatchSize;
+
+XWalkExtensionInstance::XWalkExtensionInstance()
+    : message_batching_enabled_(false),
+      weak_factory_(this) {}
 
 XWalkExtensionInstance::~XWalkExtensionInstance() {}
 
@@ -50,15 +56,90 @@ void XWalkExtensionInstance::SetPostMessageCallback(
   post_message_ = callback;
 }
 
+void XWalkExtensionInstance::SetPostMessageBatchCallback(
+    const PostMessageBatchCallback& callback) {
+  post_message_batch_ = callback;
+}
+
+void XWalkExtensionInstance::SetPostBinaryMessageCallback(
+    const PostBinaryMessageCallback& callback) {
+  post_binary_message_ = callback;
+}
+
 void XWalkExtensionInstance::SetSendSyncReplyCallback(
     const SendSyncReplyCallback& callback) {
   send_sync_reply_ = callback;
 }
 
+void XWalkExtensionInstance::SetPostReplyCallback(
+    const PostReplyCallback& callback) {
+  post_reply_ = callback;
+}
+
+void XWalkExtensionInstance::PostMessageToJS(
+    std::unique_ptr<base::Value> msg) {
+  if (!message_batching_enabled_ || post_message_batch_.is_null()) {
+    post_message_.Run(std::move(msg));
+    return;
+  }
+
+  if (!pending_messages_) {
+    pending_messages_.reset(new base::ListValue);
+    base::ThreadTaskRunnerHandle::Get()->PostTask(FROM_HERE,
+        base::Bind(&XWalkExtensionInstance::FlushMessagesToJS,
+                   weak_factory_.GetWeakPtr()));
+  }
+
+  pending_messages_->Append(std::move(msg));
+  if (pending_messages_->GetSize() >= kMaxMessageBatchSize)
+    FlushMessagesToJS();
+}
+
+void XWalkExtensionInstance::FlushMessagesToJS() {
+  if (!pending_messages_)
+    return;
+
+  // A batch of one doesn't need the array wrapping.
+  if (pending_messages_->GetSize() == 1) {
+    std::unique_ptr<base::Value> msg;
+    pending_messages_->Remove(0, &msg);
+    pending_messages_.reset();
+    post_message_.Run(std::move(msg));
+    return;
+  }
+
+  post_message_batch_.Run(std::move(pending_messages_));
+}
+
+void XWalkExtensionInstance::SendRequestReplyToJS(
+    int request_id, std::unique_ptr<base::Value> reply) {
+  // Keep the reply ordered with the messages posted before it.
+  FlushMessagesToJS();
+  post_reply_.Run(request_id, std::move(reply));
+}
+
+void XWalkExtensionInstance::EnableMessageBatching() {
+  message_batching_enabled_ = true;
+}
+
+void XWalkExtensionInstance::HandleBinaryMessage(const char* data,
+                                                 size_t size) {
+  HandleMessage(std::unique_ptr<base::Value>(
+      base::BinaryValue::CreateWithCopiedBuffer(data, size)));
+}
+
 void XWalkExtensionInstance::HandleSyncMessage(
     std::unique_ptr<base::Value> msg) {
   LOG(FATAL) << "Sending sync message to extension which doesn't support it!";
 }
 
+void XWalkExtensionInstance::HandleRequest(int request_id,
+                                           std::unique_ptr<base::Value> msg) {
+#if TENTA_LOG_ENABLE == 1
+  LOG(WARNING) << "Sending request to extension which doesn't support it!";
+#endif
+  SendRequestReplyToJS(request_id, base::Value::CreateNullValue());
+}
+
 }  // namespace extensions
 }  // namespace xwalk
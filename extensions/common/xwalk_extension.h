@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 #include "base/callback.h"
+#include "base/memory/weak_ptr.h"
 #include "base/values.h"
 
 namespace xwalk {
@@ -105,39 +106,95 @@ class XWalkExtensionInstance {
   // process.
   virtual void HandleMessage(std::unique_ptr<base::Value> msg) = 0;
 
+  // Allow to handle binary messages (ArrayBuffer or ArrayBufferView contents)
+  // sent from JavaScript code. |data| is only valid during the call. The
+  // default implementation wraps the bytes in a base::BinaryValue and
+  // forwards it to HandleMessage().
+  virtual void HandleBinaryMessage(const char* data, size_t size);
+
   // Allow to handle synchronous messages sent from JavaScript code. Renderer
   // will block until SendSyncReplyToJS() is called with the reply. The reply
   // can be sent after HandleSyncMessage() function returns.
   virtual void HandleSyncMessage(std::unique_ptr<base::Value> msg);
 
+  // Allow to handle requests sent with 'extension.internal.sendRequest()'.
+  // Unlike sync messages, the renderer doesn't block, the reply is sent at
+  // any time later with SendRequestReplyToJS() and the same |request_id|.
+  // Several requests can be pending at once, and be replied in any order.
+  // The default implementation replies null.
+  virtual void HandleRequest(int request_id, std::unique_ptr<base::Value> msg);
+
   // Callbacks used by extension instance to communicate back to JS. These are
   // set by the extension system. Callbacks will take the ownership of the
   // message.
   typedef base::Callback<void(std::unique_ptr<base::Value> msg)> PostMessageCallback;
+  typedef base::Callback<void(std::unique_ptr<base::ListValue> msgs)>
+      PostMessageBatchCallback;
+  typedef base::Callback<void(const char* data, size_t size)>
+      PostBinaryMessageCallback;
   typedef base::Callback<void(std::unique_ptr<base::Value> msg)>
       SendSyncReplyCallback;
+  typedef base::Callback<void(int request_id,
+                              std::unique_ptr<base::Value> reply)>
+      PostReplyCallback;
 
   void SetPostMessageCallback(const PostMessageCallback& callback);
+  void SetPostMessageBatchCallback(const PostMessageBatchCallback& callback);
+  void SetPostBinaryMessageCallback(const PostBinaryMessageCallback& callback);
   void SetSendSyncReplyCallback(const SendSyncReplyCallback& callback);
+  void SetPostReplyCallback(const PostReplyCallback& callback);
 
   // Function to be used by extensions Instances to post messages back to
   // JavaScript in the renderer process. This function will take the ownership
   // of the message.
-  void PostMessageToJS(std::unique_ptr<base::Value> msg) {
-    post_message_.Run(std::move(msg));
+  void PostMessageToJS(std::unique_ptr<base::Value> msg);
+
+  // Posts |size| bytes from |data| to JavaScript, where they are received as
+  // an ArrayBuffer. The bytes are copied directly into the IPC message, so
+  // |data| doesn't need to outlive this call.
+  void PostBinaryMessageToJS(const char* data, size_t size) {
+    FlushMessagesToJS();
+    post_binary_message_.Run(data, size);
   }
 
+  // Resolves the promise returned by the 'extension.internal.sendRequest()'
+  // call identified by |request_id|.
+  void SendRequestReplyToJS(int request_id,
+                            std::unique_ptr<base::Value> reply);
+
+  // Sends right away the messages accumulated while batching is enabled.
+  void FlushMessagesToJS();
+
  protected:
   XWalkExtensionInstance();
 
   // Unblocks the renderer waiting on a SyncMessage.
   void SendSyncReplyToJS(std::unique_ptr<base::Value> reply) {
+    FlushMessagesToJS();
     send_sync_reply_.Run(std::move(reply));
   }
 
+  // Opt-in for chatty instances: messages posted with PostMessageToJS() are
+  // accumulated and sent as a single IPC, delivered to the JS message
+  // listener in one go. A batch is flushed once the current task is done, so
+  // it only gathers the messages posted by one task and adds no latency, or
+  // as soon as kMaxMessageBatchSize messages are pending. Only for instances
+  // posting messages from the thread they live on.
+  void EnableMessageBatching();
+
+  static const size_t kMaxMessageBatchSize = 256;
+
  private:
   PostMessageCallback post_message_;
+  PostMessageBatchCallback post_message_batch_;
+  PostBinaryMessageCallback post_binary_message_;
   SendSyncReplyCallback send_sync_reply_;
+  PostReplyCallback post_reply_;
+
+  bool message_batching_enabled_;
+  std::unique_ptr<base::ListValue> pending_messages_;
+
+  base::WeakPtrFactory<XWalkExtensionInstance> weak_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExtensionInstance);
 };
@@ -0,0 +1,41 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_binary_message.h"
+
+#include <limits>
+
+#include "base/pickle.h"
+#include "ipc/ipc_message.h"
+
+namespace xwalk {
+namespace extensions {
+
+IPC::Message* CreateBinaryMessage(uint32_t type, int64_t instance_id,
+                                  const char* data, size_t size) {
+  if (size > static_cast<size_t>(std::numeric_limits<int>::max()))
+    return NULL;
+
+  // Reserve the payload upfront so WriteData() doesn't need to grow (and
+  // copy) the message buffer while writing large blobs.
+  IPC::Message* message = new IPC::Message(
+      MSG_ROUTING_CONTROL, type, IPC::Message::PRIORITY_NORMAL);
+  message->Reserve(sizeof(int64_t) + sizeof(int) + size);
+  message->WriteInt64(instance_id);
+  message->WriteData(data, static_cast<int>(size));
+  return message;
+}
+
+bool ReadBinaryMessage(const IPC::Message& message, int64_t* instance_id,
+                       const char** data, size_t* size) {
+  base::PickleIterator iter(message);
+  int length = 0;
+  if (!iter.ReadInt64(instance_id) || !iter.ReadData(data, &length))
+    return false;
+  *size = static_cast<size_t>(length);
+  return true;
+}
+
+}  // namespace extensions
+}  // namespace xwalk
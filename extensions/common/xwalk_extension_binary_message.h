@@ -0,0 +1,39 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_BINARY_MESSAGE_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_BINARY_MESSAGE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace IPC {
+class Message;
+}
+
+namespace xwalk {
+namespace extensions {
+
+// Binary extension messages (XWalkExtensionServerMsg_PostBinaryMessageToNative
+// and XWalkExtensionClientMsg_PostBinaryMessageToJS) are laid out as an
+// int64_t instance id followed by a single data blob. They are built and read
+// with these helpers instead of the generated constructors and Read()
+// functions, so the payload goes straight from the sender's buffer into the
+// message and is handed to the receiver as a span pointing inside the message,
+// without any intermediate std::vector or base::BinaryValue copy.
+
+// Creates a control message of the given |type| carrying |size| bytes from
+// |data|. Returns NULL if |size| doesn't fit in an IPC message.
+IPC::Message* CreateBinaryMessage(uint32_t type, int64_t instance_id,
+                                  const char* data, size_t size);
+
+// Reads the instance id and payload of a binary message. |data| points into
+// |message| and is only valid as long as |message| is alive.
+bool ReadBinaryMessage(const IPC::Message& message, int64_t* instance_id,
+                       const char** data, size_t* size);
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_BINARY_MESSAGE_H_
@@ -0,0 +1,130 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_message_ring.h"
+
+#include <string.h>
+
+#include "base/atomicops.h"
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+// Lives at the beginning of the shared memory, the messages follow it. The
+// consumer writes to it, except when the producer rewinds an empty ring.
+struct RingHeader {
+  base::subtle::Atomic32 read_position;
+};
+
+// Keep the message buffer cache line aligned.
+const size_t kHeaderSize = 64;
+static_assert(sizeof(RingHeader) <= kHeaderSize, "RingHeader is too big");
+
+bool IsPowerOfTwo(uint32_t value) {
+  return value && !(value & (value - 1));
+}
+
+RingHeader* GetHeader(base::SharedMemory* shared_memory) {
+  return static_cast<RingHeader*>(shared_memory->memory());
+}
+
+}  // namespace
+
+const uint32_t XWalkExtensionMessageRing::kDefaultCapacity;
+
+XWalkExtensionMessageRing::XWalkExtensionMessageRing(
+    std::unique_ptr<base::SharedMemory> shared_memory, uint32_t capacity)
+    : shared_memory_(std::move(shared_memory)),
+      capacity_(capacity),
+      write_position_(0) {}
+
+XWalkExtensionMessageRing::~XWalkExtensionMessageRing() {}
+
+// static
+std::unique_ptr<XWalkExtensionMessageRing> XWalkExtensionMessageRing::Create(
+    uint32_t capacity) {
+  DCHECK(IsPowerOfTwo(capacity));
+  std::unique_ptr<base::SharedMemory> shared_memory(new base::SharedMemory);
+  if (!shared_memory->CreateAndMapAnonymous(kHeaderSize + capacity))
+    return std::unique_ptr<XWalkExtensionMessageRing>();
+
+  base::subtle::NoBarrier_Store(
+      &GetHeader(shared_memory.get())->read_position, 0);
+  return base::WrapUnique(
+      new XWalkExtensionMessageRing(std::move(shared_memory), capacity));
+}
+
+// static
+std::unique_ptr<XWalkExtensionMessageRing> XWalkExtensionMessageRing::Open(
+    base::SharedMemoryHandle handle, uint32_t capacity) {
+  std::unique_ptr<base::SharedMemory> shared_memory(
+      new base::SharedMemory(handle, false));
+  if (!IsPowerOfTwo(capacity) || !shared_memory->Map(kHeaderSize + capacity))
+    return std::unique_ptr<XWalkExtensionMessageRing>();
+
+  return base::WrapUnique(
+      new XWalkExtensionMessageRing(std::move(shared_memory), capacity));
+}
+
+bool XWalkExtensionMessageRing::ShareToProcess(
+    base::ProcessHandle process, base::SharedMemoryHandle* handle) {
+  return shared_memory_->ShareToProcess(process, handle);
+}
+
+char* XWalkExtensionMessageRing::buffer() const {
+  return static_cast<char*>(shared_memory_->memory()) + kHeaderSize;
+}
+
+bool XWalkExtensionMessageRing::Write(const char* data, uint32_t size,
+                                      uint32_t* position) {
+  uint32_t read_position = static_cast<uint32_t>(base::subtle::Acquire_Load(
+      &GetHeader(shared_memory_.get())->read_position));
+
+  // The header is writable by the other process, never trust it to be sane.
+  uint32_t used = write_position_ - read_position;
+  if (used > capacity_)
+    return false;
+
+  // Everything written was released, so there's no descriptor in flight and
+  // the consumer won't touch the header until the next message: start over
+  // from the beginning of the buffer rather than skipping its tail.
+  if (!used && write_position_) {
+    write_position_ = 0;
+    base::subtle::Release_Store(
+        &GetHeader(shared_memory_.get())->read_position, 0);
+  }
+
+  uint32_t offset = write_position_ & (capacity_ - 1);
+  uint32_t padding = (size > capacity_ - offset) ? capacity_ - offset : 0;
+  uint64_t needed = static_cast<uint64_t>(padding) + size;
+  if (needed > capacity_ - used)
+    return false;
+
+  write_position_ += padding;
+  memcpy(buffer() + (write_position_ & (capacity_ - 1)), data, size);
+  *position = write_position_;
+  write_position_ += size;
+  return true;
+}
+
+const char* XWalkExtensionMessageRing::Read(uint32_t position,
+                                            uint32_t size) const {
+  uint32_t offset = position & (capacity_ - 1);
+  if (size > capacity_ - offset)
+    return NULL;
+  return buffer() + offset;
+}
+
+void XWalkExtensionMessageRing::Release(uint32_t position, uint32_t size) {
+  base::subtle::Release_Store(
+      &GetHeader(shared_memory_.get())->read_position,
+      static_cast<base::subtle::Atomic32>(position + size));
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,85 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_RING_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_RING_H_
+
+#include <stdint.h>
+#include <memory>
+
+#include "base/macros.h"
+#include "base/memory/shared_memory.h"
+#include "base/process/process_handle.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Long-lived shared memory ring used to deliver messages too big to be sent
+// inline through the IPC channel. There's exactly one producer (an
+// XWalkExtensionServer) and one consumer (the XWalkExtensionClient on the
+// other side of the channel).
+//
+// The producer copies the serialized message into the ring and sends only a
+// (position, size) descriptor through IPC. The consumer reads the message in
+// place and, once done with it, publishes the end of the message as its read
+// position in the ring header so the producer can reuse the space. Positions
+// are free running 32-bit counters, the capacity being a power of two keeps
+// them consistent across wrap arounds.
+//
+// A message is always stored contiguously: if it doesn't fit before the end
+// of the buffer, the tail is skipped and the message starts over at offset
+// zero. Once the consumer caught up with everything written, the producer
+// rewinds both positions to zero so the whole buffer is free again. When
+// there's not enough free space, Write() fails and the caller is expected to
+// fall back to a one-off shared memory segment.
+class XWalkExtensionMessageRing {
+ public:
+  static const uint32_t kDefaultCapacity = 8 * 1024 * 1024;
+
+  ~XWalkExtensionMessageRing();
+
+  // Producer side: creates and maps a new ring able to hold |capacity| bytes
+  // of messages. |capacity| must be a power of two.
+  static std::unique_ptr<XWalkExtensionMessageRing> Create(uint32_t capacity);
+
+  // Consumer side: maps a ring shared by the producer.
+  static std::unique_ptr<XWalkExtensionMessageRing> Open(
+      base::SharedMemoryHandle handle, uint32_t capacity);
+
+  // Duplicates the ring handle for |process|. The consumer needs write access
+  // to the header, so the handle isn't read-only.
+  bool ShareToProcess(base::ProcessHandle process,
+                      base::SharedMemoryHandle* handle);
+
+  // Producer side: copies |size| bytes from |data| into the ring, returning
+  // in |position| where it was stored. Returns false if there's no room.
+  bool Write(const char* data, uint32_t size, uint32_t* position);
+
+  // Consumer side: returns a pointer to the message stored at |position|, or
+  // NULL if the descriptor is invalid. The pointer is valid until Release().
+  const char* Read(uint32_t position, uint32_t size) const;
+  void Release(uint32_t position, uint32_t size);
+
+  uint32_t capacity() const { return capacity_; }
+
+ private:
+  XWalkExtensionMessageRing(std::unique_ptr<base::SharedMemory> shared_memory,
+                            uint32_t capacity);
+
+  char* buffer() const;
+
+  std::unique_ptr<base::SharedMemory> shared_memory_;
+  uint32_t capacity_;
+
+  // Only used by the producer, the consumer gets positions from the
+  // descriptors.
+  uint32_t write_position_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionMessageRing);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_RING_H_
@@ -76,10 +76,59 @@ IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostMessageToJS,  // NOLINT(*)
                      int64_t /* instance id */,
                      base::ListValue /* contents */)
 
+// Messages accumulated by an instance with batching enabled, see
+// XWalkExtensionInstance::EnableMessageBatching().
+IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostMessageBatchToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     base::ListValue /* messages */)
+
+// Binary messages carry ArrayBuffer contents as a raw byte span. They are
+// written and read in place with the helpers in
+// xwalk_extension_binary_message.h, the std::vector<char> below only
+// describes the wire format (and is what the logging traits use).
+IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_PostBinaryMessageToNative,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     std::vector<char> /* contents */)
+
+IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostBinaryMessageToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     std::vector<char> /* contents */)
+
 IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostOutOfLineMessageToJS,  // NOLINT(*)
                      base::SharedMemoryHandle /* message buffer */,
                      uint64_t /* buffer size */)
 
+// Hands the client the shared memory ring used by the server to deliver big
+// messages. Sent once per server when the channel gets connected.
+IPC_MESSAGE_CONTROL3(XWalkExtensionClientMsg_SetupMessageRing,  // NOLINT(*)
+                     int /* ring id */,
+                     base::SharedMemoryHandle /* ring buffer */,
+                     uint32_t /* ring capacity */)
+
+// Hands the client the read-only registry of the extensions of the server,
+// see XWalkExtensionRegistry. Sent once when the channel gets connected.
+IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_SetupRegistry,  // NOLINT(*)
+                     base::SharedMemoryHandle /* registry */,
+                     uint32_t /* registry size */)
+
+// A serialized client message stored in place in a message ring.
+IPC_MESSAGE_CONTROL3(XWalkExtensionClientMsg_PostRingMessageToJS,  // NOLINT(*)
+                     int /* ring id */,
+                     uint32_t /* position */,
+                     uint32_t /* size */)
+
+// Asynchronous replacement for SendSyncMessageToNative: the renderer doesn't
+// block, the reply comes back later tagged with the same request id.
+IPC_MESSAGE_CONTROL3(XWalkExtensionServerMsg_PostRequestToNative,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int /* request id */,
+                     base::ListValue /* contents */)
+
+IPC_MESSAGE_CONTROL3(XWalkExtensionClientMsg_PostReplyToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int /* request id */,
+                     base::ListValue /* contents */)
+
 IPC_SYNC_MESSAGE_CONTROL2_1(XWalkExtensionServerMsg_SendSyncMessageToNative,  // NOLINT(*)
                             int64_t /* instance id */,
                             base::ListValue /* input contents */,
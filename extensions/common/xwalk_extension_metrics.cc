@@ -0,0 +1,232 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_metrics.h"
+
+#include <algorithm>
+
+#include "base/command_line.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/threading/thread_restrictions.h"
+#include "base/trace_event/trace_event.h"
+#include "base/values.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
+
+namespace xwalk {
+namespace extensions {
+
+const char kXWalkExtensionTraceCategory[] = "xwalk.extensions";
+
+namespace {
+
+base::LazyInstance<XWalkExtensionMetrics>::Leaky g_metrics =
+    LAZY_INSTANCE_INITIALIZER;
+
+// base::Value has no 64-bit integers, counters are exported as doubles.
+double ToDouble(uint64_t value) {
+  return static_cast<double>(value);
+}
+
+}  // namespace
+
+const size_t XWalkExtensionMetrics::LatencyHistogram::kBucketCount;
+
+XWalkExtensionMetrics::LatencyHistogram::LatencyHistogram()
+    : count_(0),
+      total_us_(0),
+      max_us_(0) {
+  std::fill(buckets_, buckets_ + kBucketCount, 0);
+}
+
+void XWalkExtensionMetrics::LatencyHistogram::Add(base::TimeDelta sample) {
+  int64_t us = std::max<int64_t>(sample.InMicroseconds(), 0);
+  size_t bucket = 0;
+  while (bucket < kBucketCount - 1 && us >= (int64_t(2) << bucket))
+    ++bucket;
+
+  ++count_;
+  total_us_ += us;
+  max_us_ = std::max(max_us_, us);
+  ++buckets_[bucket];
+}
+
+std::unique_ptr<base::DictionaryValue>
+XWalkExtensionMetrics::LatencyHistogram::ToValue() const {
+  std::unique_ptr<base::DictionaryValue> value(new base::DictionaryValue);
+  value->SetDouble("count", ToDouble(count_));
+  value->SetDouble("mean_us",
+                   count_ ? static_cast<double>(total_us_) / count_ : 0);
+  value->SetDouble("max_us", static_cast<double>(max_us_));
+
+  std::unique_ptr<base::ListValue> buckets(new base::ListValue);
+  for (size_t i = 0; i < kBucketCount; ++i)
+    buckets->AppendDouble(ToDouble(buckets_[i]));
+  value->Set("buckets", std::move(buckets));
+  return value;
+}
+
+XWalkExtensionMetrics::Extension::Extension(const std::string& name)
+    : name_(name),
+      messages_counter_name_("ExtensionMessages:" + name),
+      bytes_counter_name_("ExtensionBytes:" + name),
+      messages_to_native_(0),
+      bytes_to_native_(0),
+      messages_to_js_(0),
+      bytes_to_js_(0),
+      out_of_line_messages_(0),
+      sync_messages_(0) {}
+
+XWalkExtensionMetrics::Extension::~Extension() {}
+
+void XWalkExtensionMetrics::Extension::RecordMessageToNative(
+    size_t bytes, base::TimeDelta handler_time) {
+  base::AutoLock l(lock_);
+  ++messages_to_native_;
+  bytes_to_native_ += bytes;
+  handler_time_.Add(handler_time);
+  TraceCounters();
+}
+
+void XWalkExtensionMetrics::Extension::RecordMessageToJS(size_t bytes,
+                                                         bool out_of_line) {
+  base::AutoLock l(lock_);
+  ++messages_to_js_;
+  bytes_to_js_ += bytes;
+  if (out_of_line)
+    ++out_of_line_messages_;
+  TraceCounters();
+}
+
+void XWalkExtensionMetrics::Extension::RecordSyncReply(
+    size_t bytes, base::TimeDelta block_time) {
+  base::AutoLock l(lock_);
+  ++messages_to_js_;
+  bytes_to_js_ += bytes;
+  ++sync_messages_;
+  sync_block_time_.Add(block_time);
+  TraceCounters();
+}
+
+void XWalkExtensionMetrics::Extension::TraceCounters() {
+  lock_.AssertAcquired();
+  TRACE_COUNTER2(kXWalkExtensionTraceCategory,
+                 messages_counter_name_.c_str(),
+                 "to_native", messages_to_native_,
+                 "to_js", messages_to_js_);
+  TRACE_COUNTER2(kXWalkExtensionTraceCategory,
+                 bytes_counter_name_.c_str(),
+                 "to_native", bytes_to_native_,
+                 "to_js", bytes_to_js_);
+}
+
+std::unique_ptr<base::DictionaryValue>
+XWalkExtensionMetrics::Extension::ToValue() const {
+  base::AutoLock l(lock_);
+  std::unique_ptr<base::DictionaryValue> value(new base::DictionaryValue);
+  value->SetDouble("messages_to_native", ToDouble(messages_to_native_));
+  value->SetDouble("bytes_to_native", ToDouble(bytes_to_native_));
+  value->SetDouble("messages_to_js", ToDouble(messages_to_js_));
+  value->SetDouble("bytes_to_js", ToDouble(bytes_to_js_));
+  value->SetDouble("out_of_line_messages", ToDouble(out_of_line_messages_));
+  value->SetDouble("sync_messages", ToDouble(sync_messages_));
+  value->Set("handler_time", handler_time_.ToValue());
+  value->Set("sync_block_time", sync_block_time_.ToValue());
+  return value;
+}
+
+XWalkExtensionMetrics::XWalkExtensionMetrics()
+    : enabled_(base::CommandLine::InitializedForCurrentProcess() &&
+               base::CommandLine::ForCurrentProcess()->HasSwitch(
+                   switches::kXWalkExtensionMetrics)),
+      queue_depth_(0),
+      max_queue_depth_(0) {}
+
+XWalkExtensionMetrics::~XWalkExtensionMetrics() {}
+
+// static
+XWalkExtensionMetrics* XWalkExtensionMetrics::GetInstance() {
+  return g_metrics.Pointer();
+}
+
+XWalkExtensionMetrics::Extension* XWalkExtensionMetrics::GetExtension(
+    const std::string& extension_name) {
+  base::AutoLock l(extensions_lock_);
+  std::unique_ptr<Extension>& extension = extensions_[extension_name];
+  if (!extension)
+    extension.reset(new Extension(extension_name));
+  return extension.get();
+}
+
+void XWalkExtensionMetrics::OnTaskQueued() {
+  base::subtle::Atomic32 depth =
+      base::subtle::NoBarrier_AtomicIncrement(&queue_depth_, 1);
+
+  base::subtle::Atomic32 max_depth =
+      base::subtle::NoBarrier_Load(&max_queue_depth_);
+  while (depth > max_depth) {
+    base::subtle::Atomic32 previous = base::subtle::NoBarrier_CompareAndSwap(
+        &max_queue_depth_, max_depth, depth);
+    if (previous == max_depth)
+      break;
+    max_depth = previous;
+  }
+
+  TRACE_COUNTER1(kXWalkExtensionTraceCategory, "ExtensionThreadQueueDepth",
+                 depth);
+}
+
+void XWalkExtensionMetrics::OnTaskStarted() {
+  base::subtle::Atomic32 depth =
+      base::subtle::NoBarrier_AtomicIncrement(&queue_depth_, -1);
+  TRACE_COUNTER1(kXWalkExtensionTraceCategory, "ExtensionThreadQueueDepth",
+                 depth);
+}
+
+std::unique_ptr<base::DictionaryValue> XWalkExtensionMetrics::GetSnapshot() {
+  std::unique_ptr<base::DictionaryValue> snapshot(new base::DictionaryValue);
+  snapshot->SetInteger("queue_depth",
+                       base::subtle::NoBarrier_Load(&queue_depth_));
+  snapshot->SetInteger("max_queue_depth",
+                       base::subtle::NoBarrier_Load(&max_queue_depth_));
+
+  std::unique_ptr<base::DictionaryValue> extensions(new base::DictionaryValue);
+  {
+    base::AutoLock l(extensions_lock_);
+    for (const auto& it : extensions_)
+      extensions->SetWithoutPathExpansion(it.first, it.second->ToValue());
+  }
+  snapshot->Set("extensions", std::move(extensions));
+  return snapshot;
+}
+
+void XWalkExtensionMetrics::DumpSnapshot() {
+  if (!enabled_)
+    return;
+
+  std::string json;
+  base::JSONWriter::WriteWithOptions(
+      *GetSnapshot(), base::JSONWriter::OPTIONS_PRETTY_PRINT, &json);
+
+  base::FilePath path = base::CommandLine::ForCurrentProcess()->
+      GetSwitchValuePath(switches::kXWalkExtensionMetrics);
+  if (path.empty()) {
+    LOG(INFO) << "Extension metrics: " << json;
+    return;
+  }
+
+  // Only done once, when the extension service goes away.
+  base::ThreadRestrictions::ScopedAllowIO allow_io;
+  if (base::WriteFile(path, json.data(), json.size()) !=
+      static_cast<int>(json.size())) {
+#if TENTA_LOG_ENABLE == 1
+    LOG(WARNING) << "Can't write extension metrics to " << path.value();
+#endif
+  }
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,148 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_METRICS_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_METRICS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "base/atomicops.h"
+#include "base/lazy_instance.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+
+namespace base {
+class DictionaryValue;
+}
+
+namespace xwalk {
+namespace extensions {
+
+// Trace category of the extension events and counters.
+extern const char kXWalkExtensionTraceCategory[];
+
+// Process wide runtime metrics of the extension servers, aggregated per
+// extension name over all its instances: messages and bytes in each
+// direction, out of line messages, time spent in the handlers and time the
+// renderer stays blocked on sync messages. Also tracks how many tasks are
+// waiting to run on the in process extension threads.
+//
+// Nothing is recorded unless --xwalk-extension-metrics is given, so the
+// servers don't pay for the locking otherwise. Everything can be updated and
+// read from any thread. While the app runs, the message and byte counts of
+// every extension are emitted as trace counters under
+// kXWalkExtensionTraceCategory, along with the extension thread queue depth.
+// GetSnapshot() has everything, histograms included, and DumpSnapshot()
+// writes it out where the switch says on shutdown.
+class XWalkExtensionMetrics {
+ public:
+  // Exponential histogram of durations: bucket i counts the samples below
+  // 2^(i+1) microseconds not counted by the previous buckets, the last one
+  // gets everything else.
+  class LatencyHistogram {
+   public:
+    static const size_t kBucketCount = 22;
+
+    LatencyHistogram();
+
+    void Add(base::TimeDelta sample);
+    std::unique_ptr<base::DictionaryValue> ToValue() const;
+
+    uint64_t count() const { return count_; }
+    int64_t max_us() const { return max_us_; }
+
+   private:
+    uint64_t count_;
+    int64_t total_us_;
+    int64_t max_us_;
+    uint64_t buckets_[kBucketCount];
+  };
+
+  // Metrics of all the instances of one extension.
+  class Extension {
+   public:
+    explicit Extension(const std::string& name);
+    ~Extension();
+
+    const std::string& name() const { return name_; }
+
+    void RecordMessageToNative(size_t bytes, base::TimeDelta handler_time);
+    void RecordMessageToJS(size_t bytes, bool out_of_line);
+    void RecordSyncReply(size_t bytes, base::TimeDelta block_time);
+
+    std::unique_ptr<base::DictionaryValue> ToValue() const;
+
+   private:
+    // Emits the counts as trace counters, |lock_| must be held.
+    void TraceCounters();
+
+    const std::string name_;
+    // Names of the trace counters, which must outlive the trace.
+    const std::string messages_counter_name_;
+    const std::string bytes_counter_name_;
+
+    mutable base::Lock lock_;
+    uint64_t messages_to_native_;
+    uint64_t bytes_to_native_;
+    uint64_t messages_to_js_;
+    uint64_t bytes_to_js_;
+    uint64_t out_of_line_messages_;
+    uint64_t sync_messages_;
+    LatencyHistogram handler_time_;
+    LatencyHistogram sync_block_time_;
+
+    DISALLOW_COPY_AND_ASSIGN(Extension);
+  };
+
+  static XWalkExtensionMetrics* GetInstance();
+
+  // Whether --xwalk-extension-metrics was given. Callers check it before
+  // recording anything.
+  static bool IsEnabled() { return GetInstance()->enabled_; }
+  void set_enabled_for_testing(bool enabled) { enabled_ = enabled; }
+
+  // Returns the metrics of |extension_name|, created on first use. The
+  // pointer is valid for the whole life of the process.
+  Extension* GetExtension(const std::string& extension_name);
+
+  // Called when a task is posted to, and when it starts running on, the in
+  // process extension threads.
+  void OnTaskQueued();
+  void OnTaskStarted();
+
+  // Returns a dictionary with the metrics of every extension, keyed by name,
+  // and the current and maximum depth of the extension thread queue.
+  std::unique_ptr<base::DictionaryValue> GetSnapshot();
+
+  // Writes GetSnapshot() as JSON to the file given to
+  // --xwalk-extension-metrics, or to the log if there's none. Does nothing
+  // when the metrics are disabled.
+  void DumpSnapshot();
+
+ private:
+  XWalkExtensionMetrics();
+  ~XWalkExtensionMetrics();
+
+  friend struct base::DefaultLazyInstanceTraits<XWalkExtensionMetrics>;
+
+  bool enabled_;
+
+  base::Lock extensions_lock_;
+  std::map<std::string, std::unique_ptr<Extension>> extensions_;
+
+  base::subtle::Atomic32 queue_depth_;
+  base::subtle::Atomic32 max_queue_depth_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionMetrics);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_METRICS_H_
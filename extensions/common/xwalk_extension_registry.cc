@@ -0,0 +1,92 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_registry.h"
+
+#include <string.h>
+
+#include "base/hash.h"
+#include "base/lazy_instance.h"
+#include "base/pickle.h"
+#include "base/synchronization/lock.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+struct PublishedRegistries {
+  base::Lock lock;
+  std::vector<std::unique_ptr<XWalkExtensionRegistry>> registries;
+};
+
+base::LazyInstance<PublishedRegistries>::Leaky g_published_registries =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+XWalkExtensionRegistry::XWalkExtensionRegistry(
+    std::unique_ptr<base::SharedMemory> shared_memory, uint32_t size,
+    uint32_t hash)
+    : shared_memory_(std::move(shared_memory)),
+      size_(size),
+      hash_(hash) {}
+
+XWalkExtensionRegistry::~XWalkExtensionRegistry() {}
+
+// static
+XWalkExtensionRegistry* XWalkExtensionRegistry::Publish(
+    const ExtensionList& extensions) {
+  base::Pickle pickle;
+  IPC::WriteParam(&pickle, extensions);
+  uint32_t size = static_cast<uint32_t>(pickle.size());
+  uint32_t hash = base::Hash(static_cast<const char*>(pickle.data()), size);
+
+  PublishedRegistries* published = g_published_registries.Pointer();
+  base::AutoLock l(published->lock);
+  for (const auto& registry : published->registries) {
+    if (registry->Equals(pickle.data(), size, hash))
+      return registry.get();
+  }
+
+  base::SharedMemoryCreateOptions options;
+  options.size = size;
+  options.share_read_only = true;
+  std::unique_ptr<base::SharedMemory> shared_memory(new base::SharedMemory);
+  if (!shared_memory->Create(options) || !shared_memory->Map(size))
+    return NULL;
+  memcpy(shared_memory->memory(), pickle.data(), size);
+
+  published->registries.push_back(std::unique_ptr<XWalkExtensionRegistry>(
+      new XWalkExtensionRegistry(std::move(shared_memory), size, hash)));
+  return published->registries.back().get();
+}
+
+// static
+bool XWalkExtensionRegistry::Read(base::SharedMemoryHandle handle,
+                                  uint32_t size, ExtensionList* extensions) {
+  base::SharedMemory shared_memory(handle, true);
+  if (!shared_memory.Map(size))
+    return false;
+
+  base::Pickle pickle(static_cast<const char*>(shared_memory.memory()),
+                      static_cast<int>(size));
+  base::PickleIterator iter(pickle);
+  return IPC::ReadParam(&pickle, &iter, extensions);
+}
+
+bool XWalkExtensionRegistry::ShareToProcess(base::ProcessHandle process,
+                                            base::SharedMemoryHandle* handle) {
+  return shared_memory_->ShareReadOnlyToProcess(process, handle);
+}
+
+bool XWalkExtensionRegistry::Equals(const void* data, uint32_t size,
+                                    uint32_t hash) const {
+  return hash_ == hash && size_ == size &&
+         !memcmp(shared_memory_->memory(), data, size);
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,70 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_REGISTRY_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_REGISTRY_H_
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/shared_memory.h"
+#include "base/process/process_handle.h"
+
+struct XWalkExtensionServerMsg_ExtensionRegisterParams;
+
+namespace xwalk {
+namespace extensions {
+
+// The list of extensions (names, JS APIs and entry points) of a server,
+// serialized once into read-only shared memory and mapped by every client
+// that talks to a server with the same extensions. It replaces the
+// synchronous XWalkExtensionServerMsg_GetExtensions call that used to copy
+// all the JS API sources through IPC for every render process.
+//
+// The list is serialized with the IPC param traits of
+// XWalkExtensionServerMsg_ExtensionRegisterParams, so the layout follows the
+// message definition.
+class XWalkExtensionRegistry {
+ public:
+  typedef std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>
+      ExtensionList;
+
+  // Returns a registry holding |extensions|, reusing one published before
+  // with exactly the same contents. Registries are published for the whole
+  // life of the process, there's one per distinct list of extensions. Can be
+  // called from any thread. Returns NULL if the shared memory can't be
+  // created.
+  static XWalkExtensionRegistry* Publish(const ExtensionList& extensions);
+
+  ~XWalkExtensionRegistry();
+
+  // Client side: maps the registry shared as |handle| and reads the list of
+  // extensions from it. The handle is closed in any case.
+  static bool Read(base::SharedMemoryHandle handle, uint32_t size,
+                   ExtensionList* extensions);
+
+  bool ShareToProcess(base::ProcessHandle process,
+                      base::SharedMemoryHandle* handle);
+
+  uint32_t size() const { return size_; }
+
+ private:
+  XWalkExtensionRegistry(std::unique_ptr<base::SharedMemory> shared_memory,
+                         uint32_t size, uint32_t hash);
+
+  bool Equals(const void* data, uint32_t size, uint32_t hash) const;
+
+  std::unique_ptr<base::SharedMemory> shared_memory_;
+  uint32_t size_;
+  uint32_t hash_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionRegistry);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_REGISTRY_H_
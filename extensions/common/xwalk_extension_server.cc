@@ -4,17 +4,25 @@
 
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
+#include "base/atomic_sequence_num.h"
 #include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
+#include "base/memory/ptr_util.h"
 #include "base/memory/shared_memory.h"
+#include "base/process/process.h"
 #include "base/strings/string16.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/stl_util.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/trace_event/trace_event.h"
 #include "content/public/browser/render_process_host.h"
 #include "ipc/ipc_message.h"
 #include "ipc/ipc_sender.h"
+#include "ipc/ipc_sync_message.h"
+#include "xwalk/extensions/common/xwalk_extension_binary_message.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_registry.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 
 namespace xwalk {
@@ -23,15 +31,65 @@ namespace extensions {
 // Threshold to determine using shared memory or message
 const size_t kInlineMessageMaxSize = 256 * 1024;
 
+namespace {
+
+// Ring ids only need to be unique among the servers talking to the same
+// client, using a process wide sequence is the simplest way to get that.
+base::StaticAtomicSequenceNumber g_next_message_ring_id;
+
+}  // namespace
+
 XWalkExtensionServer::XWalkExtensionServer()
     : channel_proxy_(NULL),
+      _peer_pid(base::kNullProcessId),
+      message_ring_id_(0),
+      message_ring_failed_(false),
+      ring_message_count_(0),
+      shared_memory_message_count_(0),
       permissions_delegate_(NULL) {}
 
 XWalkExtensionServer::~XWalkExtensionServer() {
   DeleteInstanceMap();
 }
 
+// static
+int64_t XWalkExtensionServer::GetInstanceIDFromMessage(
+    const IPC::Message& message) {
+  base::PickleIterator iter;
+
+  if (message.is_sync())
+    iter = IPC::SyncMessage::GetDataIterator(&message);
+  else
+    iter = base::PickleIterator(message);
+
+  int64_t instance_id;
+  if (!iter.ReadInt64(&instance_id))
+    return -1;
+
+  return instance_id;
+}
+
 bool XWalkExtensionServer::OnMessageReceived(const IPC::Message& message) {
+  // The instance is only looked up when something needs it.
+  bool tracing;
+  TRACE_EVENT_CATEGORY_GROUP_ENABLED(kXWalkExtensionTraceCategory, &tracing);
+  XWalkExtensionMetrics::Extension* metrics = NULL;
+  std::string extension_name;
+  if (tracing || XWalkExtensionMetrics::IsEnabled()) {
+    InstanceExecutionData* data =
+        GetInstanceData(GetInstanceIDFromMessage(message));
+    if (data) {
+      metrics = data->metrics;
+      extension_name = data->extension_name;
+    }
+  }
+
+  TRACE_EVENT2(kXWalkExtensionTraceCategory,
+               "XWalkExtensionServer::OnMessageReceived",
+               "extension", extension_name,
+               "size", message.size());
+  base::TimeTicks start = base::TimeTicks::Now();
+
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionServer, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_CreateInstance,
@@ -40,21 +98,101 @@ bool XWalkExtensionServer::OnMessageReceived(const IPC::Message& message) {
         OnDestroyInstance)
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_PostMessageToNative,
         OnPostMessageToNative)
+    IPC_MESSAGE_HANDLER_GENERIC(
+        XWalkExtensionServerMsg_PostBinaryMessageToNative,
+        OnPostBinaryMessageToNative(message))
     IPC_MESSAGE_HANDLER_DELAY_REPLY(
         XWalkExtensionServerMsg_SendSyncMessageToNative,
         OnSendSyncMessageToNative)
+    IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_PostRequestToNative,
+        OnPostRequestToNative)
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_GetExtensions,
         OnGetExtensions)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
 
+  if (metrics) {
+    metrics->RecordMessageToNative(message.size(),
+                                   base::TimeTicks::Now() - start);
+  }
+
   return handled;
 }
 
 void XWalkExtensionServer::OnChannelConnected(int32_t peer_pid) {
+  SetPeerProcess(peer_pid);
+  SendRegistry();
+}
+
+void XWalkExtensionServer::SetPeerProcess(int32_t peer_pid) {
+  base::AutoLock l(instances_lock_);
   _peer_pid = peer_pid;
 }
 
+int32_t XWalkExtensionServer::GetPeerProcess() {
+  base::AutoLock l(instances_lock_);
+  return _peer_pid;
+}
+
+void XWalkExtensionServer::SendRegistry() {
+  std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams> extensions;
+  OnGetExtensions(&extensions);
+
+  // On failure the client falls back to asking for the extensions.
+  XWalkExtensionRegistry* registry =
+      XWalkExtensionRegistry::Publish(extensions);
+  base::Process process =
+      base::Process::OpenWithExtraPrivileges(GetPeerProcess());
+  base::SharedMemoryHandle handle;
+  if (!registry || !process.IsValid() ||
+      !registry->ShareToProcess(process.Handle(), &handle)) {
+#if TENTA_LOG_ENABLE == 1
+    LOG(WARNING) << "Can't share extension registry";
+#endif
+    return;
+  }
+
+  Send(new XWalkExtensionClientMsg_SetupRegistry(handle, registry->size()));
+}
+
+void XWalkExtensionServer::SetupMessageRing() {
+  message_ring_lock_.AssertAcquired();
+  DCHECK(!message_ring_);
+  // Don't try again for every big message if it failed once.
+  int32_t peer_pid = GetPeerProcess();
+  if (message_ring_failed_ || peer_pid == base::kNullProcessId)
+    return;
+  message_ring_failed_ = true;
+
+  std::unique_ptr<XWalkExtensionMessageRing> ring =
+      XWalkExtensionMessageRing::Create(
+          XWalkExtensionMessageRing::kDefaultCapacity);
+  if (!ring) {
+#if TENTA_LOG_ENABLE == 1
+    LOG(WARNING) << "Can't create shared memory ring for out of line messages";
+#endif
+    return;
+  }
+
+  base::Process process = base::Process::OpenWithExtraPrivileges(peer_pid);
+  base::SharedMemoryHandle handle;
+  if (!process.IsValid() || !ring->ShareToProcess(process.Handle(), &handle)) {
+#if TENTA_LOG_ENABLE == 1
+    LOG(WARNING) << "Can't share memory ring for out of line messages";
+#endif
+    return;
+  }
+
+  int ring_id = g_next_message_ring_id.GetNext() + 1;
+  if (!Send(new XWalkExtensionClientMsg_SetupMessageRing(ring_id, handle,
+                                                         ring->capacity())))
+    return;
+
+  message_ring_id_ = ring_id;
+  message_ring_ = std::move(ring);
+  message_ring_failed_ = false;
+}
+
 void XWalkExtensionServer::OnCreateInstance(int64_t instance_id,
     std::string name) {
   ExtensionMap::const_iterator it = extensions_.find(name);
@@ -80,21 +218,48 @@ void XWalkExtensionServer::OnCreateInstance(int64_t instance_id,
       base::Bind(&XWalkExtensionServer::PostMessageToJSCallback,
                  base::Unretained(this), instance_id));
 
+  instance->SetPostMessageBatchCallback(
+      base::Bind(&XWalkExtensionServer::PostMessageBatchToJSCallback,
+                 base::Unretained(this), instance_id));
+
+  instance->SetPostBinaryMessageCallback(
+      base::Bind(&XWalkExtensionServer::PostBinaryMessageToJSCallback,
+                 base::Unretained(this), instance_id));
+
   instance->SetSendSyncReplyCallback(
       base::Bind(&XWalkExtensionServer::SendSyncReplyToJSCallback,
                  base::Unretained(this), instance_id));
 
+  instance->SetPostReplyCallback(
+      base::Bind(&XWalkExtensionServer::PostReplyToJSCallback,
+                 base::Unretained(this), instance_id));
+
   InstanceExecutionData data;
   data.instance = instance;
   data.pending_reply = NULL;
+  if (base::ThreadTaskRunnerHandle::IsSet())
+    data.task_runner = base::ThreadTaskRunnerHandle::Get();
+  data.extension_name = name;
+  data.metrics = XWalkExtensionMetrics::IsEnabled() ?
+      XWalkExtensionMetrics::GetInstance()->GetExtension(name) : NULL;
 
+  base::AutoLock l(instances_lock_);
   instances_[instance_id] = data;
 }
 
+XWalkExtensionServer::InstanceExecutionData*
+XWalkExtensionServer::GetInstanceData(int64_t instance_id) {
+  base::AutoLock l(instances_lock_);
+  InstanceMap::iterator it = instances_.find(instance_id);
+  if (it == instances_.end())
+    return NULL;
+  return &it->second;
+}
+
 void XWalkExtensionServer::OnPostMessageToNative(int64_t instance_id,
     const base::ListValue& msg) {
-  InstanceMap::const_iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
+  InstanceExecutionData* data = GetInstanceData(instance_id);
+  if (!data) {
 #if TENTA_LOG_ENABLE == 1
     LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
                  << instance_id;
@@ -102,8 +267,6 @@ void XWalkExtensionServer::OnPostMessageToNative(int64_t instance_id,
     return;
   }
 
-  const InstanceExecutionData& data = it->second;
-
   // The const_cast is needed to remove the only Value contained by the
   // ListValue (which is solely used as wrapper, since Value doesn't
   // have param traits for serialization) and we pass the ownership to to
@@ -112,7 +275,32 @@ void XWalkExtensionServer::OnPostMessageToNative(int64_t instance_id,
   // can be costly depending on the size of Value.
   std::unique_ptr<base::Value> value;
   const_cast<base::ListValue*>(&msg)->Remove(0, &value);
-  data.instance->HandleMessage(std::move(value));
+  data->instance->HandleMessage(std::move(value));
+}
+
+void XWalkExtensionServer::OnPostBinaryMessageToNative(
+    const IPC::Message& message) {
+  int64_t instance_id;
+  const char* data;
+  size_t size;
+  if (!ReadBinaryMessage(message, &instance_id, &data, &size)) {
+#if TENTA_LOG_ENABLE == 1
+    LOG(WARNING) << "Can't read binary message sent to Extension.";
+#endif
+    return;
+  }
+
+  InstanceExecutionData* instance_data = GetInstanceData(instance_id);
+  if (!instance_data) {
+#if TENTA_LOG_ENABLE == 1
+    LOG(WARNING) << "Can't PostBinaryMessage to invalid Extension instance id: "
+                 << instance_id;
+#endif
+    return;
+  }
+
+  // |data| points inside |message|, which outlives the call.
+  instance_data->instance->HandleBinaryMessage(data, size);
 }
 
 void XWalkExtensionServer::Initialize(IPC::ChannelProxy* channelProxy) {
@@ -212,30 +400,103 @@ void XWalkExtensionServer::PostMessageToJSCallback(
   base::ListValue wrapped_msg;
   wrapped_msg.Append(msg.release());
 
-  std::unique_ptr<IPC::Message> message(
-      new XWalkExtensionClientMsg_PostMessageToJS(instance_id, wrapped_msg));
-  if (message->size() <= kInlineMessageMaxSize) {
+  SendMessageToJS(instance_id, base::WrapUnique(
+      new XWalkExtensionClientMsg_PostMessageToJS(instance_id, wrapped_msg)));
+}
+
+void XWalkExtensionServer::PostMessageBatchToJSCallback(
+    int64_t instance_id, std::unique_ptr<base::ListValue> msgs) {
+  SendMessageToJS(instance_id, base::WrapUnique(
+      new XWalkExtensionClientMsg_PostMessageBatchToJS(instance_id, *msgs)));
+}
+
+void XWalkExtensionServer::PostReplyToJSCallback(
+    int64_t instance_id, int request_id, std::unique_ptr<base::Value> reply) {
+  base::ListValue wrapped_reply;
+  wrapped_reply.Append(reply.release());
+
+  SendMessageToJS(instance_id, base::WrapUnique(new XWalkExtensionClientMsg_PostReplyToJS(
+      instance_id, request_id, wrapped_reply)));
+}
+
+void XWalkExtensionServer::PostBinaryMessageToJSCallback(
+    int64_t instance_id, const char* data, size_t size) {
+  std::unique_ptr<IPC::Message> message(CreateBinaryMessage(
+      XWalkExtensionClientMsg_PostBinaryMessageToJS::ID, instance_id,
+      data, size));
+  if (!message) {
+#if TENTA_LOG_ENABLE == 1
+    LOG(WARNING) << "Binary message of " << size << " bytes is too big to be "
+                 << "posted to JS.";
+#endif
+    return;
+  }
+  SendMessageToJS(instance_id, std::move(message));
+}
+
+void XWalkExtensionServer::SendMessageToJS(
+    int64_t instance_id, std::unique_ptr<IPC::Message> message) {
+  bool out_of_line = message->size() > kInlineMessageMaxSize;
+  if (XWalkExtensionMetrics::IsEnabled()) {
+    InstanceExecutionData* data = GetInstanceData(instance_id);
+    if (data && data->metrics)
+      data->metrics->RecordMessageToJS(message->size(), out_of_line);
+  }
+
+  if (!out_of_line) {
     Send(message.release());
     return;
   }
 
+  if (SendMessageThroughRing(*message)) {
+    base::subtle::NoBarrier_AtomicIncrement(&ring_message_count_, 1);
+    return;
+  }
+
+  // The ring is full (or the message is bigger than it), use a dedicated
+  // segment for this message.
+  SendMessageThroughSharedMemory(*message);
+  base::subtle::NoBarrier_AtomicIncrement(&shared_memory_message_count_, 1);
+}
+
+bool XWalkExtensionServer::SendMessageThroughRing(
+    const IPC::Message& message) {
+  base::AutoLock l(message_ring_lock_);
+  // Most clients never get a big message, the ring is only created for the
+  // first one.
+  if (!message_ring_)
+    SetupMessageRing();
+  if (!message_ring_)
+    return false;
+
+  uint32_t position;
+  if (!message_ring_->Write(static_cast<const char*>(message.data()),
+                            message.size(), &position))
+    return false;
+
+  return Send(new XWalkExtensionClientMsg_PostRingMessageToJS(
+      message_ring_id_, position, message.size()));
+}
+
+void XWalkExtensionServer::SendMessageThroughSharedMemory(
+    const IPC::Message& message) {
   base::SharedMemoryCreateOptions options;
-  options.size = message->size();
+  options.size = message.size();
   options.share_read_only = true;
 
   base::SharedMemory shared_memory;
-  if (!shared_memory.Create(options) || !shared_memory.Map(message->size())) {
+  if (!shared_memory.Create(options) || !shared_memory.Map(message.size())) {
 #if TENTA_LOG_ENABLE == 1
     LOG(WARNING) << "Can't create shared memory to send out of line message";
 #endif
     return;
   }
 
-  memcpy(shared_memory.memory(), message->data(), message->size());
+  memcpy(shared_memory.memory(), message.data(), message.size());
 
   base::SharedMemoryHandle handle;
   base::Process process =
-      base::Process::OpenWithExtraPrivileges(_peer_pid);
+      base::Process::OpenWithExtraPrivileges(GetPeerProcess());
   CHECK(process.IsValid());
   if (!shared_memory.GiveReadOnlyToProcess(process.Handle(), &handle)) {
 #if TENTA_LOG_ENABLE == 1
@@ -245,14 +506,14 @@ void XWalkExtensionServer::PostMessageToJSCallback(
   }
 
   Send(new XWalkExtensionClientMsg_PostOutOfLineMessageToJS(handle,
-                                                            message->size()));
+                                                            message.size()));
 }
 
 void XWalkExtensionServer::SendSyncReplyToJSCallback(
     int64_t instance_id, std::unique_ptr<base::Value> reply) {
 
-  InstanceMap::iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
+  InstanceExecutionData* data = GetInstanceData(instance_id);
+  if (!data) {
 #if TENTA_LOG_ENABLE == 1
     LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
                  << instance_id;
@@ -260,8 +521,7 @@ void XWalkExtensionServer::SendSyncReplyToJSCallback(
     return;
   }
 
-  InstanceExecutionData& data = it->second;
-  if (!data.pending_reply) {
+  if (!data->pending_reply) {
 #if TENTA_LOG_ENABLE == 1
     LOG(WARNING) << "There's no pending SyncMessage for instance id: "
                  << instance_id;
@@ -272,13 +532,41 @@ void XWalkExtensionServer::SendSyncReplyToJSCallback(
   base::ListValue wrapped_reply;
   wrapped_reply.Append(reply.release());
   XWalkExtensionServerMsg_SendSyncMessageToNative::WriteReplyParams(
-      data.pending_reply, wrapped_reply);
-  Send(data.pending_reply);
+      data->pending_reply, wrapped_reply);
+  if (data->metrics) {
+    data->metrics->RecordSyncReply(
+        data->pending_reply->size(),
+        base::TimeTicks::Now() - data->pending_reply_time);
+  }
+  Send(data->pending_reply);
 
-  data.pending_reply = NULL;
+  data->pending_reply = NULL;
+}
+
+void XWalkExtensionServer::DeleteInstancesOnCurrentThread() {
+  InstanceMap instances;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceMap::iterator it = instances_.begin();
+    while (it != instances_.end()) {
+      const InstanceExecutionData& data = it->second;
+      if (data.task_runner && data.task_runner->BelongsToCurrentThread()) {
+        instances.insert(*it);
+        it = instances_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  for (auto& it : instances) {
+    delete it.second.instance;
+    delete it.second.pending_reply;
+  }
 }
 
 void XWalkExtensionServer::DeleteInstanceMap() {
+  base::AutoLock l(instances_lock_);
   InstanceMap::iterator it = instances_.begin();
   int pending_replies_left = 0;
 
@@ -321,8 +609,8 @@ bool XWalkExtensionServer::ValidateExtensionEntryPoints(
 
 void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
     const base::ListValue& msg, IPC::Message* ipc_reply) {
-  InstanceMap::iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
+  InstanceExecutionData* data = GetInstanceData(instance_id);
+  if (!data) {
 #if TENTA_LOG_ENABLE == 1
     LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
                  << instance_id;
@@ -330,8 +618,7 @@ void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
     return;
   }
 
-  InstanceExecutionData& data = it->second;
-  if (data.pending_reply) {
+  if (data->pending_reply) {
 #if TENTA_LOG_ENABLE == 1
     LOG(WARNING) << "There's already a pending Sync Message for "
                  << "Extension instance id: " << instance_id;
@@ -339,7 +626,8 @@ void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
     return;
   }
 
-  data.pending_reply = ipc_reply;
+  data->pending_reply = ipc_reply;
+  data->pending_reply_time = base::TimeTicks::Now();
 
   // The const_cast is needed to remove the only Value contained by the
   // ListValue (which is solely used as wrapper, since Value doesn't
@@ -349,24 +637,45 @@ void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
   // can be costly depending on the size of Value.
   std::unique_ptr<base::Value> value;
   const_cast<base::ListValue*>(&msg)->Remove(0, &value);
-  XWalkExtensionInstance* instance = data.instance;
+  XWalkExtensionInstance* instance = data->instance;
 
   instance->HandleSyncMessage(std::move(value));
 }
 
-void XWalkExtensionServer::OnDestroyInstance(int64_t instance_id) {
-  InstanceMap::iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
+void XWalkExtensionServer::OnPostRequestToNative(int64_t instance_id,
+    int request_id, const base::ListValue& msg) {
+  InstanceExecutionData* data = GetInstanceData(instance_id);
+  if (!data) {
 #if TENTA_LOG_ENABLE == 1
-    LOG(WARNING) << "Can't destroy inexistent instance:" << instance_id;
+    LOG(WARNING) << "Can't PostRequest to invalid Extension instance id: "
+                 << instance_id;
 #endif
     return;
   }
 
-  InstanceExecutionData& data = it->second;
+  // See OnPostMessageToNative() about the const_cast.
+  std::unique_ptr<base::Value> value;
+  const_cast<base::ListValue*>(&msg)->Remove(0, &value);
+  data->instance->HandleRequest(request_id, std::move(value));
+}
+
+void XWalkExtensionServer::OnDestroyInstance(int64_t instance_id) {
+  InstanceExecutionData data;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceMap::iterator it = instances_.find(instance_id);
+    if (it == instances_.end()) {
+#if TENTA_LOG_ENABLE == 1
+      LOG(WARNING) << "Can't destroy inexistent instance:" << instance_id;
+#endif
+      return;
+    }
+
+    data = it->second;
+    instances_.erase(it);
+  }
 
   delete data.instance;
-  instances_.erase(it);
 
   Send(new XWalkExtensionClientMsg_InstanceDestroyed(instance_id));
 }
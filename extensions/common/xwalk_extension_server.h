@@ -11,13 +11,18 @@
 #include <string>
 #include <vector>
 
+#include "base/atomicops.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/shared_memory.h"
 #include "base/memory/weak_ptr.h"
+#include "base/single_thread_task_runner.h"
 #include "base/synchronization/lock.h"
 #include "base/values.h"
 #include "ipc/ipc_channel_proxy.h"
 #include "ipc/ipc_listener.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_message_ring.h"
+#include "xwalk/extensions/common/xwalk_extension_metrics.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 
 struct XWalkExtensionServerMsg_ExtensionRegisterParams;
@@ -54,6 +59,12 @@ class XWalkExtensionServer : public IPC::Listener,
   bool OnMessageReceived(const IPC::Message& message) override;
   void OnChannelConnected(int32_t peer_pid) override;
 
+  // Used instead of OnChannelConnected() for the servers that are not the
+  // listener of their channel (in process servers). Unlike it, doesn't
+  // publish the extension registry, the message filter publishes a single
+  // registry for all of them.
+  void SetPeerProcess(int32_t peer_pid);
+
   // Different types of ExtensionServers are initialized with different
   // permission delegates: For out-of-process extensions the extension
   // process act as the delegate and dispatch permission request through
@@ -63,11 +74,29 @@ class XWalkExtensionServer : public IPC::Listener,
   void Initialize(IPC::ChannelProxy* channelProxy);
   bool Send(IPC::Message* msg);
 
+  // All the messages to an instance start with its id. Returns -1 if
+  // |message| doesn't have one.
+  static int64_t GetInstanceIDFromMessage(const IPC::Message& message);
+
   bool RegisterExtension(std::unique_ptr<XWalkExtension> extension);
   bool ContainsExtension(const std::string& extension_name) const;
 
   void Invalidate();
 
+  // Deletes the instances that were created on the current thread. Used when
+  // the in process instances are spread over several threads, so each of
+  // them is deleted where it lives before the server goes away.
+  void DeleteInstancesOnCurrentThread();
+
+  // Number of messages to JS that went out of line, through the ring or
+  // through a dedicated shared memory segment when it didn't fit.
+  int ring_message_count() const {
+    return base::subtle::NoBarrier_Load(&ring_message_count_);
+  }
+  int shared_memory_message_count() const {
+    return base::subtle::NoBarrier_Load(&shared_memory_message_count_);
+  }
+
   void set_permissions_delegate(XWalkExtension::PermissionsDelegate* delegate) {
     permissions_delegate_ = delegate;
   }
@@ -85,20 +114,60 @@ class XWalkExtensionServer : public IPC::Listener,
   struct InstanceExecutionData {
     XWalkExtensionInstance* instance;
     IPC::Message* pending_reply;
+    // Thread the instance was created on, it is not necessarily the same for
+    // all the instances of a server.
+    scoped_refptr<base::SingleThreadTaskRunner> task_runner;
+    // Name of the extension, for the trace events.
+    std::string extension_name;
+    XWalkExtensionMetrics::Extension* metrics;
+    // When the pending sync message was received.
+    base::TimeTicks pending_reply_time;
   };
 
   // Message Handlers
   void OnDestroyInstance(int64_t instance_id);
   void OnPostMessageToNative(int64_t instance_id, const base::ListValue& msg);
+  void OnPostBinaryMessageToNative(const IPC::Message& message);
   void OnSendSyncMessageToNative(int64_t instance_id,
       const base::ListValue& msg, IPC::Message* ipc_reply);
+  void OnPostRequestToNative(int64_t instance_id, int request_id,
+                             const base::ListValue& msg);
 
   void PostMessageToJSCallback(int64_t instance_id,
                                std::unique_ptr<base::Value> msg);
 
+  void PostMessageBatchToJSCallback(int64_t instance_id,
+                                    std::unique_ptr<base::ListValue> msgs);
+
+  void PostBinaryMessageToJSCallback(int64_t instance_id,
+                                     const char* data, size_t size);
+
+  // Sends |message| to the client, through shared memory if it is too big to
+  // be sent inline.
+  void SendMessageToJS(int64_t instance_id,
+                       std::unique_ptr<IPC::Message> message);
+  bool SendMessageThroughRing(const IPC::Message& message);
+  void SendMessageThroughSharedMemory(const IPC::Message& message);
+
+  // Creates the ring and hands it to the client, |message_ring_lock_| must
+  // be held.
+  void SetupMessageRing();
+  // The peer process id is set on the extension thread and read from the
+  // threads sending to JS.
+  int32_t GetPeerProcess();
+  void SendRegistry();
+
   void SendSyncReplyToJSCallback(int64_t instance_id,
                                  std::unique_ptr<base::Value> reply);
 
+  void PostReplyToJSCallback(int64_t instance_id, int request_id,
+                             std::unique_ptr<base::Value> reply);
+
+  // Returns NULL if there's no instance with |instance_id|. The data is only
+  // touched on the instance thread, the pointer stays valid until the
+  // instance is destroyed.
+  InstanceExecutionData* GetInstanceData(int64_t instance_id);
+
   void DeleteInstanceMap();
 
   bool ValidateExtensionEntryPoints(
@@ -106,12 +175,27 @@ class XWalkExtensionServer : public IPC::Listener,
 
   base::Lock channel_proxy_lock_;
   IPC::ChannelProxy* channel_proxy_;
+  // Guarded by |instances_lock_|.
   int32_t _peer_pid;
 
+  // Ring used for messages bigger than kInlineMessageMaxSize, created along
+  // with the first of them. The lock serializes writing to the ring and
+  // sending the descriptor, so the client always releases space in ring
+  // order.
+  base::Lock message_ring_lock_;
+  std::unique_ptr<XWalkExtensionMessageRing> message_ring_;
+  int message_ring_id_;
+  bool message_ring_failed_;
+  base::subtle::Atomic32 ring_message_count_;
+  base::subtle::Atomic32 shared_memory_message_count_;
+
   typedef std::map<std::string, std::unique_ptr<XWalkExtension>> ExtensionMap;
   ExtensionMap extensions_;
 
+  // Instances might be created and destroyed from different threads, the
+  // lock protects the map itself, not the instances.
   typedef std::map<int64_t, InstanceExecutionData> InstanceMap;
+  base::Lock instances_lock_;
   InstanceMap instances_;
 
   // The exported symbols for extensions already registered.
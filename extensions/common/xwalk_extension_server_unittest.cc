@@ -4,7 +4,18 @@
 
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
+#include <memory>
+#include <string>
+
+#include "base/process/process_handle.h"
+#include "base/values.h"
+#include "ipc/ipc_message.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/extensions/common/xwalk_extension_binary_message.h"
+#include "xwalk/extensions/common/xwalk_extension_message_ring.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_metrics.h"
+#include "xwalk/extensions/common/xwalk_extension_registry.h"
 
 using xwalk::extensions::ValidateExtensionNameForTesting;
 
@@ -41,3 +52,176 @@ TEST(XWalkExtensionServerTest, ValidateExtensionName) {
         << "Extension name should be invalid: " << invalid_names[i];
   }
 }
+
+TEST(XWalkExtensionServerTest, BinaryMessageRoundTrip) {
+  using xwalk::extensions::CreateBinaryMessage;
+  using xwalk::extensions::ReadBinaryMessage;
+
+  const std::string payload("\0binary\xff payload", 17);
+  std::unique_ptr<IPC::Message> message(CreateBinaryMessage(
+      XWalkExtensionServerMsg_PostBinaryMessageToNative::ID, 42,
+      payload.data(), payload.size()));
+  ASSERT_TRUE(message);
+  EXPECT_EQ(XWalkExtensionServerMsg_PostBinaryMessageToNative::ID,
+            message->type());
+
+  int64_t instance_id = 0;
+  const char* data = NULL;
+  size_t size = 0;
+  ASSERT_TRUE(ReadBinaryMessage(*message, &instance_id, &data, &size));
+  EXPECT_EQ(42, instance_id);
+  EXPECT_EQ(payload, std::string(data, size));
+
+  // The payload must be readable by the generated traits as well.
+  XWalkExtensionServerMsg_PostBinaryMessageToNative::Param params;
+  ASSERT_TRUE(
+      XWalkExtensionServerMsg_PostBinaryMessageToNative::Read(message.get(),
+                                                              &params));
+  EXPECT_EQ(payload, std::string(std::get<1>(params).begin(),
+                                 std::get<1>(params).end()));
+}
+
+TEST(XWalkExtensionServerTest, MessageRingReusesSpace) {
+  using xwalk::extensions::XWalkExtensionMessageRing;
+
+  const uint32_t kCapacity = 64;
+  std::unique_ptr<XWalkExtensionMessageRing> ring =
+      XWalkExtensionMessageRing::Create(kCapacity);
+  ASSERT_TRUE(ring);
+
+  const std::string first(40, 'a');
+  const std::string second(30, 'b');
+  uint32_t first_position;
+  uint32_t second_position;
+  ASSERT_TRUE(ring->Write(first.data(), first.size(), &first_position));
+
+  // Doesn't fit until the first message is released.
+  EXPECT_FALSE(ring->Write(second.data(), second.size(), &second_position));
+
+  const char* data = ring->Read(first_position, first.size());
+  ASSERT_TRUE(data);
+  EXPECT_EQ(first, std::string(data, first.size()));
+  ring->Release(first_position, first.size());
+
+  // The tail is too small, so the second message wraps around to the start.
+  ASSERT_TRUE(ring->Write(second.data(), second.size(), &second_position));
+  EXPECT_EQ(0u, second_position % kCapacity);
+  data = ring->Read(second_position, second.size());
+  ASSERT_TRUE(data);
+  EXPECT_EQ(second, std::string(data, second.size()));
+
+  // Descriptors crossing the end of the buffer are rejected.
+  EXPECT_FALSE(ring->Read(kCapacity - 8, 16));
+}
+
+TEST(XWalkExtensionServerTest, MessageRingRewindsOnceDrained) {
+  using xwalk::extensions::XWalkExtensionMessageRing;
+
+  const uint32_t kCapacity = 64;
+  std::unique_ptr<XWalkExtensionMessageRing> ring =
+      XWalkExtensionMessageRing::Create(kCapacity);
+  ASSERT_TRUE(ring);
+
+  // Many times the capacity goes through the ring, each message landing
+  // where the previous one would leave no room for it without a rewind.
+  const std::string message(50, 'a');
+  for (int i = 0; i < 100; ++i) {
+    uint32_t position;
+    ASSERT_TRUE(ring->Write(message.data(), message.size(), &position)) << i;
+    EXPECT_EQ(0u, position);
+    const char* data = ring->Read(position, message.size());
+    ASSERT_TRUE(data);
+    EXPECT_EQ(message, std::string(data, message.size()));
+    ring->Release(position, message.size());
+  }
+
+  // Unreleased messages are never overwritten.
+  uint32_t first_position;
+  uint32_t second_position;
+  ASSERT_TRUE(ring->Write(message.data(), message.size(), &first_position));
+  EXPECT_FALSE(ring->Write(message.data(), message.size(), &second_position));
+}
+
+TEST(XWalkExtensionServerTest, ExtensionRegistryRoundTrip) {
+  using xwalk::extensions::XWalkExtensionRegistry;
+
+  XWalkExtensionRegistry::ExtensionList extensions(1);
+  extensions[0].name = "registry";
+  extensions[0].js_api = "exports.value = 1;";
+  extensions[0].entry_points.push_back("registry.entry");
+
+  XWalkExtensionRegistry* registry = XWalkExtensionRegistry::Publish(
+      extensions);
+  ASSERT_TRUE(registry);
+
+  // Render processes with the same extensions share the same registry.
+  EXPECT_EQ(registry, XWalkExtensionRegistry::Publish(extensions));
+
+  base::SharedMemoryHandle handle;
+  ASSERT_TRUE(registry->ShareToProcess(base::GetCurrentProcessHandle(),
+                                       &handle));
+  XWalkExtensionRegistry::ExtensionList read_extensions;
+  ASSERT_TRUE(XWalkExtensionRegistry::Read(handle, registry->size(),
+                                           &read_extensions));
+  ASSERT_EQ(1u, read_extensions.size());
+  EXPECT_EQ(extensions[0].name, read_extensions[0].name);
+  EXPECT_EQ(extensions[0].js_api, read_extensions[0].js_api);
+  EXPECT_EQ(extensions[0].entry_points, read_extensions[0].entry_points);
+}
+
+TEST(XWalkExtensionServerTest, MetricsAreAggregatedPerExtension) {
+  using xwalk::extensions::XWalkExtensionMetrics;
+
+  XWalkExtensionMetrics* metrics = XWalkExtensionMetrics::GetInstance();
+  XWalkExtensionMetrics::Extension* extension =
+      metrics->GetExtension("metrics");
+  EXPECT_EQ(extension, metrics->GetExtension("metrics"));
+
+  extension->RecordMessageToNative(100, base::TimeDelta::FromMicroseconds(3));
+  extension->RecordMessageToNative(50, base::TimeDelta::FromMilliseconds(2));
+  extension->RecordMessageToJS(1024 * 1024, true);
+  extension->RecordSyncReply(10, base::TimeDelta::FromMicroseconds(1));
+
+  std::unique_ptr<base::DictionaryValue> snapshot = metrics->GetSnapshot();
+  const base::DictionaryValue* value;
+  ASSERT_TRUE(snapshot->GetDictionary("extensions.metrics", &value));
+
+  double number;
+  EXPECT_TRUE(value->GetDouble("messages_to_native", &number));
+  EXPECT_EQ(2, number);
+  EXPECT_TRUE(value->GetDouble("bytes_to_native", &number));
+  EXPECT_EQ(150, number);
+  EXPECT_TRUE(value->GetDouble("messages_to_js", &number));
+  EXPECT_EQ(2, number);
+  EXPECT_TRUE(value->GetDouble("out_of_line_messages", &number));
+  EXPECT_EQ(1, number);
+  EXPECT_TRUE(value->GetDouble("sync_messages", &number));
+  EXPECT_EQ(1, number);
+  EXPECT_TRUE(value->GetDouble("handler_time.max_us", &number));
+  EXPECT_EQ(2000, number);
+
+  // 3us falls in [2, 4), 2000us in [1024, 2048).
+  const base::ListValue* buckets;
+  ASSERT_TRUE(value->GetList("handler_time.buckets", &buckets));
+  ASSERT_EQ(XWalkExtensionMetrics::LatencyHistogram::kBucketCount,
+            buckets->GetSize());
+  EXPECT_TRUE(buckets->GetDouble(1, &number));
+  EXPECT_EQ(1, number);
+  EXPECT_TRUE(buckets->GetDouble(10, &number));
+  EXPECT_EQ(1, number);
+}
+
+TEST(XWalkExtensionServerTest, GetInstanceIDFromMessage) {
+  using xwalk::extensions::XWalkExtensionServer;
+
+  base::ListValue args;
+  XWalkExtensionServerMsg_PostMessageToNative message(42, args);
+  EXPECT_EQ(42, XWalkExtensionServer::GetInstanceIDFromMessage(message));
+
+  IPC::Message empty;
+  EXPECT_EQ(-1, XWalkExtensionServer::GetInstanceIDFromMessage(empty));
+}
+
+TEST(XWalkExtensionServerTest, MetricsAreDisabledByDefault) {
+  EXPECT_FALSE(xwalk::extensions::XWalkExtensionMetrics::IsEnabled());
+}
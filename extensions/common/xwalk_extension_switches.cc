@@ -26,4 +26,14 @@ const char kXWalkExtensionCmdPrefix[] = "xwalk-extension-cmd-prefix";
 // Disable XWalkExtensionSystem and all extensions
 const char kXWalkDisableExtensions[] = "disable-xwalk-extensions";
 
+// Runs the in process extensions on a pool of threads instead of a single
+// extension thread, each extension on one of them. Takes the number of
+// threads, defaults to the number of processors.
+const char kXWalkExtensionWorkerThreads[] = "xwalk-extension-worker-threads";
+
+// Records the runtime metrics of the in process extensions, and writes them as
+// JSON to the given file, or to the log if there's none, when the extension
+// service goes away.
+const char kXWalkExtensionMetrics[] = "xwalk-extension-metrics";
+
 }  // namespace switches
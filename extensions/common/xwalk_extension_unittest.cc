@@ -0,0 +1,183 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::extensions::XWalkExtensionInstance;
+
+namespace {
+
+class TestInstance : public XWalkExtensionInstance {
+ public:
+  TestInstance() {
+    SetPostMessageCallback(base::Bind(&TestInstance::OnPostMessage,
+                                      base::Unretained(this)));
+    SetPostMessageBatchCallback(base::Bind(&TestInstance::OnPostMessageBatch,
+                                           base::Unretained(this)));
+    SetPostReplyCallback(base::Bind(&TestInstance::OnPostReply,
+                                    base::Unretained(this)));
+    SetSendSyncReplyCallback(base::Bind(&TestInstance::OnSendSyncReply,
+                                        base::Unretained(this)));
+  }
+
+  void HandleMessage(std::unique_ptr<base::Value> msg) override {}
+
+  void HandleSyncMessage(std::unique_ptr<base::Value> msg) override {
+    SendSyncReplyToJS(std::move(msg));
+  }
+
+  // Requests are answered later, by ReplyToRequests().
+  void HandleRequest(int request_id,
+                     std::unique_ptr<base::Value> msg) override {
+    deferred_requests_.push_back(request_id);
+  }
+
+  void ReplyToRequests() {
+    for (int request_id : deferred_requests_)
+      SendRequestReplyToJS(request_id, base::Value::CreateNullValue());
+    deferred_requests_.clear();
+  }
+
+  using XWalkExtensionInstance::EnableMessageBatching;
+  using XWalkExtensionInstance::kMaxMessageBatchSize;
+
+  void Post(int i) {
+    PostMessageToJS(
+        std::unique_ptr<base::Value>(new base::FundamentalValue(i)));
+  }
+
+  // What reached the renderer, one string per IPC: "message 1",
+  // "batch 1 2 3", "reply 7" or "sync reply 4".
+  std::vector<std::string> sent;
+
+ private:
+  void OnPostMessage(std::unique_ptr<base::Value> msg) {
+    sent.push_back("message " + ToString(*msg));
+  }
+
+  void OnPostMessageBatch(std::unique_ptr<base::ListValue> msgs) {
+    std::string batch = "batch";
+    for (const auto& msg : *msgs)
+      batch += " " + ToString(*msg);
+    sent.push_back(batch);
+  }
+
+  void OnPostReply(int request_id, std::unique_ptr<base::Value> reply) {
+    sent.push_back("reply " + base::IntToString(request_id));
+  }
+
+  void OnSendSyncReply(std::unique_ptr<base::Value> reply) {
+    sent.push_back("sync reply " + ToString(*reply));
+  }
+
+  static std::string ToString(const base::Value& value) {
+    int i = -1;
+    value.GetAsInteger(&i);
+    return base::IntToString(i);
+  }
+
+  std::vector<int> deferred_requests_;
+};
+
+}  // namespace
+
+TEST(XWalkExtensionInstanceTest, MessagesAreNotBatchedByDefault) {
+  base::MessageLoop loop;
+  TestInstance instance;
+  instance.Post(1);
+  instance.Post(2);
+  ASSERT_EQ(2u, instance.sent.size());
+  EXPECT_EQ("message 1", instance.sent[0]);
+  EXPECT_EQ("message 2", instance.sent[1]);
+}
+
+TEST(XWalkExtensionInstanceTest, BatchFlushedAtEndOfTask) {
+  base::MessageLoop loop;
+  TestInstance instance;
+  instance.EnableMessageBatching();
+  instance.Post(1);
+  instance.Post(2);
+  instance.Post(3);
+  EXPECT_TRUE(instance.sent.empty());
+
+  base::RunLoop().RunUntilIdle();
+  ASSERT_EQ(1u, instance.sent.size());
+  EXPECT_EQ("batch 1 2 3", instance.sent[0]);
+
+  // A message alone isn't wrapped.
+  instance.Post(4);
+  base::RunLoop().RunUntilIdle();
+  ASSERT_EQ(2u, instance.sent.size());
+  EXPECT_EQ("message 4", instance.sent[1]);
+}
+
+TEST(XWalkExtensionInstanceTest, BatchFlushedWhenFull) {
+  base::MessageLoop loop;
+  TestInstance instance;
+  instance.EnableMessageBatching();
+  const int kCount = static_cast<int>(TestInstance::kMaxMessageBatchSize);
+  for (int i = 0; i < kCount + 1; ++i)
+    instance.Post(i);
+
+  // The first batch went as soon as it was full, without waiting for the
+  // end of the task.
+  ASSERT_EQ(1u, instance.sent.size());
+  std::string expected = "batch";
+  for (int i = 0; i < kCount; ++i)
+    expected += " " + base::IntToString(i);
+  EXPECT_EQ(expected, instance.sent[0]);
+
+  base::RunLoop().RunUntilIdle();
+  ASSERT_EQ(2u, instance.sent.size());
+  EXPECT_EQ("message " + base::IntToString(kCount), instance.sent[1]);
+}
+
+TEST(XWalkExtensionInstanceTest, BatchFlushedBeforeReply) {
+  base::MessageLoop loop;
+  TestInstance instance;
+  instance.EnableMessageBatching();
+  instance.Post(1);
+  instance.Post(2);
+  instance.SendRequestReplyToJS(7, base::Value::CreateNullValue());
+  instance.Post(3);
+  base::RunLoop().RunUntilIdle();
+
+  ASSERT_EQ(3u, instance.sent.size());
+  EXPECT_EQ("batch 1 2", instance.sent[0]);
+  EXPECT_EQ("reply 7", instance.sent[1]);
+  EXPECT_EQ("message 3", instance.sent[2]);
+}
+
+TEST(XWalkExtensionInstanceTest, SyncReplyDoesNotAnswerPendingRequest) {
+  base::MessageLoop loop;
+  TestInstance instance;
+  instance.HandleRequest(
+      5, std::unique_ptr<base::Value>(new base::FundamentalValue(1)));
+  instance.HandleRequest(
+      6, std::unique_ptr<base::Value>(new base::FundamentalValue(2)));
+  EXPECT_TRUE(instance.sent.empty());
+
+  // The renderer blocked on the sync message gets its own reply, while the
+  // requests stay pending.
+  instance.HandleSyncMessage(
+      std::unique_ptr<base::Value>(new base::FundamentalValue(4)));
+  ASSERT_EQ(1u, instance.sent.size());
+  EXPECT_EQ("sync reply 4", instance.sent[0]);
+
+  instance.ReplyToRequests();
+  ASSERT_EQ(3u, instance.sent.size());
+  EXPECT_EQ("reply 5", instance.sent[1]);
+  EXPECT_EQ("reply 6", instance.sent[2]);
+}
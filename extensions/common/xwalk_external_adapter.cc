@@ -100,6 +100,14 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
     return &syncMessagingInterface1;
   }
 
+  if (!strcmp(name, XW_INTERNAL_REQUEST_INTERFACE_1)) {
+    static const XW_Internal_RequestInterface_1 requestInterface1 = {
+      RequestRegister,
+      RequestPostReply
+    };
+    return &requestInterface1;
+  }
+
   if (!strcmp(name, XW_INTERNAL_ENTRY_POINTS_INTERFACE_1)) {
     static const XW_Internal_EntryPointsInterface_1 entryPointsInterface1 = {
       EntryPointsSetExtraJSEntryPoints
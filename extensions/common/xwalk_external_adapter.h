@@ -9,6 +9,7 @@
 #include "base/memory/singleton.h"
 #include "xwalk/extensions/public/XW_Extension.h"
 #include "xwalk/extensions/public/XW_Extension_Message_2.h"
+#include "xwalk/extensions/public/XW_Extension_Request.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 #include "xwalk/extensions/public/XW_Extension_EntryPoints.h"
 #include "xwalk/extensions/public/XW_Extension_Permissions.h"
@@ -136,6 +137,10 @@ class XWalkExternalAdapter {
                     XW_HandleSyncMessageCallback);
   DEFINE_FUNCTION_1(Instance, SyncMessaging, SetSyncReply, const char*);
 
+  // XW_Internal_RequestInterface_1 from XW_Extension_Request.h.
+  DEFINE_FUNCTION_1(Extension, Request, Register, XW_HandleRequestCallback);
+  DEFINE_FUNCTION_2(Instance, Request, PostReply, int, const char*);
+
   // XW_Internal_Runtime_1 from XW_Extension_Runtime.h
   DEFINE_FUNCTION_3(Extension, Runtime, GetStringVariable, const char *,
                     char*, size_t);
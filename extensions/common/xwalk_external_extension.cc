@@ -25,6 +25,7 @@ XWalkExternalExtension::XWalkExternalExtension(const base::FilePath& path)
       handle_msg_callback_(NULL),
       handle_sync_msg_callback_(NULL),
       handle_binary_msg_callback_(NULL),
+      handle_request_callback_(NULL),
       initialized_(false) {
 }
 
@@ -138,6 +139,12 @@ void XWalkExternalExtension::SyncMessagingRegister(
   handle_sync_msg_callback_ = callback;
 }
 
+void XWalkExternalExtension::RequestRegister(
+    XW_HandleRequestCallback callback) {
+  RETURN_IF_INITIALIZED("Register from Internal_RequestInterface");
+  handle_request_callback_ = callback;
+}
+
 void XWalkExternalExtension::EntryPointsSetExtraJSEntryPoints(
     const char** entry_points) {
   RETURN_IF_INITIALIZED("SetExtraJSEntryPoints from EntryPoints");
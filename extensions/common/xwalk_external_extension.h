@@ -12,6 +12,7 @@
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/extensions/public/XW_Extension.h"
 #include "xwalk/extensions/public/XW_Extension_Message_2.h"
+#include "xwalk/extensions/public/XW_Extension_Request.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 #include "base/memory/ptr_util.h"
 
@@ -75,6 +76,10 @@ class XWalkExternalExtension : public XWalkExtension {
   // XW_Internal_SyncMessagingInterface_1 (from XW_Extension.h) implementation.
   void SyncMessagingRegister(XW_HandleSyncMessageCallback callback);
 
+  // XW_Internal_RequestInterface_1 (from XW_Extension_Request.h)
+  // implementation.
+  void RequestRegister(XW_HandleRequestCallback callback);
+
   // XW_Internal_BrowserInterface_1 (from XW_Browser.h) implementation.
   void RuntimeGetStringVariable(const char* key, char* value, size_t value_len);
 
@@ -88,6 +93,7 @@ class XWalkExternalExtension : public XWalkExtension {
   XW_HandleMessageCallback handle_msg_callback_;
   XW_HandleSyncMessageCallback handle_sync_msg_callback_;
   XW_HandleBinaryMessageCallback handle_binary_msg_callback_;
+  XW_HandleRequestCallback handle_request_callback_;
 
   bool initialized_;
 
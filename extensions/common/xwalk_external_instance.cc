@@ -55,6 +55,21 @@ void XWalkExternalInstance::HandleMessage(std::unique_ptr<base::Value> msg) {
   return;
 }
 
+void XWalkExternalInstance::HandleBinaryMessage(const char* data,
+                                                size_t size) {
+  // Binary messages go straight from the IPC buffer to the extension, there's
+  // no need to materialize a base::BinaryValue for them.
+  XW_HandleBinaryMessageCallback binary_callback =
+      extension_->handle_binary_msg_callback_;
+  if (!binary_callback) {
+    LOG(WARNING) << "Ignoring binary message sent for external extension '"
+                 << extension_->name() << "' which doesn't support it.";
+    return;
+  }
+
+  binary_callback(xw_instance_, data, size);
+}
+
 void XWalkExternalInstance::HandleSyncMessage(std::unique_ptr<base::Value> msg) {
   XW_HandleSyncMessageCallback callback = extension_->handle_sync_msg_callback_;
   if (!callback) {
@@ -72,6 +87,23 @@ void XWalkExternalInstance::HandleSyncMessage(std::unique_ptr<base::Value> msg)
   callback(xw_instance_, string_msg.c_str());
 }
 
+void XWalkExternalInstance::HandleRequest(int request_id,
+                                          std::unique_ptr<base::Value> msg) {
+  XW_HandleRequestCallback callback = extension_->handle_request_callback_;
+  if (!callback) {
+    XWalkExtensionInstance::HandleRequest(request_id, std::move(msg));
+    return;
+  }
+
+  std::string string_msg;
+  if (!msg->GetAsString(&string_msg)) {
+    LOG(WARNING) << "Failed to retrieve the request's value.";
+    return;
+  }
+
+  callback(xw_instance_, request_id, string_msg.c_str());
+}
+
 void XWalkExternalInstance::CoreSetInstanceData(void* data) {
   instance_data_ = data;
 }
@@ -86,13 +118,18 @@ void XWalkExternalInstance::MessagingPostMessage(const char* msg) {
 
 void XWalkExternalInstance::MessagingPostBinaryMessage(const char* msg,
                                                        const size_t size) {
-  PostMessageToJS(std::unique_ptr<base::Value>(
-      base::BinaryValue::CreateWithCopiedBuffer(msg, size)));
+  PostBinaryMessageToJS(msg, size);
 }
 
 void XWalkExternalInstance::SyncMessagingSetSyncReply(const char* reply) {
   SendSyncReplyToJS(std::unique_ptr<base::Value>(new base::StringValue(reply)));
 }
 
+void XWalkExternalInstance::RequestPostReply(int request_id,
+                                             const char* reply) {
+  SendRequestReplyToJS(
+      request_id, std::unique_ptr<base::Value>(new base::StringValue(reply)));
+}
+
 }  // namespace extensions
 }  // namespace xwalk
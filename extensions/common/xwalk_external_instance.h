@@ -9,6 +9,7 @@
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/extensions/public/XW_Extension.h"
 #include "xwalk/extensions/public/XW_Extension_Message_2.h"
+#include "xwalk/extensions/public/XW_Extension_Request.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 
 namespace xwalk {
@@ -39,7 +40,9 @@ class XWalkExternalInstance : public XWalkExtensionInstance {
 
   // XWalkExtensionInstance implementation.
   void HandleMessage(std::unique_ptr<base::Value> msg) override;
+  void HandleBinaryMessage(const char* data, size_t size) override;
   void HandleSyncMessage(std::unique_ptr<base::Value> msg) override;
+  void HandleRequest(int request_id, std::unique_ptr<base::Value> msg) override;
 
   // XW_CoreInterface_1 (from XW_Extension.h) implementation.
   void CoreSetInstanceData(void* data);
@@ -55,6 +58,10 @@ class XWalkExternalInstance : public XWalkExtensionInstance {
   // implementation.
   void SyncMessagingSetSyncReply(const char* reply);
 
+  // XW_Internal_RequestInterface_1 (from XW_Extension_Request.h)
+  // implementation.
+  void RequestPostReply(int request_id, const char* reply);
+
   XW_Instance xw_instance_;
   std::string sync_reply_;
   XWalkExternalExtension* extension_;
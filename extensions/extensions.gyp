@@ -26,14 +26,24 @@
         'browser/xwalk_extension_process_host.h',
         'browser/xwalk_extension_service.cc',
         'browser/xwalk_extension_service.h',
+        'browser/xwalk_extension_thread_pool.cc',
+        'browser/xwalk_extension_thread_pool.h',
         'common/android/xwalk_extension_android.cc',
         'common/android/xwalk_extension_android.h',
         'common/android/xwalk_native_extension_loader_android.cc',
         'common/android/xwalk_native_extension_loader_android.h',
         'common/xwalk_extension.cc',
         'common/xwalk_extension.h',
+        'common/xwalk_extension_binary_message.cc',
+        'common/xwalk_extension_binary_message.h',
+        'common/xwalk_extension_message_ring.cc',
+        'common/xwalk_extension_message_ring.h',
         'common/xwalk_extension_messages.cc',
         'common/xwalk_extension_messages.h',
+        'common/xwalk_extension_metrics.cc',
+        'common/xwalk_extension_metrics.h',
+        'common/xwalk_extension_registry.cc',
+        'common/xwalk_extension_registry.h',
         'common/xwalk_extension_server.cc',
         'common/xwalk_extension_server.h',
         'common/xwalk_extension_switches.cc',
@@ -55,9 +65,12 @@
         'public/XW_Extension.h',
         'public/XW_Extension_Message_2.h',
         'public/XW_Extension_Permissions.h',
+        'public/XW_Extension_Request.h',
         'public/XW_Extension_SyncMessage.h',
         'renderer/xwalk_extension_client.cc',
         'renderer/xwalk_extension_client.h',
+        'renderer/xwalk_extension_code_cache.cc',
+        'renderer/xwalk_extension_code_cache.h',
         'renderer/xwalk_extension_module.cc',
         'renderer/xwalk_extension_module.h',
         'renderer/xwalk_extension_renderer_controller.cc',
@@ -6,12 +6,17 @@
       'dependencies': [
         '../../base/base.gyp:base',
         '../../base/base.gyp:run_all_unittests',
+        '../../gin/gin.gyp:gin_test',
         '../../testing/gtest.gyp:gtest',
+        '../../v8/src/v8.gyp:v8',
         'extensions.gyp:xwalk_extensions',
       ],
       'sources': [
         'browser/xwalk_extension_function_handler_unittest.cc',
+        'browser/xwalk_extension_thread_pool_unittest.cc',
         'common/xwalk_extension_server_unittest.cc',
+        'common/xwalk_extension_unittest.cc',
+        'renderer/xwalk_extension_code_cache_unittest.cc',
       ],
     },
     {
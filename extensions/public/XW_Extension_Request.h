@@ -0,0 +1,55 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_REQUEST_H_
+#define XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_REQUEST_H_
+
+// NOTE: This file and interfaces marked as internal are not considered stable
+// and can be modified in incompatible ways between Crosswalk versions.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_H_
+#error "You should include XW_Extension.h before this file"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// XW_INTERNAL_REQUEST_INTERFACE: allow JavaScript code to send a request to
+// extension code with extension.internal.sendRequest(), which returns a
+// Promise instead of blocking like sendSyncMessage(). The Promise is resolved
+// when PostReply is called with the same request id, which can be done from
+// outside the context of the HandleRequest callback and in any order.
+//
+// The requests of extensions not registering a request handler are resolved
+// with null. SetSyncReply only ever answers sendSyncMessage().
+//
+
+#define XW_INTERNAL_REQUEST_INTERFACE_1 \
+  "XW_InternalRequestInterface_1"
+#define XW_INTERNAL_REQUEST_INTERFACE \
+  XW_INTERNAL_REQUEST_INTERFACE_1
+
+typedef void (*XW_HandleRequestCallback)(XW_Instance instance,
+                                         int request_id,
+                                         const char* message);
+
+struct XW_Internal_RequestInterface_1 {
+  void (*Register)(XW_Extension extension,
+                   XW_HandleRequestCallback handle_request);
+
+  // This function is thread-safe and can be called until the instance is
+  // destroyed.
+  void (*PostReply)(XW_Instance instance, int request_id, const char* reply);
+};
+
+typedef struct XW_Internal_RequestInterface_1
+    XW_Internal_RequestInterface;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_REQUEST_H_
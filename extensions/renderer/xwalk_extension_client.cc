@@ -9,6 +9,7 @@
 #include "base/stl_util.h"
 #include "base/memory/ptr_util.h"
 #include "ipc/ipc_sender.h"
+#include "xwalk/extensions/common/xwalk_extension_binary_message.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
 
 namespace xwalk {
@@ -16,6 +17,7 @@ namespace extensions {
 
 XWalkExtensionClient::XWalkExtensionClient()
     : sender_(0),
+      extension_apis_loaded_(false),
       next_instance_id_(1) {  // Zero is never used for a valid instance.
 }
 
@@ -32,21 +34,46 @@ int64_t XWalkExtensionClient::CreateInstance(
     const std::string& extension_name,
     InstanceHandler* handler) {
   CHECK(handler);
-  if (!Send(new XWalkExtensionServerMsg_CreateInstance(next_instance_id_,
-                                                       extension_name))) {
-    return 0;
-  }
   handlers_[next_instance_id_] = handler;
+  pending_instances_[next_instance_id_] = extension_name;
   return next_instance_id_++;
 }
 
+bool XWalkExtensionClient::EnsureInstanceCreated(int64_t instance_id) {
+  PendingInstanceMap::iterator it = pending_instances_.find(instance_id);
+  if (it == pending_instances_.end())
+    return true;
+
+  // The creation goes right before the first message through the same
+  // channel, the server handles them in order.
+  if (!Send(new XWalkExtensionServerMsg_CreateInstance(instance_id,
+                                                       it->second))) {
+    LOG(WARNING) << "Can't create instance of extension: " << it->second;
+    return false;
+  }
+  pending_instances_.erase(it);
+  return true;
+}
+
 bool XWalkExtensionClient::OnMessageReceived(const IPC::Message& message) {
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionClient, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostMessageToJS,
         OnPostMessageToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostMessageBatchToJS,
+        OnPostMessageBatchToJS)
+    IPC_MESSAGE_HANDLER_GENERIC(XWalkExtensionClientMsg_PostBinaryMessageToJS,
+        OnPostBinaryMessageToJS(message))
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostReplyToJS,
+        OnPostReplyToJS)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostOutOfLineMessageToJS,
         OnPostOutOfLineMessageToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_SetupMessageRing,
+        OnSetupMessageRing)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostRingMessageToJS,
+        OnPostRingMessageToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_SetupRegistry,
+        OnSetupRegistry)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_InstanceDestroyed,
         OnInstanceDestroyed)
     IPC_MESSAGE_UNHANDLED(handled = false)
@@ -80,6 +107,64 @@ void XWalkExtensionClient::OnPostMessageToJS(int64_t instance_id,
   it->second->HandleMessageFromNative(*value);
 }
 
+void XWalkExtensionClient::OnPostMessageBatchToJS(
+    int64_t instance_id, const base::ListValue& msgs) {
+  HandlerMap::const_iterator it = handlers_.find(instance_id);
+  if (it == handlers_.end()) {
+    LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
+                 << instance_id;
+    return;
+  }
+
+  // See comment in DestroyInstance() about two step destruction.
+  if (!it->second)
+    return;
+
+  it->second->HandleMessageBatchFromNative(msgs);
+}
+
+void XWalkExtensionClient::OnPostBinaryMessageToJS(
+    const IPC::Message& message) {
+  int64_t instance_id;
+  const char* data;
+  size_t size;
+  if (!ReadBinaryMessage(message, &instance_id, &data, &size))
+    return;
+
+  HandlerMap::const_iterator it = handlers_.find(instance_id);
+  if (it == handlers_.end()) {
+    LOG(WARNING) << "Can't PostBinaryMessage to invalid Extension instance id: "
+                 << instance_id;
+    return;
+  }
+
+  // See comment in DestroyInstance() about two step destruction.
+  if (!it->second)
+    return;
+
+  it->second->HandleBinaryMessageFromNative(data, size);
+}
+
+void XWalkExtensionClient::OnPostReplyToJS(int64_t instance_id,
+                                           int request_id,
+                                           const base::ListValue& reply) {
+  HandlerMap::const_iterator it = handlers_.find(instance_id);
+  if (it == handlers_.end()) {
+    LOG(WARNING) << "Can't PostReply to invalid Extension instance id: "
+                 << instance_id;
+    return;
+  }
+
+  // See comment in DestroyInstance() about two step destruction.
+  if (!it->second)
+    return;
+
+  const base::Value* value;
+  if (!reply.Get(0, &value))
+    return;
+  it->second->HandleReplyFromNative(request_id, *value);
+}
+
 void XWalkExtensionClient::OnPostOutOfLineMessageToJS(
     base::SharedMemoryHandle handle, size_t size) {
   CHECK(base::SharedMemory::IsHandleValid(handle));
@@ -93,12 +178,55 @@ void XWalkExtensionClient::OnPostOutOfLineMessageToJS(
   OnMessageReceived(message);
 }
 
+void XWalkExtensionClient::OnSetupMessageRing(
+    int ring_id, base::SharedMemoryHandle handle, uint32_t capacity) {
+  CHECK(base::SharedMemory::IsHandleValid(handle));
+
+  std::unique_ptr<XWalkExtensionMessageRing> ring =
+      XWalkExtensionMessageRing::Open(handle, capacity);
+  if (!ring) {
+    LOG(WARNING) << "Can't map message ring " << ring_id;
+    return;
+  }
+  message_rings_[ring_id] = std::move(ring);
+}
+
+void XWalkExtensionClient::OnPostRingMessageToJS(
+    int ring_id, uint32_t position, uint32_t size) {
+  MessageRingMap::iterator it = message_rings_.find(ring_id);
+  if (it == message_rings_.end()) {
+    LOG(WARNING) << "Got message for invalid message ring " << ring_id;
+    return;
+  }
+
+  XWalkExtensionMessageRing* ring = it->second.get();
+  const char* data = ring->Read(position, size);
+  if (!data) {
+    LOG(WARNING) << "Got invalid message descriptor for message ring "
+                 << ring_id;
+    return;
+  }
+
+  // The message is parsed in place, the space is only given back to the
+  // server after it was dispatched.
+  IPC::Message message(data, base::checked_cast<int>(size));
+  OnMessageReceived(message);
+  ring->Release(position, size);
+}
+
 void XWalkExtensionClient::DestroyInstance(int64_t instance_id) {
   HandlerMap::iterator it = handlers_.find(instance_id);
   if (it == handlers_.end() || !it->second) {
     LOG(WARNING) << "Can't Destroy invalid instance id: " << instance_id;
     return;
   }
+
+  // Nothing to destroy on the native side.
+  if (pending_instances_.erase(instance_id)) {
+    handlers_.erase(it);
+    return;
+  }
+
   Send(new XWalkExtensionServerMsg_DestroyInstance(instance_id));
 
   // Destruction happens in two steps, first we nullify the handler in our map,
@@ -143,12 +271,31 @@ std::unique_ptr<base::ListValue> WrapValueInList(std::unique_ptr<base::Value> va
 
 void XWalkExtensionClient::PostMessageToNative(int64_t instance_id,
     std::unique_ptr<base::Value> msg) {
+  if (!EnsureInstanceCreated(instance_id))
+    return;
   std::unique_ptr<base::ListValue> list_msg = WrapValueInList(std::move(msg));
   Send(new XWalkExtensionServerMsg_PostMessageToNative(instance_id, *list_msg));
 }
 
+void XWalkExtensionClient::PostBinaryMessageToNative(int64_t instance_id,
+    const char* data, size_t size) {
+  if (!EnsureInstanceCreated(instance_id))
+    return;
+  IPC::Message* message = CreateBinaryMessage(
+      XWalkExtensionServerMsg_PostBinaryMessageToNative::ID, instance_id,
+      data, size);
+  if (!message) {
+    LOG(WARNING) << "Binary message of " << size << " bytes is too big to be "
+                 << "posted to native.";
+    return;
+  }
+  Send(message);
+}
+
 std::unique_ptr<base::Value> XWalkExtensionClient::SendSyncMessageToNative(
     int64_t instance_id, std::unique_ptr<base::Value> msg) {
+  if (!EnsureInstanceCreated(instance_id))
+    return nullptr;
   std::unique_ptr<base::ListValue> wrapped_msg = WrapValueInList(std::move(msg));
   base::ListValue* wrapped_reply = new base::ListValue;
   Send(new XWalkExtensionServerMsg_SendSyncMessageToNative(instance_id,
@@ -159,16 +306,52 @@ std::unique_ptr<base::Value> XWalkExtensionClient::SendSyncMessageToNative(
   return reply;
 }
 
+bool XWalkExtensionClient::PostRequestToNative(int64_t instance_id,
+    int request_id, std::unique_ptr<base::Value> msg) {
+  if (!EnsureInstanceCreated(instance_id))
+    return false;
+  std::unique_ptr<base::ListValue> list_msg = WrapValueInList(std::move(msg));
+  return Send(new XWalkExtensionServerMsg_PostRequestToNative(
+      instance_id, request_id, *list_msg));
+}
+
 void XWalkExtensionClient::Initialize(IPC::Sender* sender) {
   sender_ = sender;
+}
 
-  std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams> extensions;
-  Send(new XWalkExtensionServerMsg_GetExtensions(&extensions));
+const XWalkExtensionClient::ExtensionAPIMap&
+XWalkExtensionClient::extension_apis() {
+  if (!extension_apis_loaded_) {
+    std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams> extensions;
+    Send(new XWalkExtensionServerMsg_GetExtensions(&extensions));
+    SetExtensionAPIs(extensions);
+  }
+  return extension_apis_;
+}
+
+void XWalkExtensionClient::OnSetupRegistry(base::SharedMemoryHandle handle,
+                                           uint32_t size) {
+  CHECK(base::SharedMemory::IsHandleValid(handle));
+
+  // Already got the extensions the slow way.
+  if (extension_apis_loaded_) {
+    base::SharedMemory::CloseHandle(handle);
+    return;
+  }
 
-  if (extensions.empty())
+  XWalkExtensionRegistry::ExtensionList extensions;
+  if (!XWalkExtensionRegistry::Read(handle, size, &extensions)) {
+    LOG(WARNING) << "Can't read extension registry";
     return;
+  }
+  SetExtensionAPIs(extensions);
+}
+
+void XWalkExtensionClient::SetExtensionAPIs(
+    const XWalkExtensionRegistry::ExtensionList& extensions) {
+  extension_apis_loaded_ = true;
 
-  std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>::iterator it =
+  XWalkExtensionRegistry::ExtensionList::const_iterator it =
       extensions.begin();
   for (; it != extensions.end(); ++it) {
     ExtensionCodePoints* codepoint = new ExtensionCodePoints;
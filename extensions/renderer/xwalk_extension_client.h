@@ -14,6 +14,8 @@
 #include "base/memory/shared_memory.h"
 #include "base/values.h"
 #include "ipc/ipc_listener.h"
+#include "xwalk/extensions/common/xwalk_extension_message_ring.h"
+#include "xwalk/extensions/common/xwalk_extension_registry.h"
 
 namespace base {
 class Value;
@@ -37,6 +39,13 @@ class XWalkExtensionClient : public IPC::Listener {
  public:
   struct InstanceHandler {
     virtual void HandleMessageFromNative(const base::Value& msg) = 0;
+    virtual void HandleMessageBatchFromNative(const base::ListValue& msgs) = 0;
+    // |data| points inside the received IPC message and is only valid
+    // during the call.
+    virtual void HandleBinaryMessageFromNative(const char* data,
+                                               size_t size) = 0;
+    virtual void HandleReplyFromNative(int request_id,
+                                       const base::Value& reply) = 0;
    protected:
     virtual ~InstanceHandler() {}
   };
@@ -44,13 +53,29 @@ class XWalkExtensionClient : public IPC::Listener {
   XWalkExtensionClient();
   ~XWalkExtensionClient() override;
 
+  // The native instance is only created when it is first needed: right
+  // before the first message posted to it, or when EnsureInstanceCreated()
+  // is called. Instances that never talk to native cost no IPC at all.
   int64_t CreateInstance(const std::string& extension_name,
                          InstanceHandler* handler);
   void DestroyInstance(int64_t instance_id);
 
+  // Creates the native instance now, for instances that might get messages
+  // from native before posting anything. Returns false if the creation
+  // couldn't be sent, it is tried again with the next message.
+  bool EnsureInstanceCreated(int64_t instance_id);
+
   void PostMessageToNative(int64_t instance_id, std::unique_ptr<base::Value> msg);
+  // Copies |size| bytes from |data| straight into the IPC message.
+  void PostBinaryMessageToNative(int64_t instance_id, const char* data,
+                                 size_t size);
   std::unique_ptr<base::Value> SendSyncMessageToNative(int64_t instance_id,
       std::unique_ptr<base::Value> msg);
+  // Doesn't block, the reply is given to the instance handler with the same
+  // |request_id|. Returns false if the request couldn't be sent, in which
+  // case no reply will come.
+  bool PostRequestToNative(int64_t instance_id, int request_id,
+                           std::unique_ptr<base::Value> msg);
 
   void Initialize(IPC::Sender* sender);
 
@@ -66,7 +91,9 @@ class XWalkExtensionClient : public IPC::Listener {
 
   typedef std::map<std::string, std::unique_ptr<ExtensionCodePoints>> ExtensionAPIMap;
 
-  const ExtensionAPIMap& extension_apis() const { return extension_apis_; }
+  // Filled from the registry published by the server when the channel gets
+  // connected. If it didn't arrive yet, asks the server synchronously.
+  const ExtensionAPIMap& extension_apis();
 
  private:
   bool Send(IPC::Message* msg);
@@ -74,15 +101,36 @@ class XWalkExtensionClient : public IPC::Listener {
   // Message Handlers.
   void OnInstanceDestroyed(int64_t instance_id);
   void OnPostMessageToJS(int64_t instance_id, const base::ListValue& msg);
+  void OnPostMessageBatchToJS(int64_t instance_id,
+                              const base::ListValue& msgs);
+  void OnPostBinaryMessageToJS(const IPC::Message& message);
+  void OnPostReplyToJS(int64_t instance_id, int request_id,
+                       const base::ListValue& reply);
   void OnPostOutOfLineMessageToJS(base::SharedMemoryHandle handle,
                                   size_t size);
+  void OnSetupMessageRing(int ring_id, base::SharedMemoryHandle handle,
+                          uint32_t capacity);
+  void OnPostRingMessageToJS(int ring_id, uint32_t position, uint32_t size);
+  void OnSetupRegistry(base::SharedMemoryHandle handle, uint32_t size);
+
+  void SetExtensionAPIs(const XWalkExtensionRegistry::ExtensionList& extensions);
 
   IPC::Sender* sender_;
   ExtensionAPIMap extension_apis_;
+  bool extension_apis_loaded_;
 
   typedef std::map<int64_t, InstanceHandler*> HandlerMap;
   HandlerMap handlers_;
 
+  // Extension names of the instances whose native side wasn't created yet.
+  typedef std::map<int64_t, std::string> PendingInstanceMap;
+  PendingInstanceMap pending_instances_;
+
+  // One ring per server talking to us through this channel.
+  typedef std::map<int, std::unique_ptr<XWalkExtensionMessageRing>>
+      MessageRingMap;
+  MessageRingMap message_rings_;
+
   int64_t next_instance_id_;
 };
 
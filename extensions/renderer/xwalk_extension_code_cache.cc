@@ -0,0 +1,91 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/renderer/xwalk_extension_code_cache.h"
+
+#include "base/hash.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+base::LazyInstance<XWalkExtensionCodeCache>::Leaky g_code_cache =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// static
+XWalkExtensionCodeCache* XWalkExtensionCodeCache::GetInstance() {
+  return g_code_cache.Pointer();
+}
+
+XWalkExtensionCodeCache::XWalkExtensionCodeCache() {}
+
+XWalkExtensionCodeCache::~XWalkExtensionCodeCache() {}
+
+v8::MaybeLocal<v8::Script> XWalkExtensionCodeCache::Compile(
+    v8::Local<v8::Context> context,
+    const std::string& extension_name,
+    const std::string& code) {
+  v8::Isolate* isolate = context->GetIsolate();
+  v8::Local<v8::String> v8_code(
+      v8::String::NewFromUtf8(isolate, code.c_str()));
+  uint32_t code_hash = base::Hash(code);
+
+  EntryMap::iterator it = entries_.find(extension_name);
+  if (it != entries_.end() && it->second.code_hash != code_hash) {
+    entries_.erase(it);
+    it = entries_.end();
+  }
+
+  if (it == entries_.end()) {
+    v8::ScriptCompiler::Source source(v8_code);
+    v8::Local<v8::Script> script;
+    if (!v8::ScriptCompiler::Compile(context, &source,
+                                     v8::ScriptCompiler::kProduceCodeCache)
+             .ToLocal(&script)) {
+      return v8::MaybeLocal<v8::Script>();
+    }
+
+    const v8::ScriptCompiler::CachedData* cached_data =
+        source.GetCachedData();
+    if (cached_data && cached_data->length > 0) {
+      Entry& entry = entries_[extension_name];
+      entry.code_hash = code_hash;
+      entry.data.assign(reinterpret_cast<const char*>(cached_data->data),
+                        cached_data->length);
+    }
+    return script;
+  }
+
+  // The source takes ownership of the CachedData object, not of the buffer,
+  // which stays in the cache.
+  const std::string& data = it->second.data;
+  v8::ScriptCompiler::Source source(v8_code, new v8::ScriptCompiler::CachedData(
+      reinterpret_cast<const uint8_t*>(data.data()),
+      static_cast<int>(data.size())));
+  v8::MaybeLocal<v8::Script> script = v8::ScriptCompiler::Compile(
+      context, &source, v8::ScriptCompiler::kConsumeCodeCache);
+
+  // V8 rejects data produced by a different V8 version or with different
+  // flags. The code was compiled from source anyway, produce new data the
+  // next time.
+  if (source.GetCachedData()->rejected)
+    entries_.erase(extension_name);
+
+  return script;
+}
+
+void XWalkExtensionCodeCache::SetCachedDataForTesting(
+    const std::string& extension_name,
+    const std::string& code,
+    const std::string& data) {
+  Entry& entry = entries_[extension_name];
+  entry.code_hash = base::Hash(code);
+  entry.data = data;
+}
+
+}  // namespace extensions
+}  // namespace xwalk
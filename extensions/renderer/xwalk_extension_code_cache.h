@@ -0,0 +1,68 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_CODE_CACHE_H_
+#define XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_CODE_CACHE_H_
+
+#include <stdint.h>
+#include <map>
+#include <string>
+
+#include "base/lazy_instance.h"
+#include "base/macros.h"
+#include "v8/include/v8.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Keeps the V8 code cache of the wrapped JS API of each extension, so the API
+// is only parsed and compiled from source in the first script context of the
+// render process that loads it. Every other frame and iframe consumes the
+// cached data instead.
+//
+// Entries are keyed by extension name and validated against a hash of the
+// code, a different API for the same name replaces the entry. Only used from
+// the render thread.
+class XWalkExtensionCodeCache {
+ public:
+  static XWalkExtensionCodeCache* GetInstance();
+
+  // Tests use their own cache instead of the shared one.
+  XWalkExtensionCodeCache();
+  ~XWalkExtensionCodeCache();
+
+  // Compiles |code| in the current context, consuming the cached data for
+  // |extension_name| if there's a valid one and producing it otherwise.
+  // Returns an empty handle if the code doesn't compile, the exception is
+  // left in the caller's TryCatch.
+  v8::MaybeLocal<v8::Script> Compile(v8::Local<v8::Context> context,
+                                     const std::string& extension_name,
+                                     const std::string& code);
+
+  bool HasCachedData(const std::string& extension_name) const {
+    return entries_.count(extension_name) != 0;
+  }
+
+  // Replaces the cached data of |extension_name|, as if it was produced for
+  // |code|.
+  void SetCachedDataForTesting(const std::string& extension_name,
+                               const std::string& code,
+                               const std::string& data);
+
+ private:
+  struct Entry {
+    uint32_t code_hash;
+    std::string data;
+  };
+
+  typedef std::map<std::string, Entry> EntryMap;
+  EntryMap entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionCodeCache);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_CODE_CACHE_H_
@@ -0,0 +1,86 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/renderer/xwalk_extension_code_cache.h"
+
+#include <string>
+
+#include "gin/test/v8_test.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::extensions::XWalkExtensionCodeCache;
+
+namespace {
+
+const char kCode[] =
+    "(function() {"
+    "  function add(a, b) { return a + b; }"
+    "  return add(40, 2);"
+    "})()";
+
+const char kOtherCode[] =
+    "(function() {"
+    "  function mul(a, b) { return a * b; }"
+    "  return mul(6, 7) + 1;"
+    "})()";
+
+class XWalkExtensionCodeCacheTest : public gin::V8Test {
+ protected:
+  // Compiles and runs |code| through |cache_|, returns -1 on failure.
+  int Run(const std::string& extension_name, const std::string& code) {
+    v8::Isolate* isolate = instance_->isolate();
+    v8::HandleScope handle_scope(isolate);
+    v8::Local<v8::Context> context =
+        v8::Local<v8::Context>::New(isolate, context_);
+    v8::TryCatch try_catch(isolate);
+
+    v8::Local<v8::Script> script;
+    v8::Local<v8::Value> result;
+    if (!cache_.Compile(context, extension_name, code).ToLocal(&script) ||
+        !script->Run(context).ToLocal(&result))
+      return -1;
+    return result->Int32Value(context).FromMaybe(-1);
+  }
+
+  XWalkExtensionCodeCache cache_;
+};
+
+}  // namespace
+
+TEST_F(XWalkExtensionCodeCacheTest, ProducesThenConsumes) {
+  EXPECT_FALSE(cache_.HasCachedData("a"));
+  EXPECT_EQ(42, Run("a", kCode));
+  ASSERT_TRUE(cache_.HasCachedData("a"));
+
+  // Consuming valid data keeps it.
+  EXPECT_EQ(42, Run("a", kCode));
+  EXPECT_TRUE(cache_.HasCachedData("a"));
+
+  EXPECT_FALSE(cache_.HasCachedData("b"));
+}
+
+TEST_F(XWalkExtensionCodeCacheTest, ChangedCodeReplacesEntry) {
+  EXPECT_EQ(42, Run("a", kCode));
+  ASSERT_TRUE(cache_.HasCachedData("a"));
+
+  // The data of the old code must not be used for the new one.
+  EXPECT_EQ(43, Run("a", kOtherCode));
+  EXPECT_TRUE(cache_.HasCachedData("a"));
+  EXPECT_EQ(43, Run("a", kOtherCode));
+}
+
+TEST_F(XWalkExtensionCodeCacheTest, RejectedDataIsDropped) {
+  cache_.SetCachedDataForTesting("a", kCode, "not V8 code cache data");
+  EXPECT_EQ(42, Run("a", kCode));
+  EXPECT_FALSE(cache_.HasCachedData("a"));
+
+  // Produced again on the next compilation.
+  EXPECT_EQ(42, Run("a", kCode));
+  EXPECT_TRUE(cache_.HasCachedData("a"));
+}
+
+TEST_F(XWalkExtensionCodeCacheTest, CompileErrorLeavesNoEntry) {
+  EXPECT_EQ(-1, Run("a", "function ("));
+  EXPECT_FALSE(cache_.HasCachedData("a"));
+}
@@ -10,6 +10,7 @@
 #include "base/values.h"
 #include "content/public/child/v8_value_converter.h"
 #include "third_party/WebKit/public/web/WebFrame.h"
+#include "xwalk/extensions/renderer/xwalk_extension_code_cache.h"
 #include "xwalk/extensions/renderer/xwalk_module_system.h"
 #include "xwalk/extensions/renderer/xwalk_v8_utils.h"
 
@@ -33,7 +34,8 @@ XWalkExtensionModule::XWalkExtensionModule(XWalkExtensionClient* client,
       converter_(content::V8ValueConverter::create()),
       client_(client),
       module_system_(module_system),
-      instance_id_(0) {
+      instance_id_(0),
+      next_request_id_(1) {
   v8::Isolate* isolate = v8::Isolate::GetCurrent();
   v8::HandleScope handle_scope(isolate);
   v8::Handle<v8::Object> function_data = v8::Object::New(isolate);
@@ -51,6 +53,9 @@ XWalkExtensionModule::XWalkExtensionModule(XWalkExtensionClient* client,
       v8::String::NewFromUtf8(isolate, "sendSyncMessage"),
       v8::FunctionTemplate::New(
           isolate, SendSyncMessageCallback, function_data));
+  object_template->Set(
+      v8::String::NewFromUtf8(isolate, "sendRequest"),
+      v8::FunctionTemplate::New(isolate, SendRequestCallback, function_data));
   object_template->Set(
       v8::String::NewFromUtf8(isolate, "setMessageListener"),
       v8::FunctionTemplate::New(
@@ -76,6 +81,7 @@ XWalkExtensionModule::~XWalkExtensionModule() {
   object_template_.Reset();
   function_data_.Reset();
   message_listener_.Reset();
+  pending_requests_.clear();
 
   if (instance_id_)
     client_->DestroyInstance(instance_id_);
@@ -109,6 +115,8 @@ std::string WrapAPICode(const std::string& extension_code,
       "extension.internal = {};"
       "extension.internal.sendSyncMessage = extension.sendSyncMessage;"
       "delete extension.sendSyncMessage;"
+      "extension.internal.sendRequest = extension.sendRequest;"
+      "delete extension.sendRequest;"
       "extension.setExports = function(exports){%s = exports;};"
       "(function() {'use strict';"
       "  var exports = {}; %s\n;"
@@ -118,20 +126,24 @@ std::string WrapAPICode(const std::string& extension_code,
       extension_code.c_str());
 }
 
-v8::Handle<v8::Value> RunString(const std::string& code,
+// The wrapped code of the same extension is run in every script context, it
+// goes through the code cache so only the first context compiles it.
+v8::Handle<v8::Value> RunString(v8::Handle<v8::Context> context,
+                                const std::string& extension_name,
+                                const std::string& code,
                                 std::string* exception) {
   v8::Isolate* isolate = v8::Isolate::GetCurrent();
   v8::EscapableHandleScope handle_scope(isolate);
-  v8::Handle<v8::String> v8_code(
-      v8::String::NewFromUtf8(isolate, code.c_str()));
 
   v8::MicrotasksScope microtasks(
       isolate, v8::MicrotasksScope::kDoNotRunMicrotasks);
   v8::TryCatch try_catch(isolate);
   try_catch.SetVerbose(true);
 
-  v8::Handle<v8::Script> script(v8::Script::Compile(v8_code));
-  if (try_catch.HasCaught()) {
+  v8::Local<v8::Script> script;
+  if (!XWalkExtensionCodeCache::GetInstance()->Compile(
+          context, extension_name, code).ToLocal(&script) ||
+      try_catch.HasCaught()) {
     *exception = ExceptionToString(try_catch);
     return handle_scope.Escape(
         v8::Local<v8::Primitive>(v8::Undefined(isolate)));
@@ -157,7 +169,7 @@ void XWalkExtensionModule::LoadExtensionCode(
   std::string exception;
   std::string wrapped_api_code = WrapAPICode(extension_code_, extension_name_);
   v8::Handle<v8::Value> result =
-      RunString(wrapped_api_code, &exception);
+      RunString(context, extension_name_, wrapped_api_code, &exception);
   if (!result->IsFunction()) {
     LOG(WARNING) << "Couldn't load JS API code for " << extension_name_
       << ": " << exception;
@@ -196,13 +208,89 @@ void XWalkExtensionModule::HandleMessageFromNative(const base::Value& msg) {
   v8::Context::Scope context_scope(context);
 
   v8::Handle<v8::Value> v8_value(converter_->ToV8Value(&msg, context));
+  CallMessageListener(context, v8_value);
+}
+
+void XWalkExtensionModule::HandleMessageBatchFromNative(
+    const base::ListValue& msgs) {
+  if (message_listener_.IsEmpty())
+    return;
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Context> context = module_system_->GetV8Context();
+  v8::Context::Scope context_scope(context);
+
+  // The whole batch is delivered from a single entry, but the listener still
+  // sees one message per call, with a microtask checkpoint after each of them
+  // like when the messages arrived in separate tasks.
+  for (base::ListValue::const_iterator it = msgs.begin(); it != msgs.end();
+       ++it) {
+    // The listener might have been unset while handling a previous message.
+    if (message_listener_.IsEmpty())
+      return;
+
+    v8::HandleScope message_scope(isolate);
+    CallMessageListener(context, converter_->ToV8Value(it->get(), context));
+    v8::MicrotasksScope::PerformCheckpoint(isolate);
+  }
+}
+
+void XWalkExtensionModule::HandleBinaryMessageFromNative(const char* data,
+                                                         size_t size) {
+  if (message_listener_.IsEmpty())
+    return;
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Context> context = module_system_->GetV8Context();
+  v8::Context::Scope context_scope(context);
+
+  // Copy the payload straight from the IPC buffer into the ArrayBuffer
+  // backing store, without going through base::BinaryValue.
+  v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, size);
+  if (size)
+    memcpy(buffer->GetContents().Data(), data, size);
+  CallMessageListener(context, buffer);
+}
+
+void XWalkExtensionModule::HandleReplyFromNative(int request_id,
+                                                 const base::Value& reply) {
+  PendingRequestMap::iterator it = pending_requests_.find(request_id);
+  if (it == pending_requests_.end()) {
+    LOG(WARNING) << "Got reply for invalid request id: " << request_id;
+    return;
+  }
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Context> context = module_system_->GetV8Context();
+  v8::Context::Scope context_scope(context);
+
+  v8::Local<v8::Promise::Resolver> resolver =
+      v8::Local<v8::Promise::Resolver>::New(isolate, it->second);
+  pending_requests_.erase(it);
+
+  {
+    v8::MicrotasksScope microtasks(
+        isolate, v8::MicrotasksScope::kDoNotRunMicrotasks);
+    resolver->Resolve(context, converter_->ToV8Value(&reply, context))
+        .FromMaybe(false);
+  }
+  // Run the promise reactions right away, like when resolving from a task.
+  v8::MicrotasksScope::PerformCheckpoint(isolate);
+}
+
+void XWalkExtensionModule::CallMessageListener(
+    v8::Handle<v8::Context> context, v8::Handle<v8::Value> value) {
+  v8::Isolate* isolate = context->GetIsolate();
   v8::Handle<v8::Function> message_listener =
-      v8::Local<v8::Function>::New(isolate, message_listener_);;
+      v8::Local<v8::Function>::New(isolate, message_listener_);
 
   v8::MicrotasksScope microtasks(
       isolate, v8::MicrotasksScope::kDoNotRunMicrotasks);
   v8::TryCatch try_catch(isolate);
-  message_listener->Call(context->Global(), 1, &v8_value);
+  message_listener->Call(context->Global(), 1, &value);
   if (try_catch.HasCaught())
     LOG(WARNING) << "Exception when running message listener: "
         << ExceptionToString(try_catch);
@@ -218,11 +306,35 @@ void XWalkExtensionModule::PostMessageCallback(
     return;
   }
 
+  CHECK(module->instance_id_);
+
+  // ArrayBuffers and their views are posted as raw bytes, read directly
+  // from the backing store instead of being converted to base::BinaryValue.
+  if (info[0]->IsArrayBuffer() || info[0]->IsArrayBufferView()) {
+    v8::Local<v8::ArrayBuffer> buffer;
+    size_t offset = 0;
+    size_t length = 0;
+    if (info[0]->IsArrayBuffer()) {
+      buffer = info[0].As<v8::ArrayBuffer>();
+      length = buffer->ByteLength();
+    } else {
+      v8::Local<v8::ArrayBufferView> view = info[0].As<v8::ArrayBufferView>();
+      buffer = view->Buffer();
+      offset = view->ByteOffset();
+      length = view->ByteLength();
+    }
+    const char* data =
+        static_cast<const char*>(buffer->GetContents().Data()) + offset;
+    module->client_->PostBinaryMessageToNative(module->instance_id_,
+                                               data, length);
+    result.Set(true);
+    return;
+  }
+
   v8::Handle<v8::Context> context = info.GetIsolate()->GetCurrentContext();
   std::unique_ptr<base::Value> value(
       module->converter_->FromV8Value(info[0], context));
 
-  CHECK(module->instance_id_);
   module->client_->PostMessageToNative(module->instance_id_, std::move(value));
   result.Set(true);
 }
@@ -252,6 +364,43 @@ void XWalkExtensionModule::SendSyncMessageCallback(
     result.Set(module->converter_->ToV8Value(reply.get(), context));
 }
 
+// static
+void XWalkExtensionModule::SendRequestCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::ReturnValue<v8::Value> result(info.GetReturnValue());
+  XWalkExtensionModule* module = GetExtensionModule(info);
+  if (!module || info.Length() != 1) {
+    result.Set(false);
+    return;
+  }
+
+  v8::Isolate* isolate = info.GetIsolate();
+  v8::Handle<v8::Context> context = isolate->GetCurrentContext();
+  v8::Local<v8::Promise::Resolver> resolver;
+  if (!v8::Promise::Resolver::New(context).ToLocal(&resolver)) {
+    result.Set(false);
+    return;
+  }
+
+  std::unique_ptr<base::Value> value(
+      module->converter_->FromV8Value(info[0], context));
+
+  CHECK(module->instance_id_);
+  int request_id = module->next_request_id_++;
+  if (!module->client_->PostRequestToNative(module->instance_id_, request_id,
+                                            std::move(value))) {
+    // No reply will ever come, fail the request right away.
+    resolver->Reject(context, v8::Exception::Error(v8::String::NewFromUtf8(
+        isolate, "Can't send request to native"))).FromMaybe(false);
+    result.Set(resolver->GetPromise());
+    return;
+  }
+  module->pending_requests_[request_id] =
+      v8::Global<v8::Promise::Resolver>(isolate, resolver);
+
+  result.Set(resolver->GetPromise());
+}
+
 // static
 void XWalkExtensionModule::SetMessageListenerCallback(
     const v8::FunctionCallbackInfo<v8::Value>& info) {
@@ -269,10 +418,14 @@ void XWalkExtensionModule::SetMessageListenerCallback(
   }
 
   v8::Isolate* isolate = info.GetIsolate();
-  if (info[0]->IsUndefined())
+  if (info[0]->IsUndefined()) {
     module->message_listener_.Reset();
-  else
+  } else {
     module->message_listener_.Reset(isolate, info[0].As<v8::Function>());
+    // The native instance might post messages without being asked first.
+    CHECK(module->instance_id_);
+    module->client_->EnsureInstanceCreated(module->instance_id_);
+  }
 
   result.Set(true);
 }
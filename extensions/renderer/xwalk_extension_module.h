@@ -5,6 +5,7 @@
 #ifndef XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_MODULE_H_
 #define XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_MODULE_H_
 
+#include <map>
 #include <string>
 #include "xwalk/extensions/renderer/xwalk_extension_client.h"
 #include "xwalk/extensions/renderer/xwalk_module_system.h"
@@ -47,12 +48,22 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
  private:
   // XWalkExtensionClient::InstanceHandler implementation.
   void HandleMessageFromNative(const base::Value& msg) override;
+  void HandleMessageBatchFromNative(const base::ListValue& msgs) override;
+  void HandleBinaryMessageFromNative(const char* data, size_t size) override;
+  void HandleReplyFromNative(int request_id, const base::Value& reply) override;
+
+  // Calls the listener set by 'extension.setMessageListener()' with |value|.
+  // Must be called with the module system context entered.
+  void CallMessageListener(v8::Handle<v8::Context> context,
+                           v8::Handle<v8::Value> value);
 
   // Callbacks for JS functions available in 'extension' object.
   static void PostMessageCallback(
       const v8::FunctionCallbackInfo<v8::Value>& info);
   static void SendSyncMessageCallback(
       const v8::FunctionCallbackInfo<v8::Value>& info);
+  static void SendRequestCallback(
+      const v8::FunctionCallbackInfo<v8::Value>& info);
   static void SetMessageListenerCallback(
       const v8::FunctionCallbackInfo<v8::Value>& info);
 
@@ -70,6 +81,12 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
   // This value is registered by using 'extension.setMessageListener()'.
   v8::Persistent<v8::Function> message_listener_;
 
+  // Promises returned by 'extension.internal.sendRequest()' waiting for the
+  // reply from native.
+  typedef std::map<int, v8::Global<v8::Promise::Resolver>> PendingRequestMap;
+  PendingRequestMap pending_requests_;
+  int next_request_id_;
+
   std::string extension_name_;
   std::string extension_code_;
 
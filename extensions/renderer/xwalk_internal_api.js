@@ -3,25 +3,41 @@
 // found in the LICENSE file.
 
 var callback_listeners = {};
-var callback_id = 0;
+var callback_id = 1;
+var function_ids = {};
+var next_function_id = 0;
 var extension_object;
 
 function wrapCallback(args, callback) {
-  if (callback) {
-    var id = (callback_id++).toString();
-    callback_listeners[id] = callback;
-    args.unshift(id);
-  } else {
-    // The function name and the callback ID are prepended before
-    // the arguments. If there is no callback, an empty string is
-    // should be used. This will be sorted out by the InternalInstance
-    // message handler.
-    args.unshift("");
+  // The callback ID and the function ID are appended after the arguments,
+  // see XWalkExtensionFunctionHandler::HandleMessage(). If there is no
+  // callback, 0 should be used.
+  if (!callback) {
+    args.push(0);
+    return;
   }
 
+  var id = callback_id++;
+  callback_listeners[id] = callback;
+  args.push(id);
+
   return id;
 }
 
+function appendFunctionId(args, function_name) {
+  var id = function_ids[function_name];
+  if (id !== undefined) {
+    args.push(id);
+    return;
+  }
+
+  // The first call to a function carries its name, which the native side
+  // binds to the ID for the following calls.
+  id = next_function_id++;
+  function_ids[function_name] = id;
+  args.push(id, function_name);
+}
+
 exports.setupInternalExtension = function(extension_obj) {
   if (extension_object != null)
     return;
@@ -42,14 +58,14 @@ exports.setupInternalExtension = function(extension_obj) {
 
 exports.postMessage = function(function_name, args, callback) {
   var id = wrapCallback(args, callback);
-  args.unshift(function_name);
+  appendFunctionId(args, function_name);
   extension_object.postMessage(args);
 
   return id;
 };
 
 exports.removeCallback = function(id) {
-  if (!id in callback_listeners)
+  if (!(id in callback_listeners))
     return;
 
   delete callback_listeners[id];
@@ -4,7 +4,12 @@
 
 #include "xwalk/extensions/renderer/xwalk_v8tools_module.h"
 
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
 #include "base/logging.h"
+#include "base/memory/ref_counted.h"
 #include "content/public/renderer/render_view.h"
 #include "ipc/ipc_message.h"
 #include "third_party/WebKit/public/web/WebFrame.h"
@@ -51,11 +56,13 @@ void LifecycleTrackerCleanup2(
   LifecycleTrackerWrapper* wrapper = data.GetParameter();
   if (!wrapper->destructor.IsEmpty()) {
     v8::HandleScope handle_scope(data.GetIsolate());
-    v8::Local<v8::Context> context = v8::Context::New(data.GetIsolate());
-    v8::Context::Scope scope(context);
     v8::Local<v8::Function> destructor =
         wrapper->destructor.Get(data.GetIsolate());
     CHECK(destructor->IsFunction());
+    // The destructor keeps the context it was created in alive, run it there
+    // instead of paying for a brand new context per collected object.
+    v8::Local<v8::Context> context = destructor->CreationContext();
+    v8::Context::Scope scope(context);
     v8::MicrotasksScope microtasks(
       data.GetIsolate(), v8::MicrotasksScope::kDoNotRunMicrotasks);
     v8::TryCatch try_catch(data.GetIsolate());
@@ -138,6 +145,184 @@ void LifecycleTracker(const v8::FunctionCallbackInfo<v8::Value>& info) {
   info.GetReturnValue().Set(wrapper->handle);
 }
 
+// ===================
+// collectionNotifier
+// ===================
+// Shared by all the objects tracked by a notifier. The IDs of the objects
+// collected are accumulated and handed to the callback in one call, from a
+// task posted by the first one collected: all the objects dying in the same
+// garbage collection end up in the same batch.
+class CollectionNotifier : public base::RefCounted<CollectionNotifier> {
+ public:
+  CollectionNotifier(v8::Isolate* isolate, v8::Local<v8::Function> callback)
+      : isolate_(isolate),
+        callback_(isolate, callback),
+        flush_pending_(false) {
+    // The notifier object returned to JavaScript holds a reference to
+    // |callback|, the handles here are weak so the notifier doesn't keep its
+    // context alive.
+    callback_.SetWeak();
+  }
+
+  // |track| is the function calling Track(), it references this notifier
+  // until collected.
+  void SetTrackFunction(v8::Local<v8::Function> track) {
+    AddRef();
+    track_function_.Reset(isolate_, track);
+    track_function_.SetWeak(this, &CollectionNotifier::OnTrackFunctionCollected,
+                            v8::WeakCallbackType::kParameter);
+  }
+
+  void Track(v8::Local<v8::Object> object, int32_t id);
+
+ private:
+  friend class base::RefCounted<CollectionNotifier>;
+
+  struct TrackedObject {
+    v8::Global<v8::Object> handle;
+    int32_t id;
+    scoped_refptr<CollectionNotifier> notifier;
+  };
+
+  ~CollectionNotifier() {}
+
+  static void OnTrackFunctionCollected(
+      const v8::WeakCallbackInfo<CollectionNotifier>& data);
+  static void OnObjectCollected(
+      const v8::WeakCallbackInfo<TrackedObject>& data);
+
+  void Flush();
+
+  v8::Isolate* isolate_;
+  v8::Global<v8::Function> track_function_;
+  v8::Global<v8::Function> callback_;
+
+  std::vector<int32_t> collected_ids_;
+  bool flush_pending_;
+};
+
+void CollectionNotifier::Track(v8::Local<v8::Object> object, int32_t id) {
+  TrackedObject* tracked = new TrackedObject;
+  tracked->handle.Reset(isolate_, object);
+  tracked->id = id;
+  tracked->notifier = this;
+  tracked->handle.SetWeak(tracked, &CollectionNotifier::OnObjectCollected,
+                          v8::WeakCallbackType::kParameter);
+}
+
+// static
+void CollectionNotifier::OnTrackFunctionCollected(
+    const v8::WeakCallbackInfo<CollectionNotifier>& data) {
+  CollectionNotifier* notifier = data.GetParameter();
+  notifier->track_function_.Reset();
+  notifier->Release();
+}
+
+// static
+void CollectionNotifier::OnObjectCollected(
+    const v8::WeakCallbackInfo<TrackedObject>& data) {
+  std::unique_ptr<TrackedObject> tracked(data.GetParameter());
+  tracked->handle.Reset();
+
+  CollectionNotifier* notifier = tracked->notifier.get();
+  notifier->collected_ids_.push_back(tracked->id);
+  if (notifier->flush_pending_)
+    return;
+
+  // Like LifecycleTrackerCleanup1(), script can't run while in the GC.
+  notifier->flush_pending_ = true;
+  base::MessageLoop::current()->task_runner()->PostTask(
+      FROM_HERE, base::Bind(&CollectionNotifier::Flush,
+                            make_scoped_refptr(notifier)));
+}
+
+void CollectionNotifier::Flush() {
+  flush_pending_ = false;
+
+  std::vector<int32_t> ids;
+  ids.swap(collected_ids_);
+
+  // The page is gone, nobody to notify.
+  if (callback_.IsEmpty())
+    return;
+
+  v8::HandleScope handle_scope(isolate_);
+  v8::Local<v8::Function> callback = callback_.Get(isolate_);
+  v8::Local<v8::Context> context = callback->CreationContext();
+  v8::Context::Scope scope(context);
+
+  v8::Local<v8::Array> array = v8::Array::New(isolate_, ids.size());
+  for (size_t i = 0; i < ids.size(); ++i)
+    array->Set(context, i, v8::Integer::New(isolate_, ids[i])).FromJust();
+
+  v8::MicrotasksScope microtasks(
+    isolate_, v8::MicrotasksScope::kDoNotRunMicrotasks);
+  v8::TryCatch try_catch(isolate_);
+  v8::Local<v8::Value> argv[] = { array };
+  callback->Call(context->Global(), 1, argv);
+  if (try_catch.HasCaught()) {
+    LOG(WARNING) << "Exception when running collectionNotifier callback: "
+                 << ExceptionToString(try_catch);
+  }
+}
+
+void CollectionNotifierTrack(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  CHECK(info.Data()->IsExternal());
+  CollectionNotifier* notifier = static_cast<CollectionNotifier*>(
+      info.Data().As<v8::External>()->Value());
+
+  if (info.Length() != 2 || !info[0]->IsObject() || !info[1]->IsInt32()) {
+    info.GetIsolate()->ThrowException(
+        v8::Exception::TypeError(v8::String::NewFromUtf8(
+            info.GetIsolate(),
+            "track() expects an object and an integer ID.")));
+    return;
+  }
+
+  notifier->Track(info[0].As<v8::Object>(), info[1].As<v8::Int32>()->Value());
+}
+
+// Returns an object whose track(object, id) method registers |object| to be
+// watched. |callback| is later called with the array of the IDs of the
+// objects collected since its previous call.
+void CollectionNotifierCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::Isolate* isolate = info.GetIsolate();
+  v8::HandleScope handle_scope(isolate);
+
+  if (info.Length() != 1 || !info[0]->IsFunction()) {
+    isolate->ThrowException(v8::Exception::TypeError(v8::String::NewFromUtf8(
+        isolate, "collectionNotifier() expects a callback function.")));
+    return;
+  }
+
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  v8::Local<v8::Function> callback = info[0].As<v8::Function>();
+  v8::Local<v8::Object> notifier_object = v8::Object::New(isolate);
+
+  scoped_refptr<CollectionNotifier> notifier(
+      new CollectionNotifier(isolate, callback));
+
+  v8::Local<v8::Function> track;
+  if (!v8::Function::New(context, CollectionNotifierTrack,
+                         v8::External::New(isolate, notifier.get()))
+           .ToLocal(&track)) {
+    return;
+  }
+  notifier->SetTrackFunction(track);
+
+  v8::PropertyAttribute attributes = static_cast<v8::PropertyAttribute>(
+      v8::ReadOnly | v8::DontDelete);
+  notifier_object->DefineOwnProperty(
+      context, v8::String::NewFromUtf8(isolate, "track"), track,
+      attributes).FromJust();
+  notifier_object->DefineOwnProperty(
+      context, v8::String::NewFromUtf8(isolate, "callback"), callback,
+      attributes).FromJust();
+
+  info.GetReturnValue().Set(notifier_object);
+}
+
 // ===============
 // getWindowObject
 // ===============
@@ -199,6 +384,9 @@ XWalkV8ToolsModule::XWalkV8ToolsModule() {
                           isolate, ForceSetPropertyCallback));
   object_template->Set(v8::String::NewFromUtf8(isolate, "lifecycleTracker"),
                        v8::FunctionTemplate::New(isolate, LifecycleTracker));
+  object_template->Set(v8::String::NewFromUtf8(isolate, "collectionNotifier"),
+                       v8::FunctionTemplate::New(
+                          isolate, CollectionNotifierCallback));
   object_template->Set(v8::String::NewFromUtf8(isolate, "getWindowObject"),
                        v8::FunctionTemplate::New(isolate, GetWindowObject));
 
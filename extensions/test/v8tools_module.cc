@@ -31,6 +31,9 @@ class TestV8ToolsExtension : public XWalkExtension {
         "};"
         "exports.lifecycleTracker = function() {"
         "  return v8tools.lifecycleTracker();"
+        "};"
+        "exports.collectionNotifier = function(callback) {"
+        "  return v8tools.collectionNotifier(callback);"
         "};");
   }
 
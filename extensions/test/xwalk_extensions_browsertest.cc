@@ -4,6 +4,8 @@
 
 #include "xwalk/extensions/test/xwalk_extensions_test_base.h"
 
+#include <algorithm>
+
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/runtime/browser/runtime.h"
 #include "xwalk/test/base/in_process_browser_test.h"
@@ -31,6 +33,9 @@ const char* kEchoAPI =
     "};"
     "exports.syncEcho = function(msg) {"
     "  return extension.internal.sendSyncMessage(msg);"
+    "};"
+    "exports.requestEcho = function(msg) {"
+    "  return extension.internal.sendRequest(msg);"
     "};";
 
 class EchoContext : public XWalkExtensionInstance {
@@ -43,6 +48,10 @@ class EchoContext : public XWalkExtensionInstance {
   void HandleSyncMessage(std::unique_ptr<base::Value> msg) override {
     SendSyncReplyToJS(std::move(msg));
   }
+  void HandleRequest(int request_id,
+                     std::unique_ptr<base::Value> msg) override {
+    SendRequestReplyToJS(request_id, std::move(msg));
+  }
 };
 
 class DelayedEchoContext : public XWalkExtensionInstance {
@@ -57,9 +66,24 @@ class DelayedEchoContext : public XWalkExtensionInstance {
         base::TimeDelta::FromSeconds(1));
   }
 
+  // Replies in the reverse order of the requests.
+  void HandleRequest(int request_id,
+                     std::unique_ptr<base::Value> msg) override {
+    base::MessageLoop::current()->PostDelayedTask(
+        FROM_HERE, base::Bind(&DelayedEchoContext::DelayedRequestReply,
+                              base::Unretained(this), request_id,
+                              base::Passed(&msg)),
+        base::TimeDelta::FromMilliseconds(std::max(0, 300 - 100 * request_id)));
+  }
+
   void DelayedReply(std::unique_ptr<base::Value> reply) {
     SendSyncReplyToJS(std::move(reply));
   }
+
+  void DelayedRequestReply(int request_id,
+                           std::unique_ptr<base::Value> reply) {
+    SendRequestReplyToJS(request_id, std::move(reply));
+  }
 };
 
 class EchoExtension : public XWalkExtension {
@@ -107,6 +131,23 @@ class ExtensionWithInvalidName : public XWalkExtension {
 
 bool ExtensionWithInvalidName::s_instance_was_created = false;
 
+class LazyExtension : public XWalkExtension {
+ public:
+  LazyExtension() : XWalkExtension() {
+    set_name("lazy");
+    set_javascript_api("exports.value = 42;");
+  }
+
+  XWalkExtensionInstance* CreateInstance() override {
+    s_instance_was_created = true;
+    return new EchoContext();
+  }
+
+  static bool s_instance_was_created;
+};
+
+bool LazyExtension::s_instance_was_created = false;
+
 }  // namespace
 
 class XWalkExtensionsTest : public XWalkExtensionsTestBase {
@@ -115,6 +156,7 @@ class XWalkExtensionsTest : public XWalkExtensionsTestBase {
       XWalkExtensionVector* extensions) override {
     extensions->push_back(new EchoExtension);
     extensions->push_back(new ExtensionWithInvalidName);
+    extensions->push_back(new LazyExtension);
   }
 };
 
@@ -170,3 +212,39 @@ IN_PROC_BROWSER_TEST_F(XWalkExtensionsDelayedTest, EchoExtensionSync) {
   xwalk_test_utils::NavigateToURL(runtime, url);
   EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
 }
+
+IN_PROC_BROWSER_TEST_F(XWalkExtensionsTest, EchoExtensionRequest) {
+  Runtime* runtime = CreateRuntime();
+  GURL url = GetExtensionsTestURL(base::FilePath(),
+                                  base::FilePath().AppendASCII(
+                                      "request_echo.html"));
+  content::TitleWatcher title_watcher(runtime->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime, url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+}
+
+IN_PROC_BROWSER_TEST_F(XWalkExtensionsDelayedTest, EchoExtensionRequest) {
+  Runtime* runtime = CreateRuntime();
+  GURL url = GetExtensionsTestURL(base::FilePath(),
+                                  base::FilePath().AppendASCII(
+                                      "request_echo.html"));
+  content::TitleWatcher title_watcher(runtime->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime, url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+}
+
+IN_PROC_BROWSER_TEST_F(XWalkExtensionsTest, InstanceCreatedOnFirstMessage) {
+  Runtime* runtime = CreateRuntime();
+  GURL url = GetExtensionsTestURL(base::FilePath(),
+                                  base::FilePath().AppendASCII(
+                                      "lazy_instance.html"));
+  content::TitleWatcher title_watcher(runtime->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime, url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+
+  EXPECT_TRUE(EchoExtension::s_instance_was_created);
+  EXPECT_FALSE(LazyExtension::s_instance_was_created);
+}
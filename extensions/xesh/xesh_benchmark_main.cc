@@ -0,0 +1,378 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This is the XWalk Extensions IPC benchmark. It runs XESh's V8 runner
+// against an in process XWalkExtensionServer hosting an echo extension, and
+// measures round trip latency, messages per second and MB/s for string, JSON
+// object, binary and sync messages across payload sizes. Payloads bigger than
+// the inline limit come back to JS through the shared memory ring or a
+// dedicated segment. The "path" column reports what the server actually used
+// during the case: inline, ring, shared-memory or ring+shared-memory.
+//
+// Results are printed to stdout as CSV:
+//   kind,size,path,iterations,latency_us,messages_per_sec,mb_per_sec
+//
+// Usage: xesh_benchmark [--max-size=BYTES] [V8 flags]
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+
+#include "base/at_exit.h"
+#include "base/command_line.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task_runner_util.h"
+#include "base/threading/thread.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/values.h"
+#include "ipc/ipc_sync_channel.h"
+#include "mojo/edk/embedder/embedder.h"
+#include "mojo/edk/embedder/scoped_ipc_support.h"
+#include "mojo/public/cpp/system/message_pipe.h"
+#include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_server.h"
+#include "xwalk/extensions/xesh/xesh_v8_runner.h"
+
+using xwalk::extensions::XWalkExtension;
+using xwalk::extensions::XWalkExtensionInstance;
+using xwalk::extensions::XWalkExtensionServer;
+
+// Skips the payloads bigger than this many bytes.
+const char kMaxSize[] = "max-size";
+
+namespace {
+
+const int64_t kDefaultMaxSize = 64 * 1024 * 1024;
+
+const char kBenchmarkAPI[] =
+    "var listener = null;"
+    "extension.setMessageListener(function(msg) {"
+    "  listener(msg);"
+    "});"
+    "exports.setListener = function(callback) {"
+    "  listener = callback;"
+    "};"
+    "exports.post = function(msg) {"
+    "  extension.postMessage(msg);"
+    "};"
+    "exports.syncEcho = function(msg) {"
+    "  return extension.internal.sendSyncMessage(msg);"
+    "};"
+    // How many messages the server sent through the ring and through
+    // dedicated shared memory so far.
+    "exports.pathStats = function() {"
+    "  return extension.internal.sendSyncMessage("
+    "      {benchmarkCommand: 'pathStats'});"
+    "};"
+    "exports.finish = function() {"
+    "  extension.internal.sendSyncMessage({benchmarkCommand: 'finish'});"
+    "};";
+
+// Runs every case in turn, each one driven by the replies of the previous
+// message, and finishes when done. Date.now() only has millisecond resolution,
+// so the iteration counts keep every case well above that.
+const char kBenchmarkScript[] =
+    "var KB = 1024;"
+    "var MB = 1024 * KB;"
+    "var kSizes = [16, 256, 4 * KB, 64 * KB, 192 * KB, 1 * MB, 4 * MB,"
+    "              16 * MB, 64 * MB];"
+    "var kKinds = ['string', 'json', 'binary', 'sync'];"
+    ""
+    "function pathSince(before) {"
+    "  var after = benchmark.pathStats();"
+    "  var ring = after.ring - before.ring;"
+    "  var sharedMemory = after.sharedMemory - before.sharedMemory;"
+    "  if (!ring && !sharedMemory)"
+    "    return 'inline';"
+    "  if (!sharedMemory)"
+    "    return 'ring';"
+    "  return ring ? 'ring+shared-memory' : 'shared-memory';"
+    "}"
+    ""
+    "function makePayload(kind, size) {"
+    "  if (kind == 'binary')"
+    "    return new Uint8Array(size);"
+    "  if (kind != 'json')"
+    "    return new Array(size + 1).join('x');"
+    // Roughly |size| bytes once serialized: ~24 bytes per property.
+    "  var object = {};"
+    "  var count = Math.max(1, Math.floor(size / 24));"
+    "  for (var i = 0; i < count; i++)"
+    "    object['k' + i] = 'xxxxxxxxxxxxxxxx';"
+    "  return object;"
+    "}"
+    ""
+    "function report(kind, size, path, iterations, latency_ms,"
+    "                throughput_ms) {"
+    "  var seconds = Math.max(throughput_ms, 1) / 1000;"
+    "  print([kind, size, path, iterations,"
+    "         (latency_ms * 1000 / iterations).toFixed(1),"
+    "         (iterations / seconds).toFixed(0),"
+    "         (size * iterations / seconds / MB).toFixed(1)].join(','));"
+    "}"
+    ""
+    "function runSync(payload, iterations) {"
+    "  benchmark.syncEcho(payload);"
+    "  var start = Date.now();"
+    "  for (var i = 0; i < iterations; i++)"
+    "    benchmark.syncEcho(payload);"
+    "  return Date.now() - start;"
+    "}"
+    ""
+    // Measures one message in flight at a time, then a window of them.
+    "function runAsync(payload, size, iterations, done) {"
+    "  var window = Math.max(1, Math.min(64, Math.floor(16 * MB / size)));"
+    "  var latency_ms = 0;"
+    "  var sent = 0;"
+    "  var received = 0;"
+    "  var start = 0;"
+    "  function startThroughput() {"
+    "    sent = received = 0;"
+    "    benchmark.setListener(function() {"
+    "      if (++received == iterations) {"
+    "        done(latency_ms, Date.now() - start);"
+    "        return;"
+    "      }"
+    "      if (sent < iterations) {"
+    "        sent++;"
+    "        benchmark.post(payload);"
+    "      }"
+    "    });"
+    "    start = Date.now();"
+    "    for (; sent < Math.min(window, iterations); sent++)"
+    "      benchmark.post(payload);"
+    "  }"
+    "  benchmark.setListener(function() {"
+    "    if (start == 0) {"
+    "      start = Date.now();"
+    "    } else if (++received == iterations) {"
+    "      latency_ms = Date.now() - start;"
+    "      startThroughput();"
+    "      return;"
+    "    }"
+    "    benchmark.post(payload);"
+    "  });"
+    // The first round trip warms up the instance and isn't measured.
+    "  benchmark.post(payload);"
+    "}"
+    ""
+    "var cases = [];"
+    "kKinds.forEach(function(kind) {"
+    "  kSizes.forEach(function(size) {"
+    "    if (size <= kMaxSize)"
+    "      cases.push({kind: kind, size: size});"
+    "  });"
+    "});"
+    ""
+    "function runNext() {"
+    "  var c = cases.shift();"
+    "  if (!c) {"
+    "    benchmark.finish();"
+    "    return;"
+    "  }"
+    "  var payload = makePayload(c.kind, c.size);"
+    "  var stats = benchmark.pathStats();"
+    "  var iterations ="
+    "      Math.max(5, Math.min(2000, Math.floor(256 * MB / c.size)));"
+    "  if (c.kind == 'sync') {"
+    "    var elapsed = runSync(payload, iterations);"
+    "    report(c.kind, c.size, pathSince(stats), iterations, elapsed,"
+    "           elapsed);"
+    "    runNext();"
+    "    return;"
+    "  }"
+    "  runAsync(payload, c.size, iterations,"
+    "           function(latency_ms, throughput_ms) {"
+    "    report(c.kind, c.size, pathSince(stats), iterations, latency_ms,"
+    "           throughput_ms);"
+    "    runNext();"
+    "  });"
+    "}"
+    ""
+    "print('kind,size,path,iterations,latency_us,messages_per_sec,"
+    "mb_per_sec');"
+    "runNext();";
+
+class BenchmarkExtension;
+
+class BenchmarkInstance : public XWalkExtensionInstance {
+ public:
+  explicit BenchmarkInstance(BenchmarkExtension* extension)
+      : extension_(extension) {}
+
+  void HandleMessage(std::unique_ptr<base::Value> msg) override {
+    PostMessageToJS(std::move(msg));
+  }
+  void HandleBinaryMessage(const char* data, size_t size) override {
+    PostBinaryMessageToJS(data, size);
+  }
+  void HandleSyncMessage(std::unique_ptr<base::Value> msg) override;
+
+ private:
+  BenchmarkExtension* extension_;
+};
+
+class BenchmarkExtension : public XWalkExtension {
+ public:
+  // |server| hosts the extension, |finish_closure| is posted to the current
+  // thread once every case ran.
+  BenchmarkExtension(XWalkExtensionServer* server,
+                     const base::Closure& finish_closure)
+      : XWalkExtension(),
+        server_(server),
+        finish_closure_(finish_closure),
+        task_runner_(base::ThreadTaskRunnerHandle::Get()) {
+    set_name("benchmark");
+    set_javascript_api(kBenchmarkAPI);
+  }
+
+  XWalkExtensionInstance* CreateInstance() override {
+    return new BenchmarkInstance(this);
+  }
+
+  std::unique_ptr<base::Value> RunCommand(const std::string& command) {
+    if (command == "finish") {
+      task_runner_->PostTask(FROM_HERE, finish_closure_);
+      return base::Value::CreateNullValue();
+    }
+
+    std::unique_ptr<base::DictionaryValue> stats(new base::DictionaryValue);
+    stats->SetInteger("ring", server_->ring_message_count());
+    stats->SetInteger("sharedMemory", server_->shared_memory_message_count());
+    return std::move(stats);
+  }
+
+ private:
+  XWalkExtensionServer* server_;
+  base::Closure finish_closure_;
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+};
+
+void BenchmarkInstance::HandleSyncMessage(std::unique_ptr<base::Value> msg) {
+  base::DictionaryValue* dict;
+  std::string command;
+  if (msg->GetAsDictionary(&dict) &&
+      dict->GetString("benchmarkCommand", &command)) {
+    SendSyncReplyToJS(extension_->RunCommand(command));
+    return;
+  }
+  SendSyncReplyToJS(std::move(msg));
+}
+
+// Same as XESh's, but hosting the benchmark extension instead of loading
+// external ones.
+class ExtensionManager {
+ public:
+  explicit ExtensionManager(const base::Closure& finish_closure)
+    : shutdown_event_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                      base::WaitableEvent::InitialState::NOT_SIGNALED) {
+    server_.RegisterExtension(std::unique_ptr<XWalkExtension>(
+        new BenchmarkExtension(&server_, finish_closure)));
+  }
+
+  ~ExtensionManager() {
+    shutdown_event_.Signal();
+  }
+
+  // Like the extension process, connects the server and the V8 runner
+  // through a Mojo message pipe, the runner gets the other end.
+  void Initialize(scoped_refptr<base::SingleThreadTaskRunner> io_task_runner) {
+    mojo::MessagePipe pipe;
+
+    server_channel_ =
+        IPC::SyncChannel::Create(pipe.handle0.release(),
+                                 IPC::Channel::MODE_SERVER, &server_,
+                                 io_task_runner, true, &shutdown_event_);
+    handle_ = pipe.handle1.release();
+
+    server_.Initialize(server_channel_.get());
+  }
+
+  const IPC::ChannelHandle& ipc_channel_handle() { return handle_; }
+
+ private:
+  IPC::ChannelHandle handle_;
+  base::WaitableEvent shutdown_event_;
+  XWalkExtensionServer server_;
+  std::unique_ptr<IPC::SyncChannel> server_channel_;
+};
+
+// The script finishes through the extension once every case ran, so getting
+// a result back means it failed.
+void OnScriptExecuted(const base::Closure& quit_closure, bool* failed,
+                      const std::string& result) {
+  if (result.empty())
+    return;
+  fprintf(stderr, "%s\n", result.c_str());
+  *failed = true;
+  quit_closure.Run();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  base::AtExitManager exit_manager;
+  base::CommandLine::Init(argc, argv);
+
+  int64_t max_size = kDefaultMaxSize;
+  base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
+  if (cmd_line->HasSwitch(kMaxSize) &&
+      !base::StringToInt64(cmd_line->GetSwitchValueASCII(kMaxSize),
+                           &max_size)) {
+    fprintf(stderr, "Invalid --%s value.\n", kMaxSize);
+    return 1;
+  }
+
+  base::MessageLoop main_message_loop(base::MessageLoop::TYPE_UI);
+  main_message_loop.set_thread_name("XESh_Main");
+
+  base::Thread io_thread("XESh_IOThread");
+  io_thread.StartWithOptions(base::Thread::Options(base::MessageLoop::TYPE_IO,
+      0));
+
+  mojo::edk::Init();
+  mojo::edk::ScopedIPCSupport ipc_support(
+      io_thread.task_runner(),
+      mojo::edk::ScopedIPCSupport::ShutdownPolicy::FAST);
+
+  base::Thread v8_thread("XESh_V8Thread");
+  v8_thread.StartWithOptions(base::Thread::Options(
+      base::MessageLoop::TYPE_DEFAULT, 0));
+
+  base::RunLoop run_loop;
+  ExtensionManager extension_manager(run_loop.QuitClosure());
+  extension_manager.Initialize(io_thread.task_runner());
+
+  XEShV8Runner v8_runner;
+  v8_thread.task_runner()->PostTask(
+      FROM_HERE, base::Bind(&XEShV8Runner::Initialize,
+                            base::Unretained(&v8_runner), argc, argv,
+                            io_thread.task_runner(),
+                            extension_manager.ipc_channel_handle()));
+
+  bool failed = false;
+  std::string script = base::StringPrintf(
+      "var kMaxSize = %lld;", static_cast<long long>(max_size));  // NOLINT
+  script += kBenchmarkScript;
+  base::PostTaskAndReplyWithResult(
+      v8_thread.task_runner().get(), FROM_HERE,
+      base::Bind(&XEShV8Runner::ExecuteString, base::Unretained(&v8_runner),
+                 script),
+      base::Bind(&OnScriptExecuted, run_loop.QuitClosure(), &failed));
+  run_loop.Run();
+
+  v8_thread.task_runner()->PostTask(
+      FROM_HERE, base::Bind(&XEShV8Runner::Shutdown,
+                            base::Unretained(&v8_runner)));
+
+  io_thread.Stop();
+  v8_thread.Stop();
+  return failed ? 1 : 0;
+}
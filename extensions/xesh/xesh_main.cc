@@ -26,6 +26,9 @@
 #include "base/task_runner_util.h"
 #include "base/threading/thread.h"
 #include "ipc/ipc_sync_channel.h"
+#include "mojo/edk/embedder/embedder.h"
+#include "mojo/edk/embedder/scoped_ipc_support.h"
+#include "mojo/public/cpp/system/message_pipe.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 #include "xwalk/extensions/common/xwalk_extension_switches.h"
 #include "xwalk/extensions/xesh/xesh_v8_runner.h"
@@ -145,7 +148,8 @@ class InputWatcher : public base::MessagePumpLibevent::Watcher {
 class ExtensionManager {
  public:
   ExtensionManager()
-    : shutdown_event_(false, false) {
+    : shutdown_event_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                      base::WaitableEvent::InitialState::NOT_SIGNALED) {
   }
 
   ~ExtensionManager() {
@@ -170,12 +174,16 @@ class ExtensionManager {
       fprintf(stderr, "- %s\n", it->c_str());
   }
 
+  // Like the extension process, connects the server and the V8 runner
+  // through a Mojo message pipe, the runner gets the other end.
   void Initialize(scoped_refptr<base::SingleThreadTaskRunner> io_task_runner) {
-    handle_ = IPC::Channel::GenerateVerifiedChannelID(std::string());
+    mojo::MessagePipe pipe;
 
     server_channel_ =
-        IPC::SyncChannel::Create(handle_, IPC::Channel::MODE_SERVER, &server_,
+        IPC::SyncChannel::Create(pipe.handle0.release(),
+                                 IPC::Channel::MODE_SERVER, &server_,
                                  io_task_runner, true, &shutdown_event_);
+    handle_ = pipe.handle1.release();
 
     server_.Initialize(server_channel_.get());
   }
@@ -203,6 +211,11 @@ int main(int argc, char* argv[]) {
   io_thread.StartWithOptions(base::Thread::Options(base::MessageLoop::TYPE_IO,
       0));
 
+  mojo::edk::Init();
+  mojo::edk::ScopedIPCSupport ipc_support(
+      io_thread.task_runner(),
+      mojo::edk::ScopedIPCSupport::ShutdownPolicy::FAST);
+
   base::Thread v8_thread("XESh_V8Thread");
   v8_thread.StartWithOptions(base::Thread::Options(
       base::MessageLoop::TYPE_DEFAULT, 0));
@@ -212,15 +225,15 @@ int main(int argc, char* argv[]) {
   extension_manager.Initialize(io_thread.task_runner());
 
   XEShV8Runner v8_runner;
-  static_cast<base::MessageLoopForIO*>(v8_thread.message_loop())
-      ->PostTask(FROM_HERE, base::Bind(&XEShV8Runner::Initialize,
-                                       base::Unretained(&v8_runner), argc, argv,
-                                       io_thread.task_runner(),
-                                       extension_manager.ipc_channel_handle()));
+  v8_thread.task_runner()->PostTask(
+      FROM_HERE, base::Bind(&XEShV8Runner::Initialize,
+                            base::Unretained(&v8_runner), argc, argv,
+                            io_thread.task_runner(),
+                            extension_manager.ipc_channel_handle()));
 
   InputWatcher input_watcher(&v8_runner, v8_thread.message_loop());
 
-  static_cast<base::MessageLoopForIO*>(io_thread.message_loop())->PostTask(
+  io_thread.task_runner()->PostTask(
       FROM_HERE, base::Bind(&InputWatcher::StartWatching,
       base::Unretained(&input_watcher)));
 
@@ -228,7 +241,7 @@ int main(int argc, char* argv[]) {
   base::RunLoop run_loop;
   run_loop.Run();
 
-  static_cast<base::MessageLoopForIO*>(v8_thread.message_loop())->PostTask(
+  v8_thread.task_runner()->PostTask(
       FROM_HERE, base::Bind(&XEShV8Runner::Shutdown,
       base::Unretained(&v8_runner)));
 
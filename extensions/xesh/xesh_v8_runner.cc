@@ -9,8 +9,13 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "base/i18n/icu_util.h"
 #include "base/logging.h"
 #include "base/strings/stringprintf.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "gin/array_buffer.h"
+#include "gin/public/isolate_holder.h"
+#include "gin/v8_initializer.h"
 #include "xwalk/extensions/renderer/xwalk_extension_module.h"
 #include "xwalk/extensions/renderer/xwalk_module_system.h"
 #include "xwalk/extensions/renderer/xwalk_v8tools_module.h"
@@ -27,7 +32,8 @@ const char* ToCString(const v8::String::Utf8Value& value) {
 }  // namespace
 
 XEShV8Runner::XEShV8Runner()
-    : shutdown_event_(false, false) {
+    : shutdown_event_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                      base::WaitableEvent::InitialState::NOT_SIGNALED) {
 }
 
 XEShV8Runner::~XEShV8Runner() {
@@ -36,29 +42,40 @@ XEShV8Runner::~XEShV8Runner() {
 
 void XEShV8Runner::Shutdown() {
   v8::Isolate* isolate = v8::Isolate::GetCurrent();
-  v8::HandleScope handle_scope(isolate);
-  v8::Local<v8::Context> context = GetV8Context();
-
-  context->Exit();
+  {
+    v8::HandleScope handle_scope(isolate);
+    GetV8Context()->Exit();
+  }
   v8_context_.Reset();
-  v8::V8::Dispose();
+  isolate->Exit();
+  isolate_holder_.reset();
 }
 
-void XEShV8Runner::Initialize(int argc,
-                              char** argv,
-                              base::SingleThreadTaskRunner* io_task_runner,
-                              const IPC::ChannelHandle& handle) {
+void XEShV8Runner::Initialize(
+    int argc,
+    char** argv,
+    scoped_refptr<base::SingleThreadTaskRunner> io_task_runner,
+    const IPC::ChannelHandle& handle) {
   client_channel_ =
       IPC::SyncChannel::Create(handle, IPC::Channel::MODE_CLIENT, &client_,
                                io_task_runner, true, &shutdown_event_);
 
   client_.Initialize(client_channel_.get());
 
-  v8::V8::Initialize();
-  v8::V8::InitializeICU();
+#if defined(V8_USE_EXTERNAL_STARTUP_DATA)
+  gin::V8Initializer::LoadV8Snapshot();
+  gin::V8Initializer::LoadV8Natives();
+#endif
+  base::i18n::InitializeICU();
   v8::V8::SetFlagsFromCommandLine(&argc, argv, true);
-
-  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  gin::IsolateHolder::Initialize(gin::IsolateHolder::kNonStrictMode,
+                                 gin::IsolateHolder::kNoV8Extras,
+                                 gin::ArrayBufferAllocator::SharedInstance());
+  isolate_holder_.reset(
+      new gin::IsolateHolder(base::ThreadTaskRunnerHandle::Get()));
+
+  v8::Isolate* isolate = isolate_holder_->isolate();
+  isolate->Enter();
   v8::HandleScope handle_scope(isolate);
 
   v8_context_.Reset(isolate, v8::Context::New(isolate));
@@ -78,7 +95,7 @@ std::string XEShV8Runner::ExecuteString(std::string statement) {
   v8::Isolate* isolate = v8::Isolate::GetCurrent();
   v8::HandleScope handle_scope(isolate);
 
-  v8::TryCatch try_catch;
+  v8::TryCatch try_catch(isolate);
   v8::Handle<v8::Script> script = v8::Script::Compile(
       v8::String::NewFromUtf8(isolate, statement.c_str()),
       v8::String::NewFromUtf8(isolate, "(xesh)"));
@@ -213,7 +230,8 @@ void XEShV8Runner::CreateExtensionModules(XWalkModuleSystem* module_system) {
   XWalkExtensionClient::ExtensionAPIMap::const_iterator it =
       extensions.begin();
   for (; it != extensions.end(); ++it) {
-    XWalkExtensionClient::ExtensionCodePoints* codepoint = it->second;
+    const XWalkExtensionClient::ExtensionCodePoints* codepoint =
+        it->second.get();
     if (codepoint->api.empty())
       continue;
     std::unique_ptr<XWalkExtensionModule> module(
@@ -7,8 +7,10 @@
 #ifndef XWALK_EXTENSIONS_XESH_XESH_V8_RUNNER_H_
 #define XWALK_EXTENSIONS_XESH_XESH_V8_RUNNER_H_
 
+#include <memory>
 #include <string>
 #include "v8/include/v8.h"
+#include "base/memory/ref_counted.h"
 #include "base/message_loop/message_loop.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/task_runner_util.h"
@@ -16,6 +18,10 @@
 #include "ipc/ipc_sync_channel.h"
 #include "xwalk/extensions/renderer/xwalk_extension_client.h"
 
+namespace gin {
+class IsolateHolder;
+}
+
 namespace xwalk {
 namespace extensions {
 class XWalkExtensionClient;
@@ -36,9 +42,10 @@ class XEShV8Runner {
 
   ~XEShV8Runner();
 
+  // |handle| is the client end of the channel to the extension server.
   void Initialize(int argc,
                   char** argv,
-                  base::SingleThreadTaskRunner* io_task_runner,
+                  scoped_refptr<base::SingleThreadTaskRunner> io_task_runner,
                   const IPC::ChannelHandle& handle);
   void Shutdown();
 
@@ -50,7 +57,7 @@ class XEShV8Runner {
   }
 
  private:
-  v8::Handle<v8::Context> GetV8Context() {
+  v8::Local<v8::Context> GetV8Context() {
     return v8::Local<v8::Context>::New(v8::Isolate::GetCurrent(), v8_context_);
   }
 
@@ -67,6 +74,7 @@ class XEShV8Runner {
   std::unique_ptr<IPC::SyncChannel> client_channel_;
   base::WaitableEvent shutdown_event_;
 
+  std::unique_ptr<gin::IsolateHolder> isolate_holder_;
   v8::Persistent<v8::Context> v8_context_;
 };
 
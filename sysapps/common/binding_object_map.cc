@@ -0,0 +1,108 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/common/binding_object_map.h"
+
+#include <stdint.h>
+
+#include "base/logging.h"
+
+namespace xwalk {
+namespace sysapps {
+
+namespace {
+
+// Must be a power of two.
+const size_t kInitialCapacity = 16;
+
+}  // namespace
+
+BindingObjectMap::BindingObjectMap() : size_(0) {}
+
+BindingObjectMap::~BindingObjectMap() {}
+
+bool BindingObjectMap::Insert(int id, std::unique_ptr<BindingObject> obj) {
+  DCHECK(obj);
+
+  // Keep the load factor under 3/4.
+  if ((size_ + 1) * 4 > entries_.size() * 3)
+    Grow();
+
+  Entry& entry = entries_[FindSlot(id)];
+  if (entry.object)
+    return false;
+
+  entry.id = id;
+  entry.object = std::move(obj);
+  ++size_;
+  return true;
+}
+
+BindingObject* BindingObjectMap::Find(int id) const {
+  if (!size_)
+    return NULL;
+
+  return entries_[FindSlot(id)].object.get();
+}
+
+std::unique_ptr<BindingObject> BindingObjectMap::Remove(int id) {
+  if (!size_)
+    return std::unique_ptr<BindingObject>();
+
+  size_t hole = FindSlot(id);
+  std::unique_ptr<BindingObject> obj = std::move(entries_[hole].object);
+  if (!obj)
+    return obj;
+
+  --size_;
+
+  // Moves back the entries of the cluster that would not be reachable
+  // anymore from their home slot through the hole.
+  size_t mask = entries_.size() - 1;
+  for (size_t slot = (hole + 1) & mask; entries_[slot].object;
+       slot = (slot + 1) & mask) {
+    size_t home = HomeSlot(entries_[slot].id);
+    if (((slot - home) & mask) < ((slot - hole) & mask))
+      continue;
+
+    entries_[hole].id = entries_[slot].id;
+    entries_[hole].object = std::move(entries_[slot].object);
+    hole = slot;
+  }
+
+  return obj;
+}
+
+size_t BindingObjectMap::HomeSlot(int id) const {
+  // Fibonacci hashing, handles are mostly sequential.
+  uint32_t hash = static_cast<uint32_t>(id) * 2654435761u;
+  return (hash ^ (hash >> 16)) & (entries_.size() - 1);
+}
+
+size_t BindingObjectMap::FindSlot(int id) const {
+  size_t mask = entries_.size() - 1;
+  size_t slot = HomeSlot(id);
+  while (entries_[slot].object && entries_[slot].id != id)
+    slot = (slot + 1) & mask;
+  return slot;
+}
+
+void BindingObjectMap::Grow() {
+  std::vector<Entry> old_entries;
+  old_entries.swap(entries_);
+  entries_.resize(old_entries.empty() ? kInitialCapacity
+                                      : old_entries.size() * 2);
+
+  for (Entry& old_entry : old_entries) {
+    if (!old_entry.object)
+      continue;
+
+    Entry& entry = entries_[FindSlot(old_entry.id)];
+    entry.id = old_entry.id;
+    entry.object = std::move(old_entry.object);
+  }
+}
+
+}  // namespace sysapps
+}  // namespace xwalk
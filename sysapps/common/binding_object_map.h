@@ -0,0 +1,64 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_SYSAPPS_COMMON_BINDING_OBJECT_MAP_H_
+#define XWALK_SYSAPPS_COMMON_BINDING_OBJECT_MAP_H_
+
+#include <stddef.h>
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "xwalk/sysapps/common/binding_object.h"
+
+namespace xwalk {
+namespace sysapps {
+
+// Owns the BindingObjects of a BindingObjectStore, indexed by their integer
+// handle. This is an open addressing hash table with linear probing, so the
+// lookup done for every message routed to an object touches one contiguous
+// array. Removals shift the following entries back instead of leaving
+// tombstones, keeping the probe sequences short however many objects come
+// and go.
+class BindingObjectMap {
+ public:
+  BindingObjectMap();
+  ~BindingObjectMap();
+
+  // Returns false, destroying |obj|, if there's already an object with |id|.
+  bool Insert(int id, std::unique_ptr<BindingObject> obj);
+
+  // Returns NULL if there's no object with |id|.
+  BindingObject* Find(int id) const;
+
+  // Returns the object with |id|, which is no longer in the map, or NULL if
+  // there was none.
+  std::unique_ptr<BindingObject> Remove(int id);
+
+  size_t size() const { return size_; }
+
+ private:
+  // An entry is in use when |object| is set.
+  struct Entry {
+    int id;
+    std::unique_ptr<BindingObject> object;
+  };
+
+  size_t HomeSlot(int id) const;
+
+  // Returns the slot of |id|, or the empty slot where it would be inserted.
+  size_t FindSlot(int id) const;
+
+  void Grow();
+
+  std::vector<Entry> entries_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(BindingObjectMap);
+};
+
+}  // namespace sysapps
+}  // namespace xwalk
+
+#endif  // XWALK_SYSAPPS_COMMON_BINDING_OBJECT_MAP_H_
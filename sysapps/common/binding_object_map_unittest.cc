@@ -0,0 +1,95 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/common/binding_object_map.h"
+
+#include <map>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::sysapps::BindingObject;
+using xwalk::sysapps::BindingObjectMap;
+
+namespace {
+
+class BindingObjectTest : public BindingObject {
+ public:
+  explicit BindingObjectTest(int* instance_count)
+      : instance_count_(instance_count) {
+    (*instance_count_)++;
+  }
+
+  ~BindingObjectTest() override {
+    (*instance_count_)--;
+  }
+
+ private:
+  int* instance_count_;
+};
+
+}  // namespace
+
+TEST(XWalkSysAppsBindingObjectMapTest, InsertFindAndRemove) {
+  int instance_count = 0;
+  std::unique_ptr<BindingObjectMap> map(new BindingObjectMap);
+
+  EXPECT_EQ(map->Find(1), nullptr);
+  EXPECT_FALSE(map->Remove(1));
+
+  BindingObject* obj1 = new BindingObjectTest(&instance_count);
+  BindingObject* obj2 = new BindingObjectTest(&instance_count);
+  EXPECT_TRUE(map->Insert(1, std::unique_ptr<BindingObject>(obj1)));
+  EXPECT_TRUE(map->Insert(-1, std::unique_ptr<BindingObject>(obj2)));
+  EXPECT_EQ(map->size(), 2u);
+  EXPECT_EQ(map->Find(1), obj1);
+  EXPECT_EQ(map->Find(-1), obj2);
+  EXPECT_EQ(map->Find(2), nullptr);
+
+  // The handle is already in use, the new object is discarded.
+  EXPECT_FALSE(map->Insert(1, std::unique_ptr<BindingObject>(
+      new BindingObjectTest(&instance_count))));
+  EXPECT_EQ(instance_count, 2);
+  EXPECT_EQ(map->Find(1), obj1);
+
+  std::unique_ptr<BindingObject> removed = map->Remove(1);
+  EXPECT_EQ(removed.get(), obj1);
+  EXPECT_EQ(map->Find(1), nullptr);
+  EXPECT_EQ(map->size(), 1u);
+  removed.reset();
+  EXPECT_EQ(instance_count, 1);
+
+  map.reset();
+  EXPECT_EQ(instance_count, 0);
+}
+
+TEST(XWalkSysAppsBindingObjectMapTest, ManyObjects) {
+  int instance_count = 0;
+  BindingObjectMap map;
+  std::map<int, BindingObject*> expected;
+
+  // Interleave handles from both sides and remove some of them, so the
+  // table grows and entries get shifted back by removals.
+  for (int i = 1; i <= 5000; ++i) {
+    for (int id : {i, -i}) {
+      BindingObject* obj = new BindingObjectTest(&instance_count);
+      EXPECT_TRUE(map.Insert(id, std::unique_ptr<BindingObject>(obj)));
+      expected[id] = obj;
+    }
+
+    if (i % 3 == 0) {
+      EXPECT_TRUE(map.Remove(i / 3));
+      expected.erase(i / 3);
+    }
+  }
+
+  EXPECT_EQ(map.size(), expected.size());
+  EXPECT_EQ(static_cast<size_t>(instance_count), expected.size());
+
+  for (int i = 1; i <= 5000; ++i) {
+    for (int id : {i, -i}) {
+      std::map<int, BindingObject*>::const_iterator it = expected.find(id);
+      EXPECT_EQ(map.Find(id), it == expected.end() ? nullptr : it->second);
+    }
+  }
+}
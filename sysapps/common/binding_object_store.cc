@@ -4,7 +4,8 @@
 
 #include "xwalk/sysapps/common/binding_object_store.h"
 
-#include "base/stl_util.h"
+#include <string>
+
 #include "xwalk/sysapps/common/common.h"
 
 using namespace xwalk::jsapi::common; // NOLINT
@@ -12,9 +13,10 @@ using namespace xwalk::jsapi::common; // NOLINT
 namespace xwalk {
 namespace sysapps {
 
-BindingObjectStore::BindingObjectStore(XWalkExtensionFunctionHandler* handler) {
-  handler->Register("JSObjectCollected",
-      base::Bind(&BindingObjectStore::OnJSObjectCollected,
+BindingObjectStore::BindingObjectStore(XWalkExtensionFunctionHandler* handler)
+    : last_native_id_(0) {
+  handler->Register("JSObjectsCollected",
+      base::Bind(&BindingObjectStore::OnJSObjectsCollected,
                  base::Unretained(this)));
   handler->Register("postMessageToObject",
       base::Bind(&BindingObjectStore::OnPostMessageToObject,
@@ -23,73 +25,64 @@ BindingObjectStore::BindingObjectStore(XWalkExtensionFunctionHandler* handler) {
 
 BindingObjectStore::~BindingObjectStore() {}
 
-void BindingObjectStore::AddBindingObject(const std::string& id,
+void BindingObjectStore::AddBindingObject(int id,
                                           std::unique_ptr<BindingObject> obj) {
-  if (base::ContainsKey(objects_, id)) {
+  if (!objects_.Insert(id, std::move(obj)))
     LOG(WARNING) << "The object with the ID " << id << " already exists.";
-    return;
-  }
+}
 
-  objects_[id] = obj.release();
+int BindingObjectStore::AddBindingObject(std::unique_ptr<BindingObject> obj) {
+  int id = --last_native_id_;
+  AddBindingObject(id, std::move(obj));
+  return id;
 }
 
-bool BindingObjectStore::HasObjectForTesting(const std::string& id) const {
-  return base::ContainsKey(objects_, id);
+bool BindingObjectStore::HasObjectForTesting(int id) const {
+  return objects_.Find(id) != NULL;
 }
 
-void BindingObjectStore::OnJSObjectCollected(
+void BindingObjectStore::OnJSObjectsCollected(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
-  std::unique_ptr<DestroyObject::Params>
-      params(DestroyObject::Params::Create(*info->arguments()));
+  std::unique_ptr<DestroyObjects::Params>
+      params(DestroyObjects::Params::Create(*info->arguments()));
 
   if (!params) {
     LOG(WARNING) << "Malformed parameters passed to " << info->name();
     return;
   }
 
-  BindingObjectMap::iterator it = objects_.find(params->object_id);
-  if (it == objects_.end()) {
-    LOG(WARNING) << "Attempt to destroy inexistent object with the ID "
-        << params->object_id;
-    return;
+  for (int object_id : params->object_ids) {
+    if (!objects_.Remove(object_id)) {
+      LOG(WARNING) << "Attempt to destroy inexistent object with the ID "
+          << object_id;
+    }
   }
-
-  delete it->second;
-  objects_.erase(it);
 }
 
 void BindingObjectStore::OnPostMessageToObject(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
-  std::unique_ptr<PostMessageToObject::Params>
-      params(PostMessageToObject::Params::Create(*info->arguments()));
+  base::ListValue* args = info->arguments();
 
-  if (!params) {
+  int object_id;
+  std::string name;
+  if (args->GetSize() < 2 ||
+      !args->GetInteger(args->GetSize() - 1, &object_id) ||
+      !args->GetString(args->GetSize() - 2, &name)) {
     LOG(WARNING) << "Malformed parameters passed to " << info->name();
     return;
   }
 
-  BindingObjectMap::iterator it = objects_.find(params->object_id);
-  if (it == objects_.end())
-    return;
-
-  if (!params->arguments->IsType(base::Value::Type::LIST)) {
-    LOG(WARNING) << "Malformed message sent to the object with the ID "
-        << params->object_id << ".";
+  BindingObject* obj = objects_.Find(object_id);
+  if (!obj)
     return;
-  }
-
-  std::unique_ptr<base::ListValue> new_args(
-      static_cast<base::ListValue*>(params->arguments.release()));
 
-  std::unique_ptr<XWalkExtensionFunctionInfo> new_info(
-      new XWalkExtensionFunctionInfo(
-          params->name,
-          std::move(new_args),
-          info->post_result_cb()));
+  args->Remove(args->GetSize() - 1, NULL);
+  args->Remove(args->GetSize() - 1, NULL);
+  info->set_name(name);
 
-  if (!it->second->HandleFunction(std::move(new_info))) {
-    LOG(WARNING) << "The object with the ID " << params->object_id << " has no "
-        "handler for the function " << params->name << ".";
+  if (!obj->HandleFunction(std::move(info))) {
+    LOG(WARNING) << "The object with the ID " << object_id << " has no "
+        "handler for the function " << name << ".";
     return;
   }
 }
@@ -5,14 +5,12 @@
 #ifndef XWALK_SYSAPPS_COMMON_BINDING_OBJECT_STORE_H_
 #define XWALK_SYSAPPS_COMMON_BINDING_OBJECT_STORE_H_
 
-#include <map>
 #include <memory>
-#include <string>
 
-#include "base/stl_util.h"
 #include "xwalk/extensions/browser/xwalk_extension_function_handler.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/sysapps/common/binding_object.h"
+#include "xwalk/sysapps/common/binding_object_map.h"
 
 namespace xwalk {
 namespace sysapps {
@@ -23,24 +21,39 @@ using extensions::XWalkExtensionFunctionInfo;
 
 // This class acts likes a container of objects that have a counterpart in
 // the JavaScript context. It handles the dispatching of messages to the
-// destination object based on a unique identifier associated to every
+// destination object based on a unique integer handle associated to every
 // BindingObject. This class owns the BindingObjects it is managing.
+//
+// The JavaScript side numbers the objects it creates from 1, the objects
+// created by the native side get negative handles so they never clash.
 class BindingObjectStore {
  public:
   explicit BindingObjectStore(XWalkExtensionFunctionHandler* handler);
   virtual ~BindingObjectStore();
 
-  void AddBindingObject(const std::string& id, std::unique_ptr<BindingObject> obj);
-  bool HasObjectForTesting(const std::string& id) const;
+  // Adds an object created on request of the JavaScript side, which picked
+  // its |id|.
+  void AddBindingObject(int id, std::unique_ptr<BindingObject> obj);
+
+  // Adds an object created by the native side, like the sockets accepted by
+  // a server, and returns the handle assigned to it.
+  int AddBindingObject(std::unique_ptr<BindingObject> obj);
+
+  bool HasObjectForTesting(int id) const;
 
  private:
-  // This method is invoked every time a JavaScript Binding object is collected
-  // by the garbage collector, so we can also destroy the native counterpart.
-  void OnJSObjectCollected(std::unique_ptr<XWalkExtensionFunctionInfo> info);
+  // This method is invoked with the IDs of the JavaScript Binding objects
+  // collected by a garbage collection, so we can also destroy the native
+  // counterparts.
+  void OnJSObjectsCollected(std::unique_ptr<XWalkExtensionFunctionInfo> info);
+
+  // The arguments are the ones of the target function followed by its name
+  // and the handle of the object. They are popped and the same |info| is
+  // passed along to the object.
   void OnPostMessageToObject(std::unique_ptr<XWalkExtensionFunctionInfo> info);
 
-  typedef std::map<std::string, BindingObject*> BindingObjectMap;
   BindingObjectMap objects_;
+  int last_native_id_;
 };
 
 }  // namespace sysapps
@@ -4,6 +4,8 @@
 
 #include "xwalk/sysapps/common/binding_object_store.h"
 
+#include <vector>
+
 #include "base/memory/ptr_util.h"
 #include "xwalk/extensions/browser/xwalk_extension_function_handler.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -20,9 +22,13 @@ const char kTestString[] = "crosswalk1234567890";
 void DummyCallback(std::unique_ptr<base::ListValue> result) {}
 
 std::unique_ptr<XWalkExtensionFunctionInfo> CreateFunctionInfo(
-    const std::string& name, const std::string& str_argument) {
+    const std::string& name, const std::vector<int>& int_list_argument) {
+  std::unique_ptr<base::ListValue> list(new base::ListValue);
+  for (int value : int_list_argument)
+    list->AppendInteger(value);
+
   std::unique_ptr<base::ListValue> arguments(new base::ListValue);
-  arguments->AppendString(str_argument);
+  arguments->Append(std::move(list));
 
   return base::WrapUnique(new XWalkExtensionFunctionInfo(
       name,
@@ -79,20 +85,20 @@ TEST(XWalkSysAppsBindingObjectStoreTest, AddBindingObject) {
       new XWalkExtensionFunctionHandler(NULL));
   std::unique_ptr<BindingObjectStore> store(new BindingObjectStore(handler.get()));
 
-  EXPECT_FALSE(store->HasObjectForTesting("foobar1"));
-  EXPECT_FALSE(store->HasObjectForTesting("foobar2"));
-  EXPECT_FALSE(store->HasObjectForTesting("foobar3"));
-  EXPECT_FALSE(store->HasObjectForTesting("foobar4"));
+  EXPECT_FALSE(store->HasObjectForTesting(1));
+  EXPECT_FALSE(store->HasObjectForTesting(2));
+  EXPECT_FALSE(store->HasObjectForTesting(3));
+  EXPECT_FALSE(store->HasObjectForTesting(4));
 
-  store->AddBindingObject("foobar1", BindingObjectTest::Create());
-  store->AddBindingObject("foobar2", BindingObjectTest::Create());
-  store->AddBindingObject("foobar3", BindingObjectTest::Create());
-  store->AddBindingObject("foobar4", BindingObjectTest::Create());
+  store->AddBindingObject(1, BindingObjectTest::Create());
+  store->AddBindingObject(2, BindingObjectTest::Create());
+  store->AddBindingObject(3, BindingObjectTest::Create());
+  store->AddBindingObject(4, BindingObjectTest::Create());
 
-  EXPECT_TRUE(store->HasObjectForTesting("foobar1"));
-  EXPECT_TRUE(store->HasObjectForTesting("foobar2"));
-  EXPECT_TRUE(store->HasObjectForTesting("foobar3"));
-  EXPECT_TRUE(store->HasObjectForTesting("foobar4"));
+  EXPECT_TRUE(store->HasObjectForTesting(1));
+  EXPECT_TRUE(store->HasObjectForTesting(2));
+  EXPECT_TRUE(store->HasObjectForTesting(3));
+  EXPECT_TRUE(store->HasObjectForTesting(4));
 
   EXPECT_EQ(BindingObjectTest::instance_count(), 4);
 
@@ -103,40 +109,46 @@ TEST(XWalkSysAppsBindingObjectStoreTest, AddBindingObject) {
   // Same ID, should discard the object. If this is happening in
   // real life, there is something wrong with the code (and that is
   // why we print a warning).
-  store->AddBindingObject("foobar1", BindingObjectTest::Create());
-  store->AddBindingObject("foobar1", BindingObjectTest::Create());
-  store->AddBindingObject("foobar1", BindingObjectTest::Create());
-  store->AddBindingObject("foobar1", BindingObjectTest::Create());
+  store->AddBindingObject(1, BindingObjectTest::Create());
+  store->AddBindingObject(1, BindingObjectTest::Create());
+  store->AddBindingObject(1, BindingObjectTest::Create());
+  store->AddBindingObject(1, BindingObjectTest::Create());
   EXPECT_EQ(BindingObjectTest::instance_count(), 1);
 
   store.reset();
   EXPECT_EQ(BindingObjectTest::instance_count(), 0);
 }
 
-TEST(XWalkSysAppsBindingObjectStoreTest, OnJSObjectCollected) {
+TEST(XWalkSysAppsBindingObjectStoreTest, OnJSObjectsCollected) {
   XWalkExtensionFunctionHandler handler(NULL);
   std::unique_ptr<BindingObjectStore> store(new BindingObjectStore(&handler));
 
-  store->AddBindingObject("foobar1", BindingObjectTest::Create());
-  store->AddBindingObject("foobar2", BindingObjectTest::Create());
-  store->AddBindingObject("foobar3", BindingObjectTest::Create());
-  store->AddBindingObject("foobar4", BindingObjectTest::Create());
+  store->AddBindingObject(1, BindingObjectTest::Create());
+  store->AddBindingObject(2, BindingObjectTest::Create());
+  store->AddBindingObject(3, BindingObjectTest::Create());
+  store->AddBindingObject(4, BindingObjectTest::Create());
   EXPECT_EQ(BindingObjectTest::instance_count(), 4);
 
   EXPECT_TRUE(handler.HandleFunction(
-          CreateFunctionInfo("JSObjectCollected", "foobar1")));
+          CreateFunctionInfo("JSObjectsCollected", {1})));
   EXPECT_EQ(BindingObjectTest::instance_count(), 3);
 
   EXPECT_TRUE(handler.HandleFunction(
-          CreateFunctionInfo("JSObjectCollected", "foobar2")));
+          CreateFunctionInfo("JSObjectsCollected", {2})));
   EXPECT_EQ(BindingObjectTest::instance_count(), 2);
 
   // Attempt to destroy an object that doesn't exist
   // on the store.
   EXPECT_TRUE(handler.HandleFunction(
-          CreateFunctionInfo("JSObjectCollected", "foobar2")));
+          CreateFunctionInfo("JSObjectsCollected", {2})));
   EXPECT_EQ(BindingObjectTest::instance_count(), 2);
 
+  // Objects collected together are destroyed together, the missing ones
+  // are skipped.
+  EXPECT_TRUE(handler.HandleFunction(
+          CreateFunctionInfo("JSObjectsCollected", {3, 5, 4})));
+  EXPECT_EQ(BindingObjectTest::instance_count(), 0);
+
   store.reset();
   EXPECT_EQ(BindingObjectTest::instance_count(), 0);
 }
@@ -150,23 +162,21 @@ TEST(XWalkSysAppsBindingObjectStoreTest, OnPostMessageToObject) {
   std::unique_ptr<BindingObject> binding_object_ptr1(binding_object1);
   std::unique_ptr<BindingObject> binding_object_ptr2(binding_object2);
 
-  store->AddBindingObject("foobar1", std::move(binding_object_ptr1));
-  store->AddBindingObject("foobar2", std::move(binding_object_ptr2));
+  store->AddBindingObject(1, std::move(binding_object_ptr1));
+  store->AddBindingObject(2, std::move(binding_object_ptr2));
   EXPECT_EQ(BindingObjectTest::instance_count(), 2);
 
   for (int i = 0; i < 1000; ++i) {
     std::unique_ptr<base::ListValue> arguments(new base::ListValue);
 
-    // Object ID.
-    arguments->AppendString("foobar1");
+    // Arguments passed to the target object.
+    arguments->AppendString(kTestString);
 
     // Function name on the target object.
     arguments->AppendString("test");
 
-    // Arguments list passed to the target object.
-    base::ListValue* targetArguments(new base::ListValue());
-    targetArguments->AppendString(kTestString);
-    arguments->Append(targetArguments);
+    // Object ID.
+    arguments->AppendInteger(1);
 
     std::unique_ptr<XWalkExtensionFunctionInfo> postMessageToObjectInfo(
         new XWalkExtensionFunctionInfo(
@@ -183,3 +193,30 @@ TEST(XWalkSysAppsBindingObjectStoreTest, OnPostMessageToObject) {
   store.reset();
   EXPECT_EQ(BindingObjectTest::instance_count(), 0);
 }
+
+TEST(XWalkSysAppsBindingObjectStoreTest, NativeObjectHandles) {
+  XWalkExtensionFunctionHandler handler(NULL);
+  std::unique_ptr<BindingObjectStore> store(new BindingObjectStore(&handler));
+
+  store->AddBindingObject(1, BindingObjectTest::Create());
+  int id1 = store->AddBindingObject(BindingObjectTest::Create());
+  int id2 = store->AddBindingObject(BindingObjectTest::Create());
+
+  // Handles assigned by the native side never clash with the ones of the
+  // JavaScript side.
+  EXPECT_LT(id1, 0);
+  EXPECT_LT(id2, 0);
+  EXPECT_NE(id1, id2);
+  EXPECT_TRUE(store->HasObjectForTesting(1));
+  EXPECT_TRUE(store->HasObjectForTesting(id1));
+  EXPECT_TRUE(store->HasObjectForTesting(id2));
+  EXPECT_EQ(BindingObjectTest::instance_count(), 3);
+
+  EXPECT_TRUE(handler.HandleFunction(
+          CreateFunctionInfo("JSObjectsCollected", {id1})));
+  EXPECT_FALSE(store->HasObjectForTesting(id1));
+  EXPECT_EQ(BindingObjectTest::instance_count(), 2);
+
+  store.reset();
+  EXPECT_EQ(BindingObjectTest::instance_count(), 0);
+}
@@ -7,10 +7,16 @@
 var internal;
 var v8tools;
 
-var unique_id = 0;
+// Tracks every BindingObject registered with _registerLifecycleTracker(), see
+// setupSysAppsCommon().
+var collection_notifier;
+
+// Object IDs are positive, the native side uses negative ones for the objects
+// it creates.
+var unique_id = 1;
 
 function getUniqueId() {
-  return (unique_id++).toString();
+  return unique_id++;
 }
 
 // The BindingObject is responsible for bridging between the JavaScript
@@ -30,8 +36,8 @@ function getUniqueId() {
 // _postMessage(function_name, arguments, callback):
 //     This method sends a message to the native counterpart of this
 //     object. It has the same signature of the Internal Extensions
-//     |postMessage| but wraps the unique identifier as the first argument
-//     automatically.
+//     |postMessage| but appends the function name and the unique identifier
+//     to |arguments| automatically.
 //
 // _addMethod(name, has_callback):
 //     Convenience function for adding methods to an object that have a
@@ -48,8 +54,9 @@ function getUniqueId() {
 //
 var BindingObjectPrototype = function() {
   function postMessage(name, args, callback) {
-    return internal.postMessage("postMessageToObject",
-        [this._id, name, args], callback);
+    // The BindingObjectStore pops them and hands the arguments over as is.
+    args.push(name, this._id);
+    return internal.postMessage("postMessageToObject", args, callback);
   };
 
   function isEnumerable(method_name) {
@@ -89,14 +96,7 @@ var BindingObjectPrototype = function() {
   };
 
   function registerLifecycleTracker() {
-    Object.defineProperty(this, "_tracker", {
-      value: v8tools.lifecycleTracker(),
-    });
-
-    var object_id = this._id;
-    this._tracker.destructor = function() {
-      internal.postMessage("JSObjectCollected", [object_id]);
-    };
+    collection_notifier.track(this, this._id);
   }
 
   Object.defineProperties(this, {
@@ -309,6 +309,11 @@ exports.setupSysAppsCommon = function(internalObj, v8toolsObj) {
   internal = internalObj;
   v8tools = v8toolsObj;
 
+  // The objects collected by a garbage collection are reported at once.
+  collection_notifier = v8tools.collectionNotifier(function(object_ids) {
+    internal.postMessage("JSObjectsCollected", [object_ids]);
+  });
+
   EventTargetPrototype.prototype = new BindingObjectPrototype();
 
   exports.getUniqueId = getUniqueId;
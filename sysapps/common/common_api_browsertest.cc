@@ -73,8 +73,8 @@ void SysAppsTestExtensionInstance::HandleMessage(std::unique_ptr<base::Value> ms
 
 void SysAppsTestExtensionInstance::OnSysAppsTestObjectContructor(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
-  std::string object_id;
-  ASSERT_TRUE(info->arguments()->GetString(0, &object_id));
+  int object_id;
+  ASSERT_TRUE(info->arguments()->GetInteger(0, &object_id));
 
   std::unique_ptr<BindingObject> obj(new SysAppsTestObject);
   store_.AddBindingObject(object_id, std::move(obj));
@@ -82,8 +82,8 @@ void SysAppsTestExtensionInstance::OnSysAppsTestObjectContructor(
 
 void SysAppsTestExtensionInstance::OnHasObject(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
-  std::string object_id;
-  ASSERT_TRUE(info->arguments()->GetString(0, &object_id));
+  int object_id;
+  ASSERT_TRUE(info->arguments()->GetInteger(0, &object_id));
 
   std::unique_ptr<base::ListValue> result(new base::ListValue());
   result->AppendBoolean(store_.HasObjectForTesting(object_id));
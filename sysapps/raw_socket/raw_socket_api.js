@@ -37,6 +37,156 @@ var ReadyStateObserver = function(object_id, initial_state) {
 
 ReadyStateObserver.prototype = new common.EventTargetPrototype();
 
+// The SendBufferObserver is a proxy object, just like the
+// ReadyStateObserver, subscribing to the parent's |written|
+// event. It keeps track of the bytes sent and written by
+// the native side, which gives the bufferedAmount.
+//
+// Blobs have to be read before they can be sent, so whatever
+// is sent after one waits in |pending| for it to keep the
+// data in order.
+//
+var SendBufferObserver = function(object_id, high_water_mark) {
+  common.BindingObject.call(this, object_id);
+  common.EventTarget.call(this);
+
+  this._addEvent("written");
+  this.highWaterMark = high_water_mark;
+  this.bytesSent = 0;
+  this.bytesWritten = 0;
+  this.pending = [];
+  this.reader = null;
+  this.reading = false;
+
+  var that = this;
+  this.onwritten = function(event) {
+    that.bytesWritten = event.data;
+  };
+
+  this.destructor = function() {
+    this.onwritten = null;
+  };
+};
+
+SendBufferObserver.prototype = new common.EventTargetPrototype();
+
+// Size of |string| once encoded as UTF-8. A lone surrogate is sent as
+// U+FFFD, which takes 3 bytes like any other BMP character above 0x7ff.
+//
+function utf8Length(string) {
+  var length = 0;
+
+  for (var i = 0; i < string.length; ++i) {
+    var c = string.charCodeAt(i);
+    if (c < 0x80) {
+      length += 1;
+    } else if (c < 0x800) {
+      length += 2;
+    } else if (c >= 0xd800 && c <= 0xdbff && i + 1 < string.length &&
+               string.charCodeAt(i + 1) >= 0xdc00 &&
+               string.charCodeAt(i + 1) <= 0xdfff) {
+      length += 4;
+      ++i;
+    } else {
+      length += 3;
+    }
+  }
+
+  return length;
+}
+
+function flushPendingData(socket) {
+  var observer = socket._sendBufferObserver;
+
+  while (!observer.reading && observer.pending.length) {
+    var entry = observer.pending[0];
+
+    if (entry.data instanceof Blob) {
+      var reader = new FileReader();
+      reader.onloadend = function() {
+        // Dropped by close() or halfclose() meanwhile.
+        if (observer.reader !== reader)
+          return;
+
+        entry.data = reader.result || new ArrayBuffer(0);
+        observer.reader = null;
+        observer.reading = false;
+        flushPendingData(socket);
+      };
+
+      observer.reader = reader;
+      observer.reading = true;
+      reader.readAsArrayBuffer(entry.data);
+      return;
+    }
+
+    observer.pending.shift();
+
+    var args = [entry.data].concat(entry.args, [entry.drain]);
+    if (typeof entry.data == "string")
+      socket._postMessage("_sendString", args);
+    else
+      socket._postMessage("_sendArrayBuffer", args);
+  }
+}
+
+// Drops what is still waiting for a Blob to be read when the socket
+// stops sending, the native side would only ignore it and fire "drain".
+//
+function dropPendingData(socket) {
+  var observer = socket._sendBufferObserver;
+
+  if (observer.reader)
+    observer.reader.abort();
+  observer.reader = null;
+  observer.reading = false;
+
+  while (observer.pending.length)
+    observer.bytesSent -= observer.pending.shift().size;
+}
+
+// Common implementation of TCPSocket.send() and UDPSocket.send(),
+// |args| are the arguments following the data. Nothing is dropped
+// while the socket is open: when the buffered amount reaches the
+// high-water mark, send() returns false and the native side is
+// asked to fire "drain" once the data is written.
+//
+function sendData(socket, data, args) {
+  var observer = socket._sendBufferObserver;
+
+  var readyState = socket._readyStateObserver.readyState;
+  if (readyState == "closing" || readyState == "closed" ||
+      readyState == "halfclosed") {
+    return false;
+  }
+
+  var size;
+  if (data instanceof Blob) {
+    size = data.size;
+  } else if (data instanceof ArrayBuffer || ArrayBuffer.isView(data)) {
+    size = data.byteLength;
+  } else {
+    data = String(data);
+    size = utf8Length(data);
+  }
+
+  observer.bytesSent += size;
+
+  var bufferFull =
+      observer.bytesSent - observer.bytesWritten >= observer.highWaterMark;
+
+  observer.pending.push(
+      { data: data, size: size, args: args, drain: bufferFull });
+  flushPendingData(socket);
+
+  return !bufferFull;
+}
+
+function bufferedAmount() {
+  var observer = this._sendBufferObserver;
+  return observer.bytesSent - observer.bytesWritten;
+}
+
 // TCPSocket interface.
 //
 // TODO(tmpsantos): We are currently not throwing any exceptions
@@ -63,12 +213,17 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
     options.noDelay = true;
   if (!options.useSecureTransport)
     options.useSecureTransport = false;
+  if (!options.highWaterMark)
+    options.highWaterMark = 65536;
+  if (!options.readHighWaterMark)
+    options.readHighWaterMark = 1048576;
 
   this._addMethod("_close");
   this._addMethod("_halfclose");
   this._addMethod("suspend");
   this._addMethod("resume");
-  this._addMethod("_sendString");
+  this._addMethod("_ackData");
+  this._addMethodWithPromise("getSecurityInfo");
 
   this._addEvent("drain");
   this._addEvent("open");
@@ -77,14 +232,19 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
   this._addEvent("data");
 
   function sendWrapper(data) {
-    this._sendString(data);
-
-    // FIXME(tmpsantos): The spec says that send() should always
-    // return if you can keep sending data. This can only be
-    // verified in the native implementation, which makes this
-    // call sync. We are returning always true here to keep the
-    // implementation async.
-    return true;
+    return sendData(this, data, []);
+  };
+
+  // The native side stops reading when too much data was delivered
+  // but not handled yet, so every "data" event is acknowledged once
+  // its listeners return, even if one of them throws.
+  function dispatchEventFromExtension(type, data) {
+    try {
+      TCPSocket.prototype._dispatchEventFromExtension.call(this, type, data);
+    } finally {
+      if (type == "data")
+        this._ackData(data.byteLength);
+    }
   };
 
   function closeWrapper(data) {
@@ -92,6 +252,7 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
       return;
 
     this._readyStateObserver.readyState = "closing";
+    dropPendingData(this);
     this._close();
   };
 
@@ -100,6 +261,7 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
       return;
 
     this._readyStateObserver.readyState = "halfclosed";
+    dropPendingData(this);
     this._halfclose();
   };
 
@@ -111,6 +273,9 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
     "_readyStateObserverDeleter": {
       value: v8tools.lifecycleTracker(),
     },
+    "_dispatchEventFromExtension": {
+      value: dispatchEventFromExtension,
+    },
     "send": {
       value: sendWrapper,
       enumerable: true,
@@ -143,12 +308,23 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
       value: options.noDelay,
       enumerable: true,
     },
+    "readHighWaterMark": {
+      value: options.readHighWaterMark,
+      enumerable: true,
+    },
     "addressReuse": {
       value: options.addressReuse,
       enumerable: true,
     },
+    "_sendBufferObserver": {
+      value: new SendBufferObserver(this._id, options.highWaterMark),
+    },
+    "highWaterMark": {
+      value: options.highWaterMark,
+      enumerable: true,
+    },
     "bufferedAmount": {
-      value: 0,
+      get: bufferedAmount,
       enumerable: true,
     },
     "readyState": {
@@ -158,8 +334,10 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
   });
 
   var watcher = this._readyStateObserver;
+  var send_buffer_watcher = this._sendBufferObserver;
   this._readyStateObserverDeleter.destructor = function() {
     watcher.destructor();
+    send_buffer_watcher.destructor();
   };
 
   // This is needed, otherwise events like "error" can get fired before
@@ -196,10 +374,13 @@ var TCPServerSocket = function(options) {
     options.addressReuse = true;
   if (!options.useSecureTransport)
     options.useSecureTransport = false;
+  if (!options.backlog)
+    options.backlog = 128;
 
   this._addMethod("_close");
   this._addMethod("suspend");
   this._addMethod("resume");
+  this._addMethodWithPromise("getStats");
 
   // FIXME(tmpsantos): Get the real remote IP and port
   // from the native backend.
@@ -248,6 +429,10 @@ var TCPServerSocket = function(options) {
       value: options.addressReuse,
       enumerable: true,
     },
+    "backlog": {
+      value: options.backlog,
+      enumerable: true,
+    },
     "readyState": {
       get: function() { return this._readyStateObserver.readyState; },
       enumerable: true,
@@ -295,13 +480,20 @@ var UDPSocket = function(options) {
     options.addressReuse = true;
   if (!options.loopback)
     options.loopback = false;
+  if (!options.receiveBufferSize)
+    options.receiveBufferSize = 0;
+  if (!options.sendBufferSize)
+    options.sendBufferSize = 0;
+  if (!options.multicastTimeToLive)
+    options.multicastTimeToLive = 0;
+  if (!options.highWaterMark)
+    options.highWaterMark = 65536;
 
   this._addMethod("_close");
   this._addMethod("suspend");
   this._addMethod("resume");
   this._addMethod("joinMulticast");
   this._addMethod("leaveMulticast");
-  this._addMethod("_sendString");
 
   function MessageEvent(type, data) {
     this.type = type;
@@ -310,20 +502,47 @@ var UDPSocket = function(options) {
     this.remoteAddress = data.remoteAddress;
   }
 
+  function MessageBatchEvent(type, data) {
+    this.type = type;
+    this.data = data.data;
+    this.offsets = new Uint32Array(data.offsets);
+    this.remotePorts = new Uint16Array(data.remotePorts);
+    this.remoteAddressIndices = new Uint16Array(data.remoteAddressIndices);
+    this.remoteAddresses = data.remoteAddresses;
+    this.length = this.remotePorts.length;
+  }
+
   this._addEvent("open");
   this._addEvent("drain");
   this._addEvent("error");
   this._addEvent("message", MessageEvent);
+  this._addEvent("messages", MessageBatchEvent);
 
   function sendWrapper(data, remoteAddress, remotePort) {
-    this._sendString(data, remoteAddress, remotePort);
-
-    // FIXME(tmpsantos): The spec says that send() should always
-    // return if you can keep sending data. This can only be
-    // verified in the native implementation, which makes this
-    // call sync. We are returning always true here to keep the
-    // implementation async.
-    return true;
+    return sendData(this, data, [remoteAddress, remotePort]);
+  };
+
+  // The native side always sends the datagrams in batches, either
+  // as a "messages" event or, when there are only "message"
+  // listeners, as a "message" event. They get one event per
+  // datagram out of it.
+  function dispatchEventFromExtension(type, data) {
+    if (type != "message")
+      UDPSocket.prototype._dispatchEventFromExtension.call(this, type, data);
+
+    if ((type != "message" && type != "messages") ||
+        !("message" in this._event_listeners)) {
+      return;
+    }
+
+    var batch = new MessageBatchEvent(type, data);
+    for (var i = 0; i < batch.length; ++i) {
+      this.dispatchEvent(new MessageEvent("message", {
+        data: batch.data.slice(batch.offsets[i], batch.offsets[i + 1]),
+        remotePort: batch.remotePorts[i],
+        remoteAddress: batch.remoteAddresses[batch.remoteAddressIndices[i]],
+      }));
+    }
   };
 
   function closeWrapper(data) {
@@ -331,6 +550,7 @@ var UDPSocket = function(options) {
       return;
 
     this._readyStateObserver.readyState = "closing";
+    dropPendingData(this);
     this._close();
   };
 
@@ -341,6 +561,9 @@ var UDPSocket = function(options) {
     "_readyStateObserverDeleter": {
       value: v8tools.lifecycleTracker(),
     },
+    "_dispatchEventFromExtension": {
+      value: dispatchEventFromExtension,
+    },
     "send": {
       value: sendWrapper,
       enumerable: true,
@@ -373,8 +596,27 @@ var UDPSocket = function(options) {
       value: options.loopback,
       enumerable: true,
     },
+    "receiveBufferSize": {
+      value: options.receiveBufferSize,
+      enumerable: true,
+    },
+    "sendBufferSize": {
+      value: options.sendBufferSize,
+      enumerable: true,
+    },
+    "multicastTimeToLive": {
+      value: options.multicastTimeToLive,
+      enumerable: true,
+    },
+    "_sendBufferObserver": {
+      value: new SendBufferObserver(this._id, options.highWaterMark),
+    },
+    "highWaterMark": {
+      value: options.highWaterMark,
+      enumerable: true,
+    },
     "bufferedAmount": {
-      value: 0,
+      get: bufferedAmount,
       enumerable: true,
     },
     "readyState": {
@@ -384,8 +626,10 @@ var UDPSocket = function(options) {
   });
 
   var watcher = this._readyStateObserver;
+  var send_buffer_watcher = this._sendBufferObserver;
   this._readyStateObserverDeleter.destructor = function() {
     watcher.destructor();
+    send_buffer_watcher.destructor();
   };
 
   // This is needed, otherwise events like "error" can get fired before
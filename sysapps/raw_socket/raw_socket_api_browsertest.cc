@@ -3,10 +3,12 @@
 // found in the LICENSE file.
 
 #include "base/path_service.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/utf_string_conversions.h"
 #include "content/public/test/browser_test_utils.h"
 #include "content/public/test/test_utils.h"
 #include "net/base/filename_util.h"
+#include "net/test/embedded_test_server/embedded_test_server.h"
 #include "xwalk/extensions/browser/xwalk_extension_service.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/runtime/browser/runtime.h"
@@ -58,6 +60,10 @@ IN_PROC_BROWSER_TEST_F(SysAppsRawSocketTest, SysAppsRawSocket) {
   const base::string16 passString = base::ASCIIToUTF16("Pass");
   const base::string16 failString = base::ASCIIToUTF16("Fail");
 
+  // Target of the TLS test, its port is passed in the URL fragment.
+  net::EmbeddedTestServer https_server(net::EmbeddedTestServer::TYPE_HTTPS);
+  ASSERT_TRUE(https_server.Start());
+
   Runtime* runtime = CreateRuntime();
   content::TitleWatcher title_watcher(runtime->web_contents(), passString);
   title_watcher.AlsoWaitForTitle(failString);
@@ -70,6 +76,11 @@ IN_PROC_BROWSER_TEST_F(SysAppsRawSocketTest, SysAppsRawSocket) {
       .Append(FILE_PATH_LITERAL("raw_socket"))
       .Append(FILE_PATH_LITERAL("raw_socket_api_browsertest.html"));
 
-  xwalk_test_utils::NavigateToURL(runtime, net::FilePathToFileURL(test_file));
+  std::string port = base::IntToString(https_server.port());
+  GURL::Replacements replacements;
+  replacements.SetRefStr(port);
+  xwalk_test_utils::NavigateToURL(
+      runtime,
+      net::FilePathToFileURL(test_file).ReplaceComponents(replacements));
   EXPECT_EQ(passString, title_watcher.WaitAndGetTitle());
 }
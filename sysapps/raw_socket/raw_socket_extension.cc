@@ -30,6 +30,8 @@ XWalkExtensionInstance* RawSocketExtension::CreateInstance() {
 
 RawSocketInstance::RawSocketInstance()
   : handler_(this),
+    resolver_(net::HostResolver::CreateDefaultResolver(NULL)),
+    tls_context_(new TLSClientContext),
     store_(&handler_) {
   handler_.Register("TCPServerSocketConstructor",
       base::Bind(&RawSocketInstance::OnTCPServerSocketConstructor,
@@ -40,15 +42,18 @@ RawSocketInstance::RawSocketInstance()
   handler_.Register("UDPSocketConstructor",
       base::Bind(&RawSocketInstance::OnUDPSocketConstructor,
                  base::Unretained(this)));
+
+  // Sockets can fire many small events in a row (one per datagram or read),
+  // deliver them to the renderer in batches.
+  EnableMessageBatching();
 }
 
 void RawSocketInstance::HandleMessage(std::unique_ptr<base::Value> msg) {
   handler_.HandleMessage(std::move(msg));
 }
 
-void RawSocketInstance::AddBindingObject(const std::string& object_id,
-                                         std::unique_ptr<BindingObject> obj) {
-  store_.AddBindingObject(object_id, std::move(obj));
+int RawSocketInstance::AddBindingObject(std::unique_ptr<BindingObject> obj) {
+  return store_.AddBindingObject(std::move(obj));
 }
 
 void RawSocketInstance::OnTCPServerSocketConstructor(
@@ -75,7 +80,8 @@ void RawSocketInstance::OnTCPSocketConstructor(
     return;
   }
 
-  std::unique_ptr<BindingObject> obj(new TCPSocketObject);
+  std::unique_ptr<BindingObject> obj(
+      new TCPSocketObject(resolver_.get(), tls_context_));
   store_.AddBindingObject(params->object_id, std::move(obj));
 }
 
@@ -89,7 +95,7 @@ void RawSocketInstance::OnUDPSocketConstructor(
     return;
   }
 
-  std::unique_ptr<BindingObject> obj(new UDPSocketObject);
+  std::unique_ptr<BindingObject> obj(new UDPSocketObject(resolver_.get()));
   store_.AddBindingObject(params->object_id, std::move(obj));
 }
 
@@ -5,9 +5,12 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_RAW_SOCKET_EXTENSION_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_RAW_SOCKET_EXTENSION_H_
 
+#include <memory>
 #include <string>
 #include "base/values.h"
+#include "net/dns/host_resolver.h"
 #include "xwalk/sysapps/common/binding_object_store.h"
+#include "xwalk/sysapps/raw_socket/tcp_socket_object.h"
 
 namespace xwalk {
 namespace sysapps {
@@ -33,8 +36,9 @@ class RawSocketInstance : public XWalkExtensionInstance {
   // XWalkExtensionInstance implementation.
   void HandleMessage(std::unique_ptr<base::Value> msg) override;
 
-  void AddBindingObject(const std::string& object_id,
-                        std::unique_ptr<BindingObject> obj);
+  // Adds an object created by the native side, like the sockets accepted by
+  // a server, and returns the ID assigned to it.
+  int AddBindingObject(std::unique_ptr<BindingObject> obj);
 
  private:
   void OnTCPServerSocketConstructor(
@@ -43,6 +47,14 @@ class RawSocketInstance : public XWalkExtensionInstance {
   void OnUDPSocketConstructor(std::unique_ptr<XWalkExtensionFunctionInfo> info);
 
   XWalkExtensionFunctionHandler handler_;
+
+  // Shared by the sockets of this instance, so they also share its host
+  // cache. Declared before |store_|, the sockets can't outlive it.
+  std::unique_ptr<net::HostResolver> resolver_;
+
+  // Shared by the TCPSockets of this instance.
+  scoped_refptr<TLSClientContext> tls_context_;
+
   BindingObjectStore store_;
 };
 
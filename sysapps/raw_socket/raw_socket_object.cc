@@ -6,12 +6,31 @@
 
 #include <memory>
 
+#include "base/logging.h"
 #include "base/values.h"
 
 namespace xwalk {
 namespace sysapps {
 
-RawSocketObject::RawSocketObject() {}
+VectorIOBuffer::VectorIOBuffer(std::vector<char>* data)
+    : net::IOBuffer(static_cast<char*>(NULL)) {
+  vector_.swap(*data);
+  data_ = vector_.empty() ? NULL : &vector_[0];
+}
+
+VectorIOBuffer::~VectorIOBuffer() {
+  // The base class would delete[] the vector storage otherwise.
+  data_ = NULL;
+}
+
+const size_t RawSocketObject::kDefaultHighWaterMark;
+
+RawSocketObject::RawSocketObject()
+    : high_water_mark_(kDefaultHighWaterMark),
+      buffered_amount_(0),
+      bytes_written_(0),
+      reported_bytes_written_(0),
+      drain_requested_(false) {}
 
 RawSocketObject::~RawSocketObject() {}
 
@@ -22,5 +41,55 @@ void RawSocketObject::setReadyState(ReadyState state) {
   DispatchEvent("readystate", std::move(eventData));
 }
 
+void RawSocketObject::DidQueueData(size_t size, bool drain_requested) {
+  buffered_amount_ += size;
+  drain_requested_ |= drain_requested;
+
+  // Nothing will be written, fire right away what would be fired then.
+  if (!buffered_amount_)
+    DidWriteData(0);
+}
+
+void RawSocketObject::DidWriteData(size_t size) {
+  DCHECK_LE(size, buffered_amount_);
+  buffered_amount_ -= size;
+  bytes_written_ += size;
+
+  // Reporting every write would double the number of messages, so JavaScript
+  // is only told often enough to keep its bufferedAmount within half of the
+  // high-water mark, and before "drain".
+  bool drained = !buffered_amount_ && drain_requested_;
+  if (drained ||
+      bytes_written_ - reported_bytes_written_ >= high_water_mark_ / 2) {
+    ReportBytesWritten();
+  }
+
+  if (drained) {
+    drain_requested_ = false;
+    DispatchEvent("drain");
+  }
+}
+
+void RawSocketObject::DidDropQueuedData() {
+  DidWriteData(buffered_amount_);
+  if (bytes_written_ != reported_bytes_written_)
+    ReportBytesWritten();
+}
+
+void RawSocketObject::DidDiscardData(size_t size) {
+  buffered_amount_ += size;
+  DidWriteData(size);
+  if (!buffered_amount_ && bytes_written_ != reported_bytes_written_)
+    ReportBytesWritten();
+}
+
+void RawSocketObject::ReportBytesWritten() {
+  reported_bytes_written_ = bytes_written_;
+
+  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->AppendDouble(static_cast<double>(bytes_written_));
+  DispatchEvent("written", std::move(eventData));
+}
+
 }  // namespace sysapps
 }  // namespace xwalk
@@ -5,6 +5,11 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_RAW_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_RAW_SOCKET_OBJECT_H_
 
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "net/base/io_buffer.h"
 #include "xwalk/sysapps/raw_socket/raw_socket.h"
 #include "xwalk/sysapps/common/event_target.h"
 
@@ -13,15 +18,66 @@ using xwalk::jsapi::raw_socket::ReadyState; // NOLINT
 namespace xwalk {
 namespace sysapps {
 
+// IOBuffer taking over the contents of a vector, so the ArrayBuffers sent
+// from JavaScript are queued for writing without copying them again.
+class VectorIOBuffer : public net::IOBuffer {
+ public:
+  explicit VectorIOBuffer(std::vector<char>* data);
+
+  int size() const { return static_cast<int>(vector_.size()); }
+
+ private:
+  ~VectorIOBuffer() override;
+
+  std::vector<char> vector_;
+};
+
 // Base class for the objects of the RawSocket API.
+//
+// It also keeps the send buffer accounting of the sockets. Sending never
+// drops data, it is queued until the socket can write it. The JavaScript side
+// counts the bytes it sends and learns how many were written through the
+// "written" event, which is how it computes bufferedAmount and decides when
+// send() returns false. When that happens, the send carries a drain request
+// and "drain" is fired once everything queued so far is written.
 class RawSocketObject : public EventTarget {
  public:
+  static const size_t kDefaultHighWaterMark = 64 * 1024;
+
   ~RawSocketObject() override;
 
  protected:
   RawSocketObject();
 
   void setReadyState(ReadyState state);
+
+  void set_high_water_mark(size_t high_water_mark) {
+    high_water_mark_ = high_water_mark;
+  }
+
+  // Called when |size| bytes are queued for writing.
+  void DidQueueData(size_t size, bool drain_requested);
+
+  // Called when |size| of the queued bytes were written.
+  void DidWriteData(size_t size);
+
+  // Called when the queued data is dropped because the socket got closed,
+  // it is accounted as written so bufferedAmount goes back to zero.
+  void DidDropQueuedData();
+
+  // Called when |size| bytes sent by JavaScript are not queued at all, like
+  // after halfclose(). They are accounted as written, but a drain request
+  // coming with them is ignored since nothing will be written.
+  void DidDiscardData(size_t size);
+
+ private:
+  void ReportBytesWritten();
+
+  size_t high_water_mark_;
+  size_t buffered_amount_;
+  uint64_t bytes_written_;
+  uint64_t reported_bytes_written_;
+  bool drain_requested_;
 };
 
 }  // namespace sysapps
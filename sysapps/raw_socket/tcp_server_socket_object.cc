@@ -5,8 +5,11 @@
 #include "xwalk/sysapps/raw_socket/tcp_server_socket_object.h"
 
 #include <string.h>
-#include "base/guid.h"
+#include "base/location.h"
 #include "base/logging.h"
+#include "base/single_thread_task_runner.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/net_errors.h"
 #include "net/socket/stream_socket.h"
@@ -19,13 +22,24 @@
 using namespace xwalk::jsapi::tcp_server_socket; // NOLINT
 using namespace xwalk::jsapi::raw_socket; // NOLINT
 
+namespace {
+
+const int kDefaultBacklog = 128;
+
+// How long to wait before accepting again after an error.
+const int kAcceptRetryDelayMs = 100;
+
+}  // namespace
+
 namespace xwalk {
 namespace sysapps {
 
 TCPServerSocketObject::TCPServerSocketObject(RawSocketInstance* instance)
   : is_suspended_(false),
     is_accepting_(false),
-    instance_(instance) {
+    counters_(new TCPConnectionCounters),
+    instance_(instance),
+    weak_factory_(this) {
   handler_.Register("init",
       base::Bind(&TCPServerSocketObject::OnInit, base::Unretained(this)));
   handler_.Register("_close",
@@ -34,14 +48,79 @@ TCPServerSocketObject::TCPServerSocketObject(RawSocketInstance* instance)
       base::Bind(&TCPServerSocketObject::OnSuspend, base::Unretained(this)));
   handler_.Register("resume",
       base::Bind(&TCPServerSocketObject::OnResume, base::Unretained(this)));
+  handler_.Register("getStats",
+      base::Bind(&TCPServerSocketObject::OnGetStats, base::Unretained(this)));
 }
 
 TCPServerSocketObject::~TCPServerSocketObject() {}
 
 void TCPServerSocketObject::DoAccept() {
-  socket_->Accept(&accepted_socket_,
-                  base::Bind(&TCPServerSocketObject::OnAccept,
-                             base::Unretained(this)));
+  while (socket_) {
+    int ret = socket_->Accept(&accepted_socket_,
+                              base::Bind(&TCPServerSocketObject::OnAccept,
+                                         base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING)
+      return;
+
+    DidAccept(ret);
+    if (ret != net::OK) {
+      DoAcceptLater();
+      return;
+    }
+  }
+}
+
+void TCPServerSocketObject::DoAcceptLater() {
+  // Errors like running out of file descriptors would just repeat
+  // right away and spin the thread, back off before trying again.
+  base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+      FROM_HERE, base::Bind(&TCPServerSocketObject::DoAccept,
+                            weak_factory_.GetWeakPtr()),
+      base::TimeDelta::FromMilliseconds(kAcceptRetryDelayMs));
+}
+
+void TCPServerSocketObject::DidAccept(int status) {
+  if (status != net::OK) {
+    LOG(WARNING) << "Accept failed: " << net::ErrorToString(status);
+    ++counters_->accept_errors;
+    return;
+  }
+
+  // The spec is not really clear about what to do when we get a incoming
+  // connection but nobody is listening. We are just closing the socket in
+  // this case.
+  if (!is_accepting_ || is_suspended_) {
+    ++counters_->refused;
+    accepted_socket_.reset();
+    return;
+  }
+
+  net::IPEndPoint local_address;
+  accepted_socket_->GetLocalAddress(&local_address);
+
+  jsapi::tcp_socket::TCPOptions options;
+  options.local_address = local_address.ToStringWithoutPort();
+  options.local_port = local_address.port();
+  options.address_reuse = false;
+  options.no_delay = true;
+  options.use_secure_transport = false;
+
+  ++counters_->accepted;
+  ++counters_->active;
+
+  std::unique_ptr<BindingObject> obj(new TCPSocketObject(
+                          std::move(accepted_socket_), counters_));
+  int object_id = instance_->AddBindingObject(std::move(obj));
+
+  std::unique_ptr<base::ListValue> dataList(new base::ListValue);
+  dataList->AppendInteger(object_id);
+  dataList->Append(options.ToValue().release());
+
+  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->Append(dataList.release());
+
+  DispatchEvent("connect", std::move(eventData));
 }
 
 void TCPServerSocketObject::StartEvent(const std::string& type) {
@@ -73,10 +152,21 @@ void TCPServerSocketObject::OnInit(
     return;
   }
 
+  // Only the client side of TLS is implemented.
+  if (params->options.use_secure_transport) {
+    LOG(WARNING) << "useSecureTransport is not supported by TCPServerSocket";
+    setReadyState(READY_STATE_CLOSED);
+    DispatchEvent("error");
+    return;
+  }
+
+  int backlog = params->options.backlog > 0 ? params->options.backlog
+                                             : kDefaultBacklog;
+
   socket_.reset(new net::TCPServerSocket(NULL, net::NetLogSource()));
   net::IPEndPoint address(ip_number, params->options.local_port);
 
-  if (socket_->Listen(address, 5) != net::OK) {
+  if (socket_->Listen(address, backlog) != net::OK) {
     LOG(WARNING) << "Failed to listen on " << params->options.local_address
         << " port " << params->options.local_port;
     setReadyState(READY_STATE_CLOSED);
@@ -108,39 +198,29 @@ void TCPServerSocketObject::OnResume(
   is_suspended_ = false;
 }
 
-void TCPServerSocketObject::OnAccept(int status) {
-  if (is_accepting_ && !is_suspended_) {
-    net::IPEndPoint local_address;
-    accepted_socket_->GetLocalAddress(&local_address);
-
-    jsapi::tcp_socket::TCPOptions options;
-    options.local_address = local_address.ToStringWithoutPort();
-    options.local_port = local_address.port();
-    options.address_reuse = false;
-    options.no_delay = true;
-    options.use_secure_transport = false;
-
-    std::string object_id = base::GenerateGUID();
-    std::unique_ptr<BindingObject> obj(new TCPSocketObject(
-                            std::move(accepted_socket_)));
-    instance_->AddBindingObject(object_id, std::move(obj));
-
-    std::unique_ptr<base::ListValue> dataList(new base::ListValue);
-    dataList->AppendString(object_id);
-    dataList->Append(options.ToValue().release());
-
-    std::unique_ptr<base::ListValue> eventData(new base::ListValue);
-    eventData->Append(dataList.release());
-
-    DispatchEvent("connect", std::move(eventData));
-  } else {
-    // The spec is not really clear about what to do when we get a incoming
-    // connection but nobody is listening. We are just closing the socket in
-    // this case.
-    accepted_socket_.reset();
-  }
+void TCPServerSocketObject::OnGetStats(
+    std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  TCPServerStats stats;
+  stats.accepted = static_cast<double>(counters_->accepted);
+  stats.refused = static_cast<double>(counters_->refused);
+  stats.accept_errors = static_cast<double>(counters_->accept_errors);
+  stats.active = static_cast<double>(counters_->active);
+  stats.bytes_received = static_cast<double>(counters_->bytes_received);
+  stats.bytes_sent = static_cast<double>(counters_->bytes_sent);
+
+  std::unique_ptr<base::ListValue> result(new base::ListValue());
+  result->Append(stats.ToValue());  // Data.
+  result->AppendString("");  // Error, empty == no error.
+
+  info->PostResult(std::move(result));
+}
 
-  DoAccept();
+void TCPServerSocketObject::OnAccept(int status) {
+  DidAccept(status);
+  if (status == net::OK)
+    DoAccept();
+  else
+    DoAcceptLater();
 }
 
 }  // namespace sysapps
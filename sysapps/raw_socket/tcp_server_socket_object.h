@@ -6,10 +6,12 @@
 #define XWALK_SYSAPPS_RAW_SOCKET_TCP_SERVER_SOCKET_OBJECT_H_
 
 #include <string>
+#include "base/memory/weak_ptr.h"
 #include "net/socket/tcp_server_socket.h"
 #include "xwalk/sysapps/common/event_target.h"
 #include "xwalk/sysapps/raw_socket/raw_socket_extension.h"
 #include "xwalk/sysapps/raw_socket/raw_socket_object.h"
+#include "xwalk/sysapps/raw_socket/tcp_socket_object.h"
 
 namespace xwalk {
 namespace sysapps {
@@ -22,7 +24,11 @@ class TCPServerSocketObject : public RawSocketObject {
   ~TCPServerSocketObject() override;
 
  private:
+  // Accepts every pending connection.
   void DoAccept();
+  // Calls DoAccept() after a delay, when accepting failed.
+  void DoAcceptLater();
+  void DidAccept(int status);
 
   // EventTarget implementation.
   void StartEvent(const std::string& type) override;
@@ -33,6 +39,7 @@ class TCPServerSocketObject : public RawSocketObject {
   void OnClose(std::unique_ptr<XWalkExtensionFunctionInfo> info);
   void OnSuspend(std::unique_ptr<XWalkExtensionFunctionInfo> info);
   void OnResume(std::unique_ptr<XWalkExtensionFunctionInfo> info);
+  void OnGetStats(std::unique_ptr<XWalkExtensionFunctionInfo> info);
 
   // net::TCPServerSocket callbacks.
   void OnAccept(int status);
@@ -43,7 +50,11 @@ class TCPServerSocketObject : public RawSocketObject {
   std::unique_ptr<net::TCPServerSocket> socket_;
   std::unique_ptr<net::StreamSocket> accepted_socket_;
 
+  scoped_refptr<TCPConnectionCounters> counters_;
+
   RawSocketInstance* instance_;
+
+  base::WeakPtrFactory<TCPServerSocketObject> weak_factory_;
 };
 
 }  // namespace sysapps
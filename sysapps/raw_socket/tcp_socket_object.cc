@@ -4,11 +4,23 @@
 
 #include "xwalk/sysapps/raw_socket/tcp_socket_object.h"
 
-#include <string.h>
+#include <algorithm>
+#include <string>
+#include <utility>
+
 #include "base/logging.h"
 #include "base/numerics/safe_conversions.h"
 #include "net/base/net_errors.h"
+#include "net/cert/cert_verifier.h"
+#include "net/cert/ct_policy_enforcer.h"
+#include "net/cert/multi_log_ct_verifier.h"
+#include "net/http/transport_security_state.h"
 #include "net/log/net_log_source.h"
+#include "net/socket/client_socket_factory.h"
+#include "net/socket/client_socket_handle.h"
+#include "net/socket/ssl_client_socket.h"
+#include "net/ssl/ssl_config.h"
+#include "net/ssl/ssl_info.h"
 #include "xwalk/sysapps/raw_socket/tcp_socket.h"
 
 using namespace xwalk::jsapi::tcp_socket; // NOLINT
@@ -16,34 +28,89 @@ using namespace xwalk::jsapi::raw_socket; // NOLINT
 
 namespace {
 
-const size_t kBufferSize = 4096;
+const int kMinReadBufferSize = 4 * 1024;
+const int kMaxReadBufferSize = 256 * 1024;
+
+// Reads are coalesced into a single "data" event up to this size.
+const size_t kMaxDataEventSize = 256 * 1024;
+
+const size_t kDefaultReadHighWaterMark = 1024 * 1024;
+
+const char kSSLSessionCacheShard[] = "xwalk_raw_socket";
 
 }  // namespace
 
 namespace xwalk {
 namespace sysapps {
 
-TCPSocketObject::TCPSocketObject()
+TCPConnectionCounters::TCPConnectionCounters()
+    : accepted(0),
+      refused(0),
+      accept_errors(0),
+      active(0),
+      bytes_received(0),
+      bytes_sent(0) {}
+
+TCPConnectionCounters::~TCPConnectionCounters() {}
+
+TLSClientContext::TLSClientContext() {}
+
+TLSClientContext::~TLSClientContext() {}
+
+net::SSLClientSocketContext TLSClientContext::GetSSLClientSocketContext() {
+  if (!cert_verifier_) {
+    cert_verifier_ = net::CertVerifier::CreateDefault();
+    transport_security_state_.reset(new net::TransportSecurityState);
+    cert_transparency_verifier_.reset(new net::MultiLogCTVerifier);
+    ct_policy_enforcer_.reset(new net::CTPolicyEnforcer);
+  }
+
+  return net::SSLClientSocketContext(cert_verifier_.get(),
+                                     nullptr,
+                                     transport_security_state_.get(),
+                                     cert_transparency_verifier_.get(),
+                                     ct_policy_enforcer_.get(),
+                                     kSSLSessionCacheShard);
+}
+
+TCPSocketObject::TCPSocketObject(net::HostResolver* resolver,
+                                 scoped_refptr<TLSClientContext> tls_context)
     : has_write_pending_(false),
+      has_read_pending_(false),
       is_suspended_(false),
       is_half_closed_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
-      resolver_(net::HostResolver::CreateDefaultResolver(NULL)) {
+      use_secure_transport_(false),
+      is_secure_(false),
+      tls_context_(tls_context),
+      read_buffer_(new net::IOBuffer(kMinReadBufferSize)),
+      read_buffer_size_(kMinReadBufferSize),
+      unacked_read_bytes_(0),
+      read_high_water_mark_(kDefaultReadHighWaterMark),
+      resolver_(resolver) {
   RegisterHandlers();
 }
 
-TCPSocketObject::TCPSocketObject(std::unique_ptr<net::StreamSocket> socket)
+TCPSocketObject::TCPSocketObject(std::unique_ptr<net::StreamSocket> socket,
+                                 scoped_refptr<TCPConnectionCounters> counters)
     : has_write_pending_(false),
+      has_read_pending_(false),
       is_suspended_(false),
       is_half_closed_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
-      socket_(socket.release()) {
+      use_secure_transport_(false),
+      is_secure_(false),
+      read_buffer_(new net::IOBuffer(kMinReadBufferSize)),
+      read_buffer_size_(kMinReadBufferSize),
+      unacked_read_bytes_(0),
+      read_high_water_mark_(kDefaultReadHighWaterMark),
+      socket_(socket.release()),
+      counters_(counters),
+      resolver_(nullptr) {
   RegisterHandlers();
 }
 
-TCPSocketObject::~TCPSocketObject() {}
+TCPSocketObject::~TCPSocketObject() {
+  DidClose();
+}
 
 void TCPSocketObject::RegisterHandlers() {
   handler_.Register("init",
@@ -56,30 +123,212 @@ void TCPSocketObject::RegisterHandlers() {
       base::Bind(&TCPSocketObject::OnSuspend, base::Unretained(this)));
   handler_.Register("resume",
       base::Bind(&TCPSocketObject::OnResume, base::Unretained(this)));
+  handler_.Register("_ackData",
+      base::Bind(&TCPSocketObject::OnAckData, base::Unretained(this)));
   handler_.Register("_sendString",
       base::Bind(&TCPSocketObject::OnSendString, base::Unretained(this)));
+  handler_.Register("_sendArrayBuffer",
+      base::Bind(&TCPSocketObject::OnSendArrayBuffer, base::Unretained(this)));
+  handler_.Register("getSecurityInfo",
+      base::Bind(&TCPSocketObject::OnGetSecurityInfo, base::Unretained(this)));
 }
 
 void TCPSocketObject::DoRead() {
-  if (!socket_->IsConnected())
+  while (CanRead()) {
+    int ret = socket_->Read(read_buffer_.get(),
+                            read_buffer_size_,
+                            base::Bind(&TCPSocketObject::OnRead,
+                                       base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_read_pending_ = true;
+      break;
+    }
+
+    if (!DidRead(ret))
+      return;
+  }
+
+  if (!is_suspended_)
+    DispatchReadData();
+}
+
+bool TCPSocketObject::CanRead() const {
+  if (!socket_.get() || !socket_->IsConnected())
+    return false;
+
+  if (has_read_pending_ || is_suspended_)
+    return false;
+
+  return read_data_.size() < kMaxDataEventSize &&
+      unacked_read_bytes_ + read_data_.size() < read_high_water_mark_;
+}
+
+bool TCPSocketObject::DidRead(int status) {
+  // No data means the other side has disconnected
+  // the socket. Whatever was read so far is still
+  // delivered before the "close" event.
+  if (status <= 0) {
+    if (status < 0)
+      LOG(WARNING) << "Read failed: " << net::ErrorToString(status);
+
+    // Cancels a write still pending, its callback would find the queue
+    // cleared.
+    socket_->Disconnect();
+    DispatchReadData();
+    ClearWriteQueue();
+    DidClose();
+    setReadyState(READY_STATE_CLOSED);
+    DispatchEvent("close");
+    return false;
+  }
+
+  if (counters_)
+    counters_->bytes_received += status;
+
+  read_data_.insert(read_data_.end(),
+                    read_buffer_->data(), read_buffer_->data() + status);
+
+  if (status == read_buffer_size_ && read_buffer_size_ < kMaxReadBufferSize) {
+    read_buffer_size_ *= 2;
+    read_buffer_ = new net::IOBuffer(read_buffer_size_);
+  } else if (status < read_buffer_size_ / 4 &&
+             read_buffer_size_ > kMinReadBufferSize) {
+    read_buffer_size_ /= 2;
+    read_buffer_ = new net::IOBuffer(read_buffer_size_);
+  }
+
+  return true;
+}
+
+void TCPSocketObject::DispatchReadData() {
+  if (read_data_.empty())
+    return;
+
+  // Like any other event, data is dropped
+  // when nobody is listening to it.
+  if (IsEventActive("data")) {
+    unacked_read_bytes_ += read_data_.size();
+
+    std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+    eventData->Append(base::BinaryValue::CreateWithCopiedBuffer(
+        &read_data_[0], read_data_.size()));
+    DispatchEvent("data", std::move(eventData));
+  }
+
+  read_data_.clear();
+}
+
+void TCPSocketObject::StopEvent(const std::string& type) {
+  // The events still on their way won't be acknowledged.
+  if (type == "data") {
+    unacked_read_bytes_ = 0;
+    DoRead();
+  }
+}
+
+void TCPSocketObject::QueueWrite(net::IOBuffer* buffer, int size,
+                                 bool drain_requested) {
+  if (size)
+    write_queue_.push_back(new net::DrainableIOBuffer(buffer, size));
+  DidQueueData(size, drain_requested);
+  DoWrite();
+}
+
+void TCPSocketObject::DoWrite() {
+  if (!socket_.get() || !socket_->IsConnected())
     return;
 
-  int ret = socket_->Read(read_buffer_.get(),
-                          kBufferSize,
-                          base::Bind(&TCPSocketObject::OnRead,
-                                     base::Unretained(this)));
+  while (!has_write_pending_ && !write_queue_.empty()) {
+    net::DrainableIOBuffer* buffer = write_queue_.front().get();
+    int ret = socket_->Write(buffer,
+                             buffer->BytesRemaining(),
+                             base::Bind(&TCPSocketObject::OnWrite,
+                                        base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_write_pending_ = true;
+      return;
+    }
+
+    if (!DidWrite(ret))
+      return;
+  }
+}
+
+bool TCPSocketObject::DidWrite(int status) {
+  if (status < 0) {
+    LOG(WARNING) << "Write failed: " << net::ErrorToString(status);
+    socket_->Disconnect();
+    ClearWriteQueue();
+    DidClose();
+    setReadyState(READY_STATE_CLOSED);
+    DispatchEvent("error");
+    return false;
+  }
+
+  if (counters_)
+    counters_->bytes_sent += status;
+
+  net::DrainableIOBuffer* buffer = write_queue_.front().get();
+  buffer->DidConsume(status);
+  if (!buffer->BytesRemaining())
+    write_queue_.pop_front();
 
-  if (ret > 0)
-    OnRead(ret);
+  DidWriteData(status);
+  return true;
+}
+
+void TCPSocketObject::ClearWriteQueue() {
+  has_write_pending_ = false;
+  write_queue_.clear();
+  DidDropQueuedData();
+}
+
+void TCPSocketObject::DidClose() {
+  if (!counters_)
+    return;
+
+  DCHECK_GT(counters_->active, 0u);
+  --counters_->active;
+  counters_ = nullptr;
+}
+
+void TCPSocketObject::ConnectSecureTransport() {
+  DCHECK(tls_context_);
+  is_secure_ = true;
+
+  std::unique_ptr<net::ClientSocketHandle> handle(new net::ClientSocketHandle);
+  handle->SetSocket(std::move(socket_));
+
+  net::ClientSocketFactory* factory =
+      net::ClientSocketFactory::GetDefaultFactory();
+  socket_ = factory->CreateSSLClientSocket(
+      std::move(handle), host_port_pair_, net::SSLConfig(),
+      tls_context_->GetSSLClientSocketContext());
+
+  int ret = socket_->Connect(base::Bind(&TCPSocketObject::OnConnect,
+                                        base::Unretained(this)));
+  if (ret != net::ERR_IO_PENDING)
+    OnConnect(ret);
 }
 
 void TCPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  std::unique_ptr<Init::Params> params(Init::Params::Create(*info->arguments()));
+
+  if (params && params->options) {
+    if (params->options->high_water_mark > 0)
+      set_high_water_mark(params->options->high_water_mark);
+    if (params->options->read_high_water_mark > 0)
+      read_high_water_mark_ = params->options->read_high_water_mark;
+  }
+
+  // Sockets accepted by a TCPServerSocket are already connected.
   if (socket_.get()) {
     DoRead();
     return;
   }
 
-  std::unique_ptr<Init::Params> params(Init::Params::Create(*info->arguments()));
   if (!params) {
     LOG(WARNING) << "Malformed parameters passed to " << info->name();
     setReadyState(READY_STATE_CLOSED);
@@ -87,8 +336,12 @@ void TCPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
     return;
   }
 
-  net::HostResolver::RequestInfo request_info(
-      net::HostPortPair(params->remote_address, params->remote_port));
+  host_port_pair_ = net::HostPortPair(params->remote_address,
+                                     params->remote_port);
+  use_secure_transport_ =
+      params->options && params->options->use_secure_transport;
+
+  net::HostResolver::RequestInfo request_info(host_port_pair_);
 
   int ret = resolver_->Resolve(
       request_info, net::DEFAULT_PRIORITY, &addresses_,
@@ -105,6 +358,10 @@ void TCPSocketObject::OnClose(std::unique_ptr<XWalkExtensionFunctionInfo> info)
   if (socket_.get())
     socket_->Disconnect();
 
+  has_read_pending_ = false;
+  read_data_.clear();
+  ClearWriteQueue();
+  DidClose();
   setReadyState(READY_STATE_CLOSED);
   DispatchEvent("close");
 }
@@ -122,17 +379,30 @@ void TCPSocketObject::OnSuspend(std::unique_ptr<XWalkExtensionFunctionInfo> info
 }
 
 void TCPSocketObject::OnResume(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  if (!is_suspended_)
+    return;
+
   is_suspended_ = false;
+  DoRead();
 }
 
-void TCPSocketObject::OnSendString(
+void TCPSocketObject::OnAckData(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
-  if (is_half_closed_ || has_write_pending_)
-    return;
+  std::unique_ptr<AckData::Params>
+      params(AckData::Params::Create(*info->arguments()));
 
-  if (!socket_.get() || !socket_->IsConnected())
+  if (!params || params->size < 0) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
     return;
+  }
 
+  unacked_read_bytes_ -= std::min(static_cast<size_t>(params->size),
+                                  unacked_read_bytes_);
+  DoRead();
+}
+
+void TCPSocketObject::OnSendString(
+    std::unique_ptr<XWalkExtensionFunctionInfo> info) {
   std::unique_ptr<SendDOMString::Params>
       params(SendDOMString::Params::Create(*info->arguments()));
 
@@ -141,27 +411,67 @@ void TCPSocketObject::OnSendString(
     return;
   }
 
-  if (params->data.size() > kBufferSize) {
-    LOG(WARNING) << "Write data bigger than the write buffer.";
+  if (is_half_closed_) {
+    DidDiscardData(params->data.size());
     return;
   }
 
-  memcpy(write_buffer_->data(), params->data.data(), params->data.size());
+  bool drain_requested = params->request_drain && *params->request_drain;
+  int size = base::checked_cast<int>(params->data.size());
+  std::unique_ptr<std::string> data(new std::string);
+  data->swap(params->data);
+  scoped_refptr<net::StringIOBuffer> buffer(
+      new net::StringIOBuffer(std::move(data)));
+  QueueWrite(buffer.get(), size, drain_requested);
+}
 
-  int ret = socket_->Write(write_buffer_.get(),
-                           base::checked_cast<int>(params->data.size()),
-                           base::Bind(&TCPSocketObject::OnWrite,
-                                      base::Unretained(this)));
+void TCPSocketObject::OnSendArrayBuffer(
+    std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  std::unique_ptr<SendArrayBuffer::Params>
+      params(SendArrayBuffer::Params::Create(*info->arguments()));
 
-  if (ret == net::ERR_IO_PENDING)
-    has_write_pending_ = true;
-  else if (ret == static_cast<int>(params->data.size()))
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
     return;
-  else
-    socket_->Disconnect();
+  }
+
+  if (is_half_closed_) {
+    DidDiscardData(params->data.size());
+    return;
+  }
+
+  bool drain_requested = params->request_drain && *params->request_drain;
+  scoped_refptr<VectorIOBuffer> buffer(new VectorIOBuffer(&params->data));
+  QueueWrite(buffer.get(), buffer->size(), drain_requested);
+}
+
+void TCPSocketObject::OnGetSecurityInfo(
+    std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  TCPSecurityInfo security_info;
+  security_info.secure = false;
+  security_info.session_resumed = false;
+
+  net::SSLInfo ssl_info;
+  if (is_secure_ && socket_.get() && socket_->GetSSLInfo(&ssl_info)) {
+    security_info.secure = true;
+    security_info.session_resumed =
+        ssl_info.handshake_type == net::SSLInfo::HANDSHAKE_RESUME;
+  }
+
+  std::unique_ptr<base::ListValue> result(new base::ListValue());
+  result->Append(security_info.ToValue());  // Data.
+  result->AppendString("");  // Error, empty == no error.
+
+  info->PostResult(std::move(result));
 }
 
 void TCPSocketObject::OnConnect(int status) {
+  // The TCP connection is up, now the TLS handshake.
+  if (status == net::OK && use_secure_transport_ && !is_secure_) {
+    ConnectSecureTransport();
+    return;
+  }
+
   if (status == net::OK) {
     if (is_half_closed_)
       setReadyState(READY_STATE_HALFCLOSED);
@@ -170,41 +480,33 @@ void TCPSocketObject::OnConnect(int status) {
 
     DispatchEvent("open");
     DoRead();
+    DoWrite();
   } else {
+    ClearWriteQueue();
     setReadyState(READY_STATE_CLOSED);
     DispatchEvent("error");
   }
 }
 
 void TCPSocketObject::OnRead(int status) {
-  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
-
-  // No data means the other side has
-  // disconnected the socket.
-  if (status == 0) {
-    setReadyState(READY_STATE_CLOSED);
-    DispatchEvent("close", std::move(eventData));
-    return;
-  }
-
-  std::unique_ptr<base::Value> data(base::BinaryValue::CreateWithCopiedBuffer(
-      static_cast<char*>(read_buffer_->data()), status));
-
-  eventData->Append(data.release());
-
-  if (!is_suspended_)
-    DispatchEvent("data", std::move(eventData));
-
-  DoRead();
+  has_read_pending_ = false;
+  if (DidRead(status))
+    DoRead();
 }
 
 void TCPSocketObject::OnWrite(int status) {
   has_write_pending_ = false;
-  DispatchEvent("drain");
+  // The socket got closed meanwhile.
+  if (write_queue_.empty())
+    return;
+
+  if (DidWrite(status))
+    DoWrite();
 }
 
 void TCPSocketObject::OnResolved(int status) {
   if (status != net::OK) {
+    ClearWriteQueue();
     setReadyState(READY_STATE_CLOSED);
     DispatchEvent("error");
     return;
@@ -215,8 +517,10 @@ void TCPSocketObject::OnResolved(int status) {
                                          nullptr,
                                          net::NetLogSource()));
 
-  socket_->Connect(base::Bind(&TCPSocketObject::OnConnect,
-                              base::Unretained(this)));
+  int ret = socket_->Connect(base::Bind(&TCPSocketObject::OnConnect,
+                                        base::Unretained(this)));
+  if (ret != net::ERR_IO_PENDING)
+    OnConnect(ret);
 }
 
 }  // namespace sysapps
@@ -5,24 +5,105 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_TCP_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_TCP_SOCKET_OBJECT_H_
 
+#include <stdint.h>
+#include <deque>
 #include <string>
+#include <vector>
+#include "base/memory/ref_counted.h"
+#include "net/base/host_port_pair.h"
 #include "net/dns/host_resolver.h"
 #include "net/base/io_buffer.h"
 #include "net/socket/tcp_client_socket.h"
 #include "xwalk/sysapps/raw_socket/raw_socket_object.h"
 
+namespace net {
+class CertVerifier;
+class CTPolicyEnforcer;
+class CTVerifier;
+class TransportSecurityState;
+struct SSLClientSocketContext;
+}
+
 namespace xwalk {
 namespace sysapps {
 
+// Counters of a TCPServerSocket, updated by the sockets it accepted. These
+// can outlive the server.
+struct TCPConnectionCounters
+    : public base::RefCounted<TCPConnectionCounters> {
+  TCPConnectionCounters();
+
+  uint64_t accepted;
+  uint64_t refused;
+  uint64_t accept_errors;
+  uint64_t active;
+  uint64_t bytes_received;
+  uint64_t bytes_sent;
+
+ private:
+  friend class base::RefCounted<TCPConnectionCounters>;
+  ~TCPConnectionCounters();
+};
+
+// What the net stack needs to run TLS client sockets, shared by the sockets
+// of a RawSocketInstance and only set up once one of them asks for TLS. All
+// the sockets use the same session cache shard: connecting again to a host
+// resumes the TLS session instead of doing a full handshake.
+class TLSClientContext : public base::RefCounted<TLSClientContext> {
+ public:
+  TLSClientContext();
+
+  net::SSLClientSocketContext GetSSLClientSocketContext();
+
+ private:
+  friend class base::RefCounted<TLSClientContext>;
+  ~TLSClientContext();
+
+  std::unique_ptr<net::CertVerifier> cert_verifier_;
+  std::unique_ptr<net::TransportSecurityState> transport_security_state_;
+  std::unique_ptr<net::CTVerifier> cert_transparency_verifier_;
+  std::unique_ptr<net::CTPolicyEnforcer> ct_policy_enforcer_;
+
+  DISALLOW_COPY_AND_ASSIGN(TLSClientContext);
+};
+
 class TCPSocketObject : public RawSocketObject {
  public:
-  TCPSocketObject();
-  explicit TCPSocketObject(std::unique_ptr<net::StreamSocket> socket);
+  // |resolver| is shared with the other sockets and must outlive this one.
+  TCPSocketObject(net::HostResolver* resolver,
+                  scoped_refptr<TLSClientContext> tls_context);
+  // Wraps a socket accepted by a server, |counters| are the server's.
+  TCPSocketObject(std::unique_ptr<net::StreamSocket> socket,
+                  scoped_refptr<TCPConnectionCounters> counters);
   ~TCPSocketObject() override;
 
  private:
   void RegisterHandlers();
+
+  // Reads as long as data is readily available, up to one event worth of
+  // data, and dispatches it all as a single "data" event.
   void DoRead();
+  bool CanRead() const;
+  // Returns false if the socket got closed.
+  bool DidRead(int status);
+  void DispatchReadData();
+
+  // EventTarget implementation.
+  void StopEvent(const std::string& type) override;
+
+  // Queues |size| bytes from |buffer| and writes as much as possible.
+  void QueueWrite(net::IOBuffer* buffer, int size, bool drain_requested);
+  void DoWrite();
+  // Returns false if the write failed and the socket got closed.
+  bool DidWrite(int status);
+  void ClearWriteQueue();
+
+  // Called once the socket is closed, for whatever reason.
+  void DidClose();
+
+  // Runs the TLS handshake over the connected socket, OnConnect() is called
+  // again once done.
+  void ConnectSecureTransport();
 
   // JavaScript function handlers.
   void OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info);
@@ -30,7 +111,10 @@ class TCPSocketObject : public RawSocketObject {
   void OnHalfClose(std::unique_ptr<XWalkExtensionFunctionInfo> info);
   void OnSuspend(std::unique_ptr<XWalkExtensionFunctionInfo> info);
   void OnResume(std::unique_ptr<XWalkExtensionFunctionInfo> info);
+  void OnAckData(std::unique_ptr<XWalkExtensionFunctionInfo> info);
   void OnSendString(std::unique_ptr<XWalkExtensionFunctionInfo> info);
+  void OnSendArrayBuffer(std::unique_ptr<XWalkExtensionFunctionInfo> info);
+  void OnGetSecurityInfo(std::unique_ptr<XWalkExtensionFunctionInfo> info);
 
   // net::TCPClientSocket callbacks.
   void OnConnect(int status);
@@ -41,15 +125,40 @@ class TCPSocketObject : public RawSocketObject {
   void OnResolved(int status);
 
   bool has_write_pending_;
+  bool has_read_pending_;
   bool is_suspended_;
   bool is_half_closed_;
 
+  // Set when the socket was asked for TLS, and once |socket_| is replaced
+  // by the TLS client socket.
+  bool use_secure_transport_;
+  bool is_secure_;
+  net::HostPortPair host_port_pair_;
+  scoped_refptr<TLSClientContext> tls_context_;
+
+  // Grows while reads fill it and shrinks back when they don't.
   scoped_refptr<net::IOBuffer> read_buffer_;
-  scoped_refptr<net::IOBuffer> write_buffer_;
+  int read_buffer_size_;
+
+  // Data read but not dispatched yet, either because more reads are being
+  // coalesced with it or because the socket is suspended.
+  std::vector<char> read_data_;
+
+  // Bytes dispatched to JavaScript that it didn't acknowledge yet. Reading
+  // stops when they would go over |read_high_water_mark_|, so a slow page
+  // pushes back on the peer instead of piling up events.
+  size_t unacked_read_bytes_;
+  size_t read_high_water_mark_;
+
+  // Data waiting to be written, the front buffer might be partially written.
+  std::deque<scoped_refptr<net::DrainableIOBuffer>> write_queue_;
   std::unique_ptr<net::StreamSocket> socket_;
 
-  // Used for DNS request.
-  std::unique_ptr<net::HostResolver> resolver_;
+  // Only set for accepted sockets, until they get closed.
+  scoped_refptr<TCPConnectionCounters> counters_;
+
+  // Used for DNS request, not set for accepted sockets.
+  net::HostResolver* resolver_;
   std::unique_ptr<net::HostResolver::Request> request_;
   net::AddressList addresses_;
 };
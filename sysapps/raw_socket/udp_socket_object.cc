@@ -4,11 +4,15 @@
 
 #include "xwalk/sysapps/raw_socket/udp_socket_object.h"
 
-#include <algorithm>
 #include <string>
+#include <utility>
 
+#include "base/location.h"
 #include "base/logging.h"
 #include "base/numerics/safe_conversions.h"
+#include "base/single_thread_task_runner.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/values.h"
 #include "net/base/net_errors.h"
 #include "net/log/net_log_source.h"
 #include "xwalk/sysapps/raw_socket/udp_socket.h"
@@ -18,21 +22,122 @@ using namespace xwalk::jsapi::raw_socket; // NOLINT
 
 namespace {
 
-const size_t kBufferSize = 4096;
+// Large enough for any datagram.
+const int kBufferSize = 64 * 1024;
+
+// A batch is dispatched when it reaches either limit. The datagram count has
+// to fit the uint16_t sender indices.
+const size_t kMaxBatchDatagrams = 1024;
+const size_t kMaxBatchSize = 256 * 1024;
+
+// Receive errors caused by a single datagram, like the ICMP port unreachable
+// of a previous send. Unlike a stream, the socket is still usable.
+bool IsTransientReadError(int status) {
+  return status == net::ERR_CONNECTION_REFUSED ||
+         status == net::ERR_CONNECTION_RESET ||
+         status == net::ERR_ADDRESS_UNREACHABLE ||
+         status == net::ERR_MSG_TOO_BIG;
+}
+
+// The resolved destinations are reused for this long, then resolved again in
+// case the records changed. The cache is flushed when it grows too big.
+const int kEndPointCacheTTLSeconds = 60;
+const size_t kMaxCachedEndPoints = 256;
+
+std::unique_ptr<base::BinaryValue> CreateBinaryValue(const void* data,
+                                                     size_t size) {
+  return base::BinaryValue::CreateWithCopiedBuffer(
+      static_cast<const char*>(data), size);
+}
 
 }  // namespace
 
 namespace xwalk {
 namespace sysapps {
 
-UDPSocketObject::UDPSocketObject()
+UDPSocketObject::Datagram::Datagram()
+    : size(0),
+      remote_port(0) {}
+
+UDPSocketObject::Datagram::Datagram(const Datagram& other) = default;
+
+UDPSocketObject::Datagram::~Datagram() {}
+
+UDPSocketObject::MessageBatch::MessageBatch() {
+  Clear();
+}
+
+UDPSocketObject::MessageBatch::~MessageBatch() {}
+
+void UDPSocketObject::MessageBatch::Add(const char* data, int size,
+                                        const net::IPEndPoint& from) {
+  data_.insert(data_.end(), data, data + size);
+  offsets_.push_back(static_cast<uint32_t>(data_.size()));
+  ports_.push_back(from.port());
+
+  // Most batches come from a handful of senders, often a single one.
+  size_t index = addresses_.size();
+  if (!addresses_.empty() && addresses_.back() == from.address()) {
+    index = addresses_.size() - 1;
+  } else {
+    for (size_t i = 0; i < addresses_.size(); ++i) {
+      if (addresses_[i] == from.address()) {
+        index = i;
+        break;
+      }
+    }
+  }
+
+  if (index == addresses_.size())
+    addresses_.push_back(from.address());
+
+  address_indices_.push_back(static_cast<uint16_t>(index));
+}
+
+void UDPSocketObject::MessageBatch::Clear() {
+  data_.clear();
+  offsets_.assign(1, 0);
+  ports_.clear();
+  address_indices_.clear();
+  addresses_.clear();
+}
+
+bool UDPSocketObject::MessageBatch::full() const {
+  return ports_.size() >= kMaxBatchDatagrams || data_.size() >= kMaxBatchSize;
+}
+
+std::unique_ptr<base::DictionaryValue>
+UDPSocketObject::MessageBatch::ToValue() const {
+  std::unique_ptr<base::DictionaryValue> value(new base::DictionaryValue);
+  value->Set("data", CreateBinaryValue(data_.data(), data_.size()));
+  value->Set("offsets", CreateBinaryValue(
+      offsets_.data(), offsets_.size() * sizeof(uint32_t)));
+  value->Set("remotePorts", CreateBinaryValue(
+      ports_.data(), ports_.size() * sizeof(uint16_t)));
+  value->Set("remoteAddressIndices", CreateBinaryValue(
+      address_indices_.data(), address_indices_.size() * sizeof(uint16_t)));
+
+  std::unique_ptr<base::ListValue> addresses(new base::ListValue);
+  for (const net::IPAddress& address : addresses_)
+    addresses->AppendString(address.ToString());
+  value->Set("remoteAddresses", std::move(addresses));
+
+  return value;
+}
+
+UDPSocketObject::UDPSocketObject(net::HostResolver* resolver)
     : has_write_pending_(false),
+      has_read_pending_(false),
+      is_open_(false),
+      multicast_loopback_(false),
+      receive_buffer_size_(0),
+      send_buffer_size_(0),
+      multicast_time_to_live_(0),
       is_suspended_(false),
       is_reading_(false),
       read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_size_(0),
-      resolver_(net::HostResolver::CreateDefaultResolver(NULL)) {
+      resolver_(resolver),
+      weak_factory_(this) {
   handler_.Register("init",
       base::Bind(&UDPSocketObject::OnInit, base::Unretained(this)));
   handler_.Register("_close",
@@ -47,24 +152,240 @@ UDPSocketObject::UDPSocketObject()
       base::Bind(&UDPSocketObject::OnLeaveMulticast, base::Unretained(this)));
   handler_.Register("_sendString",
       base::Bind(&UDPSocketObject::OnSendString, base::Unretained(this)));
+  handler_.Register("_sendArrayBuffer",
+      base::Bind(&UDPSocketObject::OnSendArrayBuffer, base::Unretained(this)));
 }
 
 UDPSocketObject::~UDPSocketObject() {}
 
 void UDPSocketObject::DoRead() {
-  if (!socket_->is_connected())
+  if (!socket_ || !socket_->is_connected())
     return;
 
   is_reading_ = true;
 
-  int ret = socket_->RecvFrom(read_buffer_.get(),
-                              kBufferSize,
-                              &from_,
-                              base::Bind(&UDPSocketObject::OnRead,
-                                         base::Unretained(this)));
+  while (!has_read_pending_ && !read_batch_.full()) {
+    int ret = socket_->RecvFrom(read_buffer_.get(),
+                                kBufferSize,
+                                &from_,
+                                base::Bind(&UDPSocketObject::OnRead,
+                                           base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_read_pending_ = true;
+      break;
+    }
+
+    if (!DidRead(ret))
+      return;
+  }
+
+  DispatchMessageBatch();
+
+  // The batch filled up with datagrams still waiting, and there is no read
+  // pending to get them. Carry on once the rest of the thread had a chance
+  // to run.
+  if (!has_read_pending_) {
+    base::ThreadTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, base::Bind(&UDPSocketObject::DoRead,
+                              weak_factory_.GetWeakPtr()));
+  }
+}
+
+bool UDPSocketObject::DidRead(int status) {
+  if (status < 0) {
+    LOG(WARNING) << "Receive failed: " << net::ErrorToString(status);
+    if (IsTransientReadError(status))
+      return true;
+
+    DispatchMessageBatch();
+    setReadyState(READY_STATE_CLOSED);
+    DispatchEvent("close");
+    return false;
+  }
+
+  // Empty datagrams are valid, they are delivered like any other.
+  read_batch_.Add(read_buffer_->data(), status, from_);
+  return true;
+}
+
+void UDPSocketObject::DispatchMessageBatch() {
+  if (read_batch_.empty())
+    return;
+
+  // JavaScript splits the batch back into "message" events for the
+  // listeners that want one event per datagram.
+  const char* type = IsEventActive("messages") ? "messages" : "message";
+  if (!is_suspended_ && IsEventActive(type)) {
+    std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+    eventData->Append(read_batch_.ToValue());
+    DispatchEvent(type, std::move(eventData));
+  }
+
+  read_batch_.Clear();
+}
+
+void UDPSocketObject::QueueDatagram(const Datagram& datagram,
+                                    bool drain_requested) {
+  write_queue_.push_back(datagram);
+  DidQueueData(datagram.size, drain_requested);
+  DoWrite();
+}
+
+void UDPSocketObject::DoWrite() {
+  // Resolving would clash with the resolution of the remote address given
+  // at init, so datagrams sent before the socket is open wait for it.
+  if (!is_open_)
+    return;
+
+  while (!has_write_pending_ && !write_queue_.empty()) {
+    int ret = ResolveDestination();
+    if (ret == net::ERR_IO_PENDING) {
+      has_write_pending_ = true;
+      return;
+    }
+
+    if (ret != net::OK) {
+      DidSend(ret);
+      return;
+    }
+
+    ret = SendDatagram();
+    if (ret == net::ERR_IO_PENDING) {
+      has_write_pending_ = true;
+      return;
+    }
+
+    if (!DidSend(ret))
+      return;
+  }
+}
+
+int UDPSocketObject::ResolveDestination() {
+  Datagram& datagram = write_queue_.front();
+  if (datagram.remote_address.empty() || !datagram.remote_port) {
+    datagram.end_point = default_end_point_;
+    return net::OK;
+  }
+
+  net::HostPortPair destination(datagram.remote_address, datagram.remote_port);
+  std::map<net::HostPortPair, CachedEndPoint>::const_iterator it =
+      end_point_cache_.find(destination);
+  if (it != end_point_cache_.end() &&
+      it->second.expiration > base::TimeTicks::Now()) {
+    datagram.end_point = it->second.end_point;
+    return net::OK;
+  }
+
+  int ret = resolver_->Resolve(
+      net::HostResolver::RequestInfo(destination),
+      net::DEFAULT_PRIORITY,
+      &addresses_,
+      base::Bind(&UDPSocketObject::OnResolved,
+                 base::Unretained(this)),
+      &request_,
+      net::NetLogWithSource());
+
+  if (ret == net::OK)
+    DidResolveDestination();
+
+  return ret;
+}
+
+void UDPSocketObject::DidResolveDestination() {
+  if (addresses_.empty())
+    return;
+
+  Datagram& datagram = write_queue_.front();
+  datagram.end_point = addresses_.front();
+
+  if (end_point_cache_.size() >= kMaxCachedEndPoints)
+    end_point_cache_.clear();
+
+  CachedEndPoint& cached = end_point_cache_[net::HostPortPair(
+      datagram.remote_address, datagram.remote_port)];
+  cached.end_point = datagram.end_point;
+  cached.expiration = base::TimeTicks::Now() +
+      base::TimeDelta::FromSeconds(kEndPointCacheTTLSeconds);
+}
+
+int UDPSocketObject::SendDatagram() {
+  const Datagram& datagram = write_queue_.front();
+  if (datagram.end_point.address().empty())
+    return net::ERR_ADDRESS_INVALID;
+
+  if (!socket_->is_connected()) {
+    // If we are waiting for reads and the socket is not connected,
+    // it means the connection was closed.
+    if (is_reading_)
+      return net::ERR_CONNECTION_CLOSED;
+
+    int ret = OpenSocket(datagram.end_point.GetFamily());
+    if (ret == net::OK)
+      ret = socket_->Connect(datagram.end_point);
+    if (ret != net::OK)
+      return ret;
+  }
+
+  return socket_->SendTo(
+      datagram.buffer.get(),
+      datagram.size,
+      datagram.end_point,
+      base::Bind(&UDPSocketObject::OnWrite, base::Unretained(this)));
+}
+
+int UDPSocketObject::OpenSocket(net::AddressFamily address_family) {
+  int ret = socket_->Open(address_family);
+  if (ret != net::OK)
+    return ret;
+
+  if (receive_buffer_size_ > 0) {
+    ret = socket_->SetReceiveBufferSize(receive_buffer_size_);
+    if (ret != net::OK)
+      return ret;
+  }
+
+  if (send_buffer_size_ > 0) {
+    ret = socket_->SetSendBufferSize(send_buffer_size_);
+    if (ret != net::OK)
+      return ret;
+  }
+
+  if (multicast_time_to_live_ > 0) {
+    ret = socket_->SetMulticastTimeToLive(multicast_time_to_live_);
+    if (ret != net::OK)
+      return ret;
+  }
+
+  return socket_->SetMulticastLoopbackMode(multicast_loopback_);
+}
+
+bool UDPSocketObject::DidSend(int status) {
+  if (status < 0) {
+    LOG(WARNING) << "Send failed: " << net::ErrorToString(status);
+    socket_->Close();
+    is_open_ = false;
+    ClearWriteQueue();
+    setReadyState(READY_STATE_CLOSED);
+    DispatchEvent("error");
+    return false;
+  }
+
+  int size = write_queue_.front().size;
+  write_queue_.pop_front();
+  DidWriteData(size);
+
+  if (!is_reading_ && socket_->is_connected())
+    DoRead();
+
+  return true;
+}
 
-  if (ret > 0)
-    OnRead(ret);
+void UDPSocketObject::ClearWriteQueue() {
+  has_write_pending_ = false;
+  request_.reset();
+  write_queue_.clear();
+  DidDropQueuedData();
 }
 
 void UDPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
@@ -76,6 +397,9 @@ void UDPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
     return;
   }
 
+  if (params->options && params->options->high_water_mark > 0)
+    set_high_water_mark(params->options->high_water_mark);
+
   socket_.reset(new net::UDPSocket(net::DatagramSocket::DEFAULT_BIND,
                                    net::RandIntCallback(),
                                    NULL,
@@ -86,6 +410,11 @@ void UDPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
     return;
   }
 
+  multicast_loopback_ = params->options->loopback;
+  receive_buffer_size_ = params->options->receive_buffer_size;
+  send_buffer_size_ = params->options->send_buffer_size;
+  multicast_time_to_live_ = params->options->multicast_time_to_live;
+
   if (!params->options->local_address.empty()) {
     net::IPAddress ip_number;
     if (!net::ParseURLHostnameToAddress(params->options->local_address,
@@ -98,7 +427,7 @@ void UDPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
 
     const net::IPEndPoint end_point(ip_number, params->options->local_port);
 
-    if (socket_->Open(end_point.GetFamily()) != net::OK) {
+    if (OpenSocket(end_point.GetFamily()) != net::OK) {
       LOG(WARNING) << "Cannot open UDP socket";
       setReadyState(READY_STATE_CLOSED);
       DispatchEvent("error");
@@ -143,6 +472,10 @@ void UDPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
 }
 
 void UDPSocketObject::OnClose(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  has_read_pending_ = false;
+  read_batch_.Clear();
+  ClearWriteQueue();
+  is_open_ = false;
   socket_.reset();
 }
 
@@ -156,17 +489,57 @@ void UDPSocketObject::OnResume(std::unique_ptr<XWalkExtensionFunctionInfo> info)
 
 void UDPSocketObject::OnJoinMulticast(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  std::unique_ptr<JoinMulticast::Params>
+      params(JoinMulticast::Params::Create(*info->arguments()));
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    return;
+  }
+
+  net::IPAddress group;
+  if (!group.AssignFromIPLiteral(params->multicast_group_address)) {
+    LOG(WARNING) << "Invalid multicast group address "
+                 << params->multicast_group_address;
+    return;
+  }
+
+  // Only a socket bound to a local address can receive multicast.
+  int ret = net::ERR_SOCKET_NOT_CONNECTED;
+  if (socket_)
+    ret = socket_->JoinGroup(group);
+  if (ret != net::OK) {
+    LOG(WARNING) << "Can't join multicast group " << group.ToString() << ": "
+                 << net::ErrorToString(ret);
+  }
 }
 
 void UDPSocketObject::OnLeaveMulticast(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  std::unique_ptr<LeaveMulticast::Params>
+      params(LeaveMulticast::Params::Create(*info->arguments()));
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    return;
+  }
+
+  net::IPAddress group;
+  if (!group.AssignFromIPLiteral(params->multicast_group_address)) {
+    LOG(WARNING) << "Invalid multicast group address "
+                 << params->multicast_group_address;
+    return;
+  }
+
+  int ret = net::ERR_SOCKET_NOT_CONNECTED;
+  if (socket_)
+    ret = socket_->LeaveGroup(group);
+  if (ret != net::OK) {
+    LOG(WARNING) << "Can't leave multicast group " << group.ToString() << ": "
+                 << net::ErrorToString(ret);
+  }
 }
 
 void UDPSocketObject::OnSendString(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
-  if (!socket_ || has_write_pending_)
-    return;
-
   std::unique_ptr<SendDOMString::Params>
       params(SendDOMString::Params::Create(*info->arguments()));
   if (!params) {
@@ -174,67 +547,50 @@ void UDPSocketObject::OnSendString(
     return;
   }
 
-  if (params->data.size() > kBufferSize) {
-    LOG(WARNING) << "Write data bigger than the write buffer.";
-    return;
+  Datagram datagram;
+  datagram.size = base::checked_cast<int>(params->data.size());
+  std::unique_ptr<std::string> data(new std::string);
+  data->swap(params->data);
+  datagram.buffer = new net::StringIOBuffer(std::move(data));
+  if (params->remote_address && params->remote_port) {
+    datagram.remote_address = *params->remote_address;
+    datagram.remote_port = *params->remote_port;
   }
 
-  write_buffer_size_ = params->data.size();
-  memcpy(write_buffer_->data(), params->data.data(), write_buffer_size_);
+  QueueDatagram(datagram, params->request_drain && *params->request_drain);
+}
 
-  if (!params->remote_address || !*params->remote_port) {
-    OnSend(net::OK);
+void UDPSocketObject::OnSendArrayBuffer(
+    std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  std::unique_ptr<SendArrayBuffer::Params>
+      params(SendArrayBuffer::Params::Create(*info->arguments()));
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
     return;
   }
 
-  net::HostResolver::RequestInfo request_info(net::HostPortPair(
-      *params->remote_address, *params->remote_port));
-
-  int ret = resolver_->Resolve(
-      request_info,
-      net::DEFAULT_PRIORITY,
-      &addresses_,
-      base::Bind(&UDPSocketObject::OnSend,
-                 base::Unretained(this)),
-      &request_,
-      net::NetLogWithSource());
+  scoped_refptr<VectorIOBuffer> buffer(new VectorIOBuffer(&params->data));
+  Datagram datagram;
+  datagram.size = buffer->size();
+  datagram.buffer = buffer;
+  if (params->remote_address && params->remote_port) {
+    datagram.remote_address = *params->remote_address;
+    datagram.remote_port = *params->remote_port;
+  }
 
-  if (ret != net::ERR_IO_PENDING)
-    OnSend(ret);
-  else
-    has_write_pending_ = true;
+  QueueDatagram(datagram, params->request_drain && *params->request_drain);
 }
 
 void UDPSocketObject::OnRead(int status) {
-  // No data means the other side has
-  // disconnected the socket.
-  if (status == 0) {
-    setReadyState(READY_STATE_CLOSED);
-    DispatchEvent("close");
-    return;
-  }
-
-  std::unique_ptr<base::Value> data(base::BinaryValue::CreateWithCopiedBuffer(
-      static_cast<char*>(read_buffer_->data()), status));
-
-  UDPMessageEvent event;
-  std::string buffer_data(read_buffer_->data(), status);
-  std::copy(buffer_data.begin(), buffer_data.end(), back_inserter(event.data));
-  event.remote_port = from_.port();
-  event.remote_address = from_.ToStringWithoutPort();
-
-  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
-  eventData->Append(event.ToValue().release());
-
-  if (!is_suspended_)
-    DispatchEvent("message", std::move(eventData));
-
-  DoRead();
+  has_read_pending_ = false;
+  if (DidRead(status))
+    DoRead();
 }
 
 void UDPSocketObject::OnWrite(int status) {
   has_write_pending_ = false;
-  DispatchEvent("drain");
+  if (DidSend(status))
+    DoWrite();
 }
 
 void UDPSocketObject::OnConnectionOpen(int status) {
@@ -244,50 +600,32 @@ void UDPSocketObject::OnConnectionOpen(int status) {
     return;
   }
 
+  // Only set when init was given a remote address to resolve.
+  if (!addresses_.empty())
+    default_end_point_ = addresses_.front();
+
+  is_open_ = true;
   setReadyState(READY_STATE_OPEN);
   DispatchEvent("open");
+  DoWrite();
 }
 
-void UDPSocketObject::OnSend(int status) {
-  if (status != net::OK || addresses_.empty()) {
-    setReadyState(READY_STATE_CLOSED);
-    DispatchEvent("error");
+void UDPSocketObject::OnResolved(int status) {
+  has_write_pending_ = false;
+  if (status != net::OK) {
+    DidSend(status);
     return;
   }
 
-  if (!socket_->is_connected()) {
-    // If we are waiting for reads and the socket is not connected,
-    // it means the connection was closed.
-    if (is_reading_ ||
-        socket_->Open(addresses_[0].GetFamily()) != net::OK ||
-        socket_->Connect(addresses_[0]) != net::OK) {
-      setReadyState(READY_STATE_CLOSED);
-      DispatchEvent("error");
-      return;
-    }
-  }
-
-  int ret = socket_->SendTo(
-      write_buffer_.get(),
-      base::checked_cast<int>(write_buffer_size_),
-      addresses_[0],
-      base::Bind(&UDPSocketObject::OnWrite, base::Unretained(this)));
-
-  if (ret < net::OK) {
-    if (ret == net::ERR_IO_PENDING) {
-      has_write_pending_ = true;
-    } else {
-      socket_->Close();
-      setReadyState(READY_STATE_CLOSED);
-      DispatchEvent("close");
-      return;
-    }
-  } else {
-    has_write_pending_ = false;
+  DidResolveDestination();
+  int ret = SendDatagram();
+  if (ret == net::ERR_IO_PENDING) {
+    has_write_pending_ = true;
+    return;
   }
 
-  if (!is_reading_ && socket_->is_connected())
-    DoRead();
+  if (DidSend(ret))
+    DoWrite();
 }
 
 }  // namespace sysapps
@@ -5,10 +5,21 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_UDP_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_UDP_SOCKET_OBJECT_H_
 
+#include <stdint.h>
+#include <deque>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "base/macros.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
 #include "net/base/address_list.h"
+#include "net/base/host_port_pair.h"
 #include "net/base/io_buffer.h"
+#include "net/base/ip_address.h"
+#include "net/base/ip_endpoint.h"
 #include "net/dns/host_resolver.h"
 #include "net/socket/udp_socket.h"
 #include "xwalk/sysapps/raw_socket/raw_socket_object.h"
@@ -18,11 +29,81 @@ namespace sysapps {
 
 class UDPSocketObject : public RawSocketObject {
  public:
-  UDPSocketObject();
+  // |resolver| is shared with the other sockets and must outlive this one.
+  explicit UDPSocketObject(net::HostResolver* resolver);
   ~UDPSocketObject() override;
 
  private:
+  // Datagrams received during one wakeup, stored back to back in a single
+  // buffer with a table of offsets and senders. JavaScript gets the whole
+  // batch in one event.
+  class MessageBatch {
+   public:
+    MessageBatch();
+    ~MessageBatch();
+
+    void Add(const char* data, int size, const net::IPEndPoint& from);
+    void Clear();
+
+    bool empty() const { return ports_.empty(); }
+    bool full() const;
+
+    // The offsets, ports and sender indices are typed arrays in JavaScript,
+    // sent as binary values in the host byte order.
+    std::unique_ptr<base::DictionaryValue> ToValue() const;
+
+   private:
+    std::vector<char> data_;
+    std::vector<uint32_t> offsets_;
+    std::vector<uint16_t> ports_;
+    std::vector<uint16_t> address_indices_;
+    std::vector<net::IPAddress> addresses_;
+
+    DISALLOW_COPY_AND_ASSIGN(MessageBatch);
+  };
+
+  // Receives every datagram readily available, up to a full batch, and
+  // dispatches them all at once.
   void DoRead();
+  // Returns false if the socket got closed.
+  bool DidRead(int status);
+  void DispatchMessageBatch();
+
+  // Datagrams are sent one at a time, in the order they were queued. Each
+  // one might need to resolve its destination first.
+  struct Datagram {
+    Datagram();
+    Datagram(const Datagram& other);
+    ~Datagram();
+
+    scoped_refptr<net::IOBuffer> buffer;
+    int size;
+    std::string remote_address;
+    int remote_port;
+    // Set once the destination is known.
+    net::IPEndPoint end_point;
+  };
+
+  // A destination resolved recently, so sending more datagrams to it
+  // doesn't involve the resolver at all.
+  struct CachedEndPoint {
+    net::IPEndPoint end_point;
+    base::TimeTicks expiration;
+  };
+
+  void QueueDatagram(const Datagram& datagram, bool drain_requested);
+  void DoWrite();
+  // Sets the end point of the datagram at the front of the queue, from the
+  // cache when possible. Might return net::ERR_IO_PENDING.
+  int ResolveDestination();
+  void DidResolveDestination();
+  int SendDatagram();
+  // Opens the socket and applies the options given at init, which must be
+  // done before it gets bound or connected.
+  int OpenSocket(net::AddressFamily address_family);
+  // Returns false if the send failed and the socket got closed.
+  bool DidSend(int status);
+  void ClearWriteQueue();
 
   // JavaScript function handlers.
   void OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info);
@@ -32,6 +113,7 @@ class UDPSocketObject : public RawSocketObject {
   void OnJoinMulticast(std::unique_ptr<XWalkExtensionFunctionInfo> info);
   void OnLeaveMulticast(std::unique_ptr<XWalkExtensionFunctionInfo> info);
   void OnSendString(std::unique_ptr<XWalkExtensionFunctionInfo> info);
+  void OnSendArrayBuffer(std::unique_ptr<XWalkExtensionFunctionInfo> info);
 
   // net::UDPSocket callbacks.
   void OnRead(int status);
@@ -39,22 +121,34 @@ class UDPSocketObject : public RawSocketObject {
 
   // net::SingleRequestHostResolver callbacks.
   void OnConnectionOpen(int status);
-  void OnSend(int status);
+  void OnResolved(int status);
 
   bool has_write_pending_;
+  bool has_read_pending_;
+  bool is_open_;
+  bool multicast_loopback_;
+  int receive_buffer_size_;
+  int send_buffer_size_;
+  int multicast_time_to_live_;
   bool is_suspended_;
   bool is_reading_;
 
   scoped_refptr<net::IOBuffer> read_buffer_;
-  scoped_refptr<net::IOBuffer> write_buffer_;
+  MessageBatch read_batch_;
   std::unique_ptr<net::UDPSocket> socket_;
 
-  size_t write_buffer_size_;
+  std::deque<Datagram> write_queue_;
+
+  // Where the datagrams sent without an address go, given at init.
+  net::IPEndPoint default_end_point_;
+  std::map<net::HostPortPair, CachedEndPoint> end_point_cache_;
 
-  std::unique_ptr<net::HostResolver> resolver_;
+  net::HostResolver* resolver_;
   std::unique_ptr<net::HostResolver::Request> request_;
   net::AddressList addresses_;
   net::IPEndPoint from_;
+
+  base::WeakPtrFactory<UDPSocketObject> weak_factory_;
 };
 
 }  // namespace sysapps
@@ -21,6 +21,8 @@
       ],
       'sources': [
         'common/binding_object.h',
+        'common/binding_object_map.cc',
+        'common/binding_object_map.h',
         'common/binding_object_store.cc',
         'common/binding_object_store.h',
         'common/common.idl',
@@ -12,6 +12,7 @@
         'sysapps.gyp:sysapps',
       ],
       'sources': [
+        'common/binding_object_map_unittest.cc',
         'common/binding_object_store_unittest.cc',
         'common/event_target_unittest.cc',
         'common/sysapps_manager_unittest.cc',
@@ -31,6 +32,7 @@
         '../../base/base.gyp:base',
         '../../content/content_shell_and_tests.gyp:test_support_content',
         '../../net/net.gyp:net',
+        '../../net/net.gyp:net_test_support',
         '../../skia/skia.gyp:skia',
         '../../testing/gtest.gyp:gtest',
         '../extensions/extensions.gyp:xwalk_extensions',